@@ -26,6 +26,8 @@
 ===========================================================================**/
 
 #include "units/nCore.h"
+#include "units/nAnalysisCache.h"
+#include "units/nAnalysisFile.h"
 #include "units/fftw_interface.h"
 #include "units/nFFT.h"
 #include "units/nFillFFT.h"
@@ -38,6 +40,9 @@
 #include "units/nSGNS.h"
 #include "units/nShiftBlocks.h"
 #include "units/nSpreading.h"
+#include "units/nPerfCounters.h"
+#include "units/nStatsJSON.h"
+#include "units/nTrace.h"
 #include "units/nWav.h"
 
 class Init
@@ -61,13 +66,15 @@ public:
     {
         nWAV_Cleanup();
 
+        nAnalysisFile_Cleanup();
+
         nFillFFT_Cleanup();
 
         nSpreading_Cleanup();
 
         nSGNS_Cleanup();
 
-        nParameter_Cleanup();
+        nOutput_Cleanup();
 
         if (FFTW_Initialised())
         {
@@ -78,6 +85,8 @@ public:
             nFFT_Cleanup();
         }
 
+        nFFT_Float_Cleanup();
+
         nProcess_Cleanup();
     }
 };
@@ -98,6 +107,8 @@ int main(int32_t argc, char* argv[])
         }
         else
         {
+            nTrace_Init();            // before openWavIO starts the I/O threads.
+
             if (!openWavIO())
             {
                 lossyWAVError("Error initialising wavIO unit.", 0x11);
@@ -108,6 +119,8 @@ int main(int32_t argc, char* argv[])
                 lossyWAVError("Error initialising wavIO unit.", 0x11);
             }
 
+            nPerfCounters_Init();     // before nInitial_Setup, so any warning precedes the progress display.
+
             nInitial_Setup();
 
             nSpreading_Init();
@@ -120,6 +133,12 @@ int main(int32_t argc, char* argv[])
 
             nOutput_Init();
 
+            nAnalysisFile_Init();     // dependent on the settings string.
+
+            nAnalysisCache_Init();    // dependent on the settings string, inactive when replaying.
+
+            nStatsJSON_Init();
+
             if (!readNextNextCodecBlock())
             {
                 lossyWAVError("Error reading from input file.", 0x21);
@@ -136,12 +155,26 @@ int main(int32_t argc, char* argv[])
 
                 Global.first_codec_block = (AudioData.Size.Last == 0);
 
+                int64_t trace_codec_block = Trace_Start();
+
+                Perf_Start(PERF_STAGE_CODEC_BLOCK);
+
+                Perf_Start(PERF_STAGE_READ);
+
                 Shift_Codec_Blocks();
 
                 readNextNextCodecBlock();
 
+                Perf_Stop(PERF_STAGE_READ);
+
+                Trace_Stop("read", trace_codec_block, Global.blocks_processed - 1);
+
                 Process_This_Codec_Block();
 
+                int64_t trace_write = Trace_Start();
+
+                Perf_Start(PERF_STAGE_WRITE);
+
                 if (!writeNextBTRDcodecblock())
                 {
                     lossyWAVError("Error writing to output file.", 0x21);
@@ -154,13 +187,29 @@ int main(int32_t argc, char* argv[])
                         lossyWAVError("Error writing to correction file.", 0x22);
                     }
                 }
+
+                Perf_Stop(PERF_STAGE_WRITE);
+
+                Trace_Stop("write", trace_write, Global.blocks_processed - 1);
+
+                Perf_Stop(PERF_STAGE_CODEC_BLOCK);
+
+                Trace_Stop("codec-block", trace_codec_block, Global.blocks_processed - 1);
             }
 
+            nPerfCounters_Close();
+
+            nAnalysisFile_Close();
+
+            nAnalysisCache_Close();
+
             if (!closeWavIO())
             {
                 lossyWAVError("Error closing wavIO unit.", 0x11);
             }
 
+            nTrace_Close();
+
             write_cleanup();
         }
     }
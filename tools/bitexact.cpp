@@ -0,0 +1,511 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    lossywav-bitexact: checks that lossyWAV output is bit for bit unchanged.
+
+    Runs a matrix of option sets (quality presets, --shaping variants,
+    --midside, --linkchannels, --feedback, --correction, ...) over a fixed
+    synthetic corpus and compares hashes of the lossy and correction data
+    chunks with the golden values recorded in tools/bitexact.golden for the
+    FFT in use ([I]nternal or [F]FTW build). Correction runs are also merged
+    back with -M, which must give the input's data chunk exactly (the 16 /
+    24 bit source of a float input). Each run also records a short
+    digest of every codec block and channel, so that a difference is
+    reported at the first codec block and channel that changed.
+
+    Usage: lossywav-bitexact [--golden <file>] [--update]
+
+    --update records the values of this build in the golden file, keeping
+    those of the other FFT. Exit code is 1 if any run differs, fails or has
+    no golden value (other than with --update).
+===========================================================================**/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../units/nCore.h"
+#include "../units/fftw_interface.h"
+#include "../units/nIO.h"
+#include "inprocess.h"
+#include "synthetic.h"
+
+struct tCorpus_Item
+{
+    const char* name;
+    int32_t     signal;
+    int32_t     sample_rate;
+    int32_t     channels;
+    int32_t     bits_per_sample;
+    double      seconds;
+    bool        ieee_float;         // bits_per_sample PCM converted to 32 bit IEEE float.
+};
+
+static const tCorpus_Item Corpus[] =
+{
+    {"pink16",     SIGNAL_PINK,     44100, 2, 16, 3.0, false},
+    {"sweep16",    SIGNAL_SWEEP,    44100, 2, 16, 3.0, false},
+    {"clipped16",  SIGNAL_CLIPPED,  44100, 2, 16, 3.0, false},
+    {"impulses16", SIGNAL_IMPULSES, 44100, 2, 16, 2.0, false},
+    {"mono16",     SIGNAL_PINK,     44100, 1, 16, 2.0, false},
+    {"pink24",     SIGNAL_PINK,     96000, 2, 24, 2.0, false},
+    {"pink6ch",    SIGNAL_PINK,     48000, 6, 16, 2.0, false},
+    {"float24",    SIGNAL_PINK,     44100, 2, 24, 2.0, true},
+    {"tone24",     SIGNAL_TONE,     44100, 2, 24, 2.0, false},
+};
+
+struct tCase
+{
+    const char* corpus;
+    const char* options;
+};
+
+static const tCase Matrix[] =
+{
+    {"pink16", ""}, {"sweep16", ""}, {"clipped16", ""}, {"impulses16", ""}, {"mono16", ""}, {"pink24", ""}, {"pink6ch", ""},
+    {"float24", ""}, {"tone24", ""}, {"tone24", "-q X"},
+
+    {"pink16", "-q I"}, {"pink16", "-q E"}, {"pink16", "-q H"}, {"pink16", "-q C"}, {"pink16", "-q P"}, {"pink16", "-q X"},
+    {"pink16", "-q 6.3"}, {"pink24", "-q X"}, {"clipped16", "-q X"},
+
+    {"pink16", "-s o"}, {"pink16", "-s f"}, {"pink16", "-s h"}, {"pink16", "-s a"}, {"pink16", "-s n"}, {"pink16", "-s c"},
+    {"pink16", "-s w"}, {"pink16", "-s s 0.5"}, {"pink16", "-s t 32"}, {"clipped16", "-s h"}, {"clipped16", "-s o"},
+
+    {"pink16", "-m"}, {"pink16", "--linkchannels"}, {"pink16", "-m --linkchannels"}, {"pink6ch", "--linkchannels"},
+
+    {"pink16", "--feedback"}, {"pink16", "--feedback 5"}, {"clipped16", "--feedback 10"}, {"pink16", "--feedback 5 -q X"},
+
+    {"pink16", "-C"}, {"pink16", "-C -q X"}, {"sweep16", "-C"}, {"pink24", "-C"}, {"pink6ch", "-C"}, {"clipped16", "-C --feedback 5"},
+    {"float24", "-C"},
+
+    {"pink16", "-a 7"}, {"pink16", "-A"}, {"pink16", "-U 4"}, {"pink16", "--scale 0.5"}, {"pink16", "-n"}, {"pink16", "--nodccorrect"},
+    {"pink16", "--analysis-precision float"}, {"tone24", "--analysis-precision float"},
+    {"pink16", "--analysis-precision compare"}, {"tone24", "--analysis-precision compare"}, {"pink6ch", "--analysis-precision compare"},
+};
+
+static const char DIGEST_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+struct tResult
+{
+    std::string lossy;
+    std::string correction;
+    std::string digest;
+    int32_t     channels = 0;
+    std::string merged = "-";       // data chunk hash after -M, for correction runs.
+};
+
+
+static uint64_t FNV_1a(uint64_t hash, const void* data, uint64_t bytes)
+{
+    const uint8_t* pB = (const uint8_t*) data;
+
+    for (uint64_t this_byte = 0; this_byte < bytes; ++this_byte)
+    {
+        hash ^= pB[this_byte];
+        hash *= 0x100000001B3uLL;
+    }
+
+    return hash;
+}
+
+
+//============================================================================
+// Hash of the data chunk of a RIFF WAVE image, "-" if there is none.
+//============================================================================
+static std::string Data_Chunk_Hash(const tIO_Memory& wav)
+{
+    const uint8_t* pB = wav.Data();
+    uint64_t position = 12;
+
+    while (position + 8 <= wav.Size())
+    {
+        uint64_t chunk_size = pB[position + 4] | (pB[position + 5] << 8) | (pB[position + 6] << 16) | (uint64_t(pB[position + 7]) << 24);
+
+        if (std::string((const char*) pB + position, 4) == "data")
+        {
+            std::ostringstream hash;
+            chunk_size = std::min(chunk_size, wav.Size() - position - 8);
+            hash << std::hex << std::setw(16) << std::setfill('0') << FNV_1a(0xCBF29CE484222325uLL, pB + position + 8, chunk_size);
+            return hash.str();
+        }
+
+        position += 8 + chunk_size + (chunk_size & 1);
+    }
+
+    return "-";
+}
+
+
+//============================================================================
+// Two characters (12 bits) per codec block and channel of the lossy and
+// correction samples.
+//============================================================================
+static void Add_Codec_Block_Digest(std::string& digest)
+{
+    for (int32_t this_channel = 0; this_channel < Global.Channels; ++this_channel)
+    {
+        uint64_t hash = 0xCBF29CE484222325uLL;
+
+        for (int32_t this_sample = 0; this_sample < AudioData.Size.This; ++this_sample)
+        {
+            hash = FNV_1a(hash, &AudioData.BTRDPTR[THIS_CODEC_BLOCK][this_channel][this_sample].Integers[0], sizeof(int32_t));
+
+            if (parameters.correction)
+                hash = FNV_1a(hash, &AudioData.CORRPTR[THIS_CODEC_BLOCK][this_channel][this_sample].Integers[0], sizeof(int32_t));
+        }
+
+        hash ^= hash >> 32;
+        hash ^= hash >> 16;
+
+        digest += DIGEST_CHARS[(hash >> 6) & 63];
+        digest += DIGEST_CHARS[hash & 63];
+    }
+}
+
+
+static const tCorpus_Item* Find_Corpus_Item(const std::string& name)
+{
+    for (const tCorpus_Item& this_item : Corpus)
+    {
+        if (name == this_item.name)
+            return &this_item;
+    }
+
+    return nullptr;
+}
+
+
+static std::vector<uint8_t> Corpus_WAV(const tCorpus_Item& this_item)
+{
+    std::vector<uint8_t> wav = Synthetic_WAV(this_item.signal, this_item.sample_rate, this_item.channels, this_item.bits_per_sample, this_item.seconds);
+
+    return this_item.ieee_float ? Float_WAV(wav) : wav;
+}
+
+
+static bool Write_File(const std::string& filename, const tIO_Memory& image)
+{
+    std::ofstream this_file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    this_file.write((const char*) image.Data(), std::streamsize(image.Size()));
+    this_file.close();
+
+    return !this_file.fail();
+}
+
+
+static std::string Case_Name(const tCase& this_case)
+{
+    return std::string(this_case.corpus) + ((this_case.options[0] != 0) ? " " : "") + this_case.options;
+}
+
+
+//============================================================================
+// Processes one case in a child process; the result comes back through a
+// temporary file as "lossy correction channels digest". The lossy and
+// correction files of a correction run are written to directory and merged
+// in a second child, as -M works on files.
+//============================================================================
+static bool Run_Bitexact_Case(const tCase& this_case, const std::string& directory, tResult& result)
+{
+    const tCorpus_Item* this_item = Find_Corpus_Item(this_case.corpus);
+    std::FILE* result_file = std::tmpfile();
+
+    if ((this_item == nullptr) || (result_file == nullptr))
+        return false;
+
+    bool succeeded = Run_In_Child([&]()
+    {
+        std::vector<uint8_t> wav = Corpus_WAV(*this_item);
+        tIO_Memory input(wav.data(), wav.size());
+        tIO_Memory lossy;
+        tIO_Memory correction;
+        std::vector<std::string> options = {"-f"};
+        std::istringstream option_words(this_case.options);
+        std::string this_word;
+        std::string digest;
+
+        while (option_words >> this_word)
+            options.push_back(this_word);
+
+        Open_Pipeline(options, &input, &lossy, &correction);
+
+        while (Process_Next_Codec_Block())
+            Add_Codec_Block_Digest(digest);
+
+        Close_Pipeline();
+
+        //============================================================================
+        // Compare runs use the double analysis, so their golden values are those of
+        // the same case without the option; their counters must cover every codec
+        // block and channel once (none of them uses -m).
+        //============================================================================
+        if ((parameters.fft.precision == ANALYSIS_PRECISION_COMPARE)
+            && ((process.Precision_Compare.Blocks * 2 != digest.size()) || (process.Precision_Compare.FFTs < process.Precision_Compare.Blocks)
+                || (process.Precision_Compare.Blocks_Differ > process.Precision_Compare.Blocks) || (process.Precision_Compare.FFTs_Differ > process.Precision_Compare.FFTs)))
+            lossyWAVError("Precision compare counters do not match the codec blocks processed.", 0x21);
+
+        if ((parameters.correction) && ((!Write_File(directory + "/case.lossy.wav", lossy)) || (!Write_File(directory + "/case.lwcdf.wav", correction))))
+            lossyWAVError("Error writing to output file.", 0x21);
+
+        std::string line = Data_Chunk_Hash(lossy) + " " + (parameters.correction ? Data_Chunk_Hash(correction) : std::string("-"))
+                         + " " + std::to_string(Global.Channels) + " " + digest + "\n";
+
+        std::fwrite(line.data(), 1, line.size(), result_file);
+        std::fflush(result_file);
+    });
+
+    std::rewind(result_file);
+
+    char buffer[65536];
+    std::string line;
+
+    while (std::fgets(buffer, sizeof(buffer), result_file) != nullptr)
+        line += buffer;
+
+    std::fclose(result_file);
+
+    std::istringstream fields(line);
+
+    if ((!succeeded) || (!(fields >> result.lossy >> result.correction >> result.channels >> result.digest)))
+        return false;
+
+    if (result.correction != "-")
+    {
+        const std::string merged_filename = directory + "/merged/case.wav";
+
+        succeeded = Run_In_Child([&]()
+        {
+            Merge_Files(directory + "/case.lossy.wav", directory + "/merged/");
+        });
+
+        std::ifstream merged_file(merged_filename.c_str(), std::ios::in | std::ios::binary);
+        std::vector<uint8_t> merged((std::istreambuf_iterator<char>(merged_file)), std::istreambuf_iterator<char>());
+
+        result.merged = succeeded ? Data_Chunk_Hash(tIO_Memory(merged.data(), merged.size())) : "FAILED";
+
+        std::remove((directory + "/case.lossy.wav").c_str());
+        std::remove((directory + "/case.lwcdf.wav").c_str());
+        std::remove(merged_filename.c_str());
+    }
+
+    return true;
+}
+
+
+//============================================================================
+// Golden values, keyed on "<case>\t<FFT>"; lines are
+// case <tab> FFT <tab> lossy <tab> correction <tab> channels <tab> digest.
+//============================================================================
+static std::map<std::string, tResult> Read_Golden(const std::string& filename)
+{
+    std::map<std::string, tResult> golden;
+    std::ifstream golden_file(filename.c_str());
+    std::string line;
+
+    while (std::getline(golden_file, line))
+    {
+        if ((line.empty()) || (line[0] == '#'))
+            continue;
+
+        std::vector<std::string> fields;
+        std::istringstream line_fields(line);
+        std::string this_field;
+
+        while (std::getline(line_fields, this_field, '\t'))
+            fields.push_back(this_field);
+
+        if (fields.size() != 6)
+            continue;
+
+        tResult& this_result = golden[fields[0] + "\t" + fields[1]];
+        this_result.lossy = fields[2];
+        this_result.correction = fields[3];
+        this_result.channels = std::atoi(fields[4].c_str());
+        this_result.digest = fields[5];
+    }
+
+    return golden;
+}
+
+
+static bool Write_Golden(const std::string& filename, const std::map<std::string, tResult>& golden)
+{
+    std::ofstream golden_file(filename.c_str(), std::ios::out | std::ios::trunc);
+
+    golden_file << "# lossywav-bitexact golden values, written by \"lossywav-bitexact --update\"." << std::endl
+                << "# case, FFT ([I]nternal or [F]FTW), lossy and correction data chunk hashes," << std::endl
+                << "# channels and two characters per codec block and channel." << std::endl;
+
+    for (const char* fft : {"I", "F"})
+    {
+        for (const tCase& this_case : Matrix)
+        {
+            auto found = golden.find(Case_Name(this_case) + "\t" + fft);
+
+            if (found != golden.end())
+            {
+                golden_file << Case_Name(this_case) << '\t' << fft << '\t' << found->second.lossy << '\t' << found->second.correction
+                            << '\t' << found->second.channels << '\t' << found->second.digest << std::endl;
+            }
+        }
+    }
+
+    golden_file.close();
+
+    return !golden_file.fail();
+}
+
+
+int main(int32_t argc, char* argv[])
+{
+    std::string golden_filename = "tools/bitexact.golden";
+    bool update = false;
+
+    for (int32_t this_arg = 1; this_arg < argc; ++this_arg)
+    {
+        std::string this_argument = argv[this_arg];
+
+        if ((this_argument == "--golden") && (this_arg + 1 < argc))
+            golden_filename = argv[++this_arg];
+        else if (this_argument == "--update")
+            update = true;
+        else
+        {
+            std::cerr << "Usage: lossywav-bitexact [--golden <file>] [--update]" << std::endl;
+            return 1;
+        }
+    }
+
+    FFTW_Initialise();
+
+    const std::string fft = FFTW_Initialised() ? "F" : "I";
+    std::map<std::string, tResult> golden = Read_Golden(golden_filename);
+
+    char directory_template[] = "/tmp/lossywav-bitexact-XXXXXX";
+    const std::string directory = (mkdtemp(directory_template) != nullptr) ? directory_template : "";
+
+    if ((directory.empty()) || (mkdir((directory + "/merged").c_str(), 0700) != 0))
+    {
+        std::cerr << "Cannot create a temporary directory." << std::endl;
+        return 1;
+    }
+
+    int32_t differ = 0;
+    int32_t failed = 0;
+    int32_t missing = 0;
+
+    for (const tCase& this_case : Matrix)
+    {
+        const std::string key = Case_Name(this_case) + "\t" + fft;
+        tResult result;
+
+        std::cout << std::left << std::setw(40) << Case_Name(this_case) << std::right << '[' << fft << "] ";
+
+        if (!Run_Bitexact_Case(this_case, directory, result))
+        {
+            std::cout << "FAILED" << std::endl;
+            ++ failed;
+            continue;
+        }
+
+        auto found = golden.find(key);
+
+        if (result.merged != "-")
+        {
+            const tCorpus_Item* this_item = Find_Corpus_Item(this_case.corpus);
+            std::vector<uint8_t> source = Synthetic_WAV(this_item->signal, this_item->sample_rate, this_item->channels, this_item->bits_per_sample, this_item->seconds);
+
+            if (result.merged != Data_Chunk_Hash(tIO_Memory(source.data(), source.size())))
+            {
+                std::cout << ((result.merged == "FAILED") ? "MERGE FAILED" : "DIFFERS from the input after merging") << std::endl;
+                ++ differ;
+                continue;
+            }
+        }
+
+        if (found == golden.end())
+        {
+            std::cout << (update ? "recorded" : "NO GOLDEN VALUE") << std::endl;
+
+            if (!update)
+                ++ missing;
+        }
+        else if ((found->second.lossy == result.lossy) && (found->second.correction == result.correction))
+        {
+            std::cout << "ok" << std::endl;
+        }
+        else
+        {
+            const std::string& expected = found->second.digest;
+            size_t first = 0;
+
+            while ((first < expected.size()) && (first < result.digest.size()) && (expected[first] == result.digest[first]))
+                ++ first;
+
+            if ((first == expected.size()) && (first == result.digest.size()))
+            {
+                std::cout << "DIFFERS outside the codec block samples (data chunk length or padding)" << std::endl;
+            }
+            else
+            {
+                int32_t position = int32_t(first / 2);
+                std::cout << "DIFFERS from codec block " << (position / std::max(1, result.channels)) << ", channel " << (position % std::max(1, result.channels))
+                          << ((found->second.lossy != result.lossy) ? "; lossy" : "") << ((found->second.correction != result.correction) ? "; correction" : "") << std::endl;
+            }
+
+            ++ differ;
+        }
+
+        if (update)
+            golden[key] = result;
+    }
+
+    rmdir((directory + "/merged").c_str());
+    rmdir(directory.c_str());
+
+    std::cout << std::endl << (sizeof(Matrix) / sizeof(Matrix[0])) << " runs: " << differ << " differ, " << failed << " failed, " << missing << " without golden values." << std::endl;
+
+    if (update)
+    {
+        if (!Write_Golden(golden_filename, golden))
+        {
+            std::cerr << "Cannot write " << golden_filename << std::endl;
+            return 1;
+        }
+
+        std::cout << "Golden values for [" << fft << "] written to " << golden_filename << "." << std::endl;
+        return (failed > 0) ? 1 : 0;
+    }
+
+    return ((differ + failed + missing) > 0) ? 1 : 0;
+}
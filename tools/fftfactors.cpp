@@ -0,0 +1,191 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    fftfactors: times each compile-time specialised forward FFT factorisation
+    (FFT_DIT_Factorisations in units/nFFT.cpp) for every FFT length from 32 to
+    8192 points on this machine and writes a replacement for
+    units/nFFT_Factors.h selecting the fastest one for each length.
+
+    Usage: fftfactors > fftfactors.h  (summary is written to stderr)
+===========================================================================**/
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "../units/nCore.h"
+#include "../units/nFFT.h"
+
+static const int32_t FIRST_FACTORISED_BIT_LENGTH = 5;
+static const int32_t TRIALS = 7;
+static const double TRIAL_SECONDS = 0.02;
+
+static tDComplex Bench_Data[1 << FFT_FACTORISED_MAX_BIT_LENGTH] __attribute__ ((aligned(16)));
+static tDComplex Reference_Data[1 << FFT_FACTORISED_MAX_BIT_LENGTH] __attribute__ ((aligned(16)));
+
+
+static void Fill_Bench_Data(int32_t bit_length)
+{
+    uint32_t seed = 0x12345678;
+
+    for (int32_t ff_i = 0; ff_i < (1 << bit_length); ++ff_i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        double re = (int32_t(seed >> 8) - 0x800000) * (1.0 / 0x800000);
+        seed = seed * 1664525 + 1013904223;
+        double im = (int32_t(seed >> 8) - 0x800000) * (1.0 / 0x800000);
+        Bench_Data[ff_i] = DComplex(re, im);
+    }
+}
+
+
+//============================================================================
+// Largest difference from the first factorisation, as a sanity check that all
+// candidates calculate the same transform.
+//============================================================================
+static double Check_Factorisation(int32_t factorisation, int32_t bit_length)
+{
+    FFT_Proc_Rec this_FFT_plan;
+    this_FFT_plan.NumberOfBitsNeeded = bit_length;
+    this_FFT_plan.DComplex = Bench_Data;
+
+    Fill_Bench_Data(bit_length);
+    FFT_DIT_Factorisations[0][bit_length](&this_FFT_plan);
+
+    for (int32_t ff_i = 0; ff_i < (1 << bit_length); ++ff_i)
+        Reference_Data[ff_i] = Bench_Data[ff_i];
+
+    Fill_Bench_Data(bit_length);
+    FFT_DIT_Factorisations[factorisation][bit_length](&this_FFT_plan);
+
+    double max_difference = 0;
+
+    for (int32_t ff_i = 0; ff_i < (1 << bit_length); ++ff_i)
+        max_difference = std::max(max_difference, (Bench_Data[ff_i] - Reference_Data[ff_i]).magnitude());
+
+    return max_difference;
+}
+
+
+//============================================================================
+// Best of TRIALS timings, in nanoseconds per FFT.
+//============================================================================
+static double Time_Factorisation(int32_t factorisation, int32_t bit_length)
+{
+    FFT_Proc_Rec this_FFT_plan;
+    this_FFT_plan.NumberOfBitsNeeded = bit_length;
+    this_FFT_plan.DComplex = Bench_Data;
+
+    void (* this_FFT)(FFT_Proc_Rec*) = FFT_DIT_Factorisations[factorisation][bit_length];
+
+    int64_t repeats = 1;
+    double best = 0;
+
+    for (int32_t trial = 0; trial < TRIALS; )
+    {
+        Fill_Bench_Data(bit_length);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int64_t repeat = 0; repeat < repeats; ++repeat)
+            this_FFT(&this_FFT_plan);
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (elapsed < TRIAL_SECONDS)
+        {
+            repeats <<= 1;
+            continue;
+        }
+
+        double this_time = elapsed * 1e9 / repeats;
+
+        if ((trial == 0) || (this_time < best))
+            best = this_time;
+
+        ++trial;
+    }
+
+    return best;
+}
+
+
+int main()
+{
+    nCore_Init();
+    nFFT_Init(FFT_FACTORISED_MAX_BIT_LENGTH);
+
+    int32_t fastest[FFT_FACTORISED_MAX_BIT_LENGTH + 1] = { 0 };
+
+    std::cerr << "FFT length";
+    for (int32_t factorisation = 0; factorisation < FFT_FACTORISATIONS; ++factorisation)
+        std::cerr << " | " << std::setw(10) << FFT_DIT_Factorisation_Names[factorisation];
+    std::cerr << " (ns per FFT)" << std::endl;
+
+    for (int32_t bit_length = FIRST_FACTORISED_BIT_LENGTH; bit_length <= FFT_FACTORISED_MAX_BIT_LENGTH; ++bit_length)
+    {
+        double best = 0;
+
+        std::cerr << std::setw(10) << (1 << bit_length);
+
+        for (int32_t factorisation = 0; factorisation < FFT_FACTORISATIONS; ++factorisation)
+        {
+            if (Check_Factorisation(factorisation, bit_length) > 1e-9)
+            {
+                std::cerr << std::endl << "Factorisation " << FFT_DIT_Factorisation_Names[factorisation] << " gives incorrect results at " << (1 << bit_length) << " points." << std::endl;
+                return 1;
+            }
+
+            double this_time = Time_Factorisation(factorisation, bit_length);
+
+            std::cerr << " | " << std::setw(10) << std::fixed << std::setprecision(1) << this_time;
+
+            if ((factorisation == 0) || (this_time < best))
+            {
+                best = this_time;
+                fastest[bit_length] = factorisation;
+            }
+        }
+
+        std::cerr << " -> " << FFT_DIT_Factorisation_Names[fastest[bit_length]] << std::endl;
+    }
+
+    std::cout << "//==============================================================================" << std::endl
+              << "// Forward FFT factorisation per bit length, an index into FFT_DIT_Factorisations" << std::endl
+              << "// (0 = radix 4 then 8, 1 = radix 4 then 2, 2 = radix 8 then 4)." << std::endl
+              << "//" << std::endl
+              << "// Generated by tools/fftfactors.cpp (\"make -f Makefile.unix fft-factors\")." << std::endl
+              << "//==============================================================================" << std::endl
+              << std::endl
+              << "#ifndef nFFT_Factors_h_" << std::endl
+              << "#define nFFT_Factors_h_" << std::endl
+              << std::endl
+              << "static const int32_t FFT_DIT_FACTORISATION[" << FFT_FACTORISED_MAX_BIT_LENGTH << " + 1] = { ";
+
+    for (int32_t bit_length = 0; bit_length <= FFT_FACTORISED_MAX_BIT_LENGTH; ++bit_length)
+        std::cout << fastest[bit_length] << ((bit_length < FFT_FACTORISED_MAX_BIT_LENGTH) ? ", " : " };");
+
+    std::cout << std::endl << std::endl << "#endif // nFFT_Factors_h_" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Runs lossyWAV inside the tools, see inprocess.h.
+===========================================================================**/
+
+#include <iostream>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "inprocess.h"
+#include "../units/fftw_interface.h"
+#include "../units/nFFT.h"
+#include "../units/nFillFFT.h"
+#include "../units/nInitialise.h"
+#include "../units/nOutput.h"
+#include "../units/nParameter.h"
+#include "../units/nProcess.h"
+#include "../units/nRemoveBits.h"
+#include "../units/nShiftBlocks.h"
+#include "../units/nSpreading.h"
+#include "../units/nWav.h"
+
+
+bool Discard_Output(void*, const void*, uint64_t)
+{
+    return true;
+}
+
+
+void Open_Pipeline(const std::vector<std::string>& options, tIO_Backend* input, tIO_Backend* lossy, tIO_Backend* correction)
+{
+    std::vector<std::string> arguments = {"lossywav", "-", "-S"};
+    arguments.insert(arguments.end(), options.begin(), options.end());
+
+    std::vector<char*> argv;
+
+    for (auto& this_argument : arguments)
+        argv.push_back(&this_argument[0]);
+
+    argv.push_back(nullptr);
+
+    nCore_Init();
+    nWAV_Init();
+    FFTW_Initialise();
+
+    if (!FFTW_Initialised())
+        nFFT_Init(MAX_FFT_BIT_LENGTH);
+
+    nParameter_Init(int32_t(arguments.size()), argv.data());
+    nCheck_Switches();
+
+    nWAV_Set_IO(input, lossy, correction);
+
+    if ((!openWavIO()) || (Global.Codec_Block.Size == 0))
+        lossyWAVError("Error initialising wavIO unit.", 0x11);
+
+    nInitial_Setup();
+    nSpreading_Init();
+    nProcess_Init();
+    nFillFFT_Init();
+    nRemoveBits_Init();
+    nOutput_Init();
+
+    if (!readNextNextCodecBlock())
+        lossyWAVError("Error reading from input file.", 0x21);
+
+    Global.blocks_processed = 0;
+}
+
+
+bool Process_Next_Codec_Block()
+{
+    if (AudioData.Size.Next == 0)
+        return false;
+
+    Global.last_codec_block = (AudioData.Size.Next == 0);
+    Global.first_codec_block = (AudioData.Size.Last == 0);
+
+    Shift_Codec_Blocks();
+    readNextNextCodecBlock();
+    Process_This_Codec_Block();
+
+    if (!writeNextBTRDcodecblock())
+        lossyWAVError("Error writing to output file.", 0x21);
+
+    if ((parameters.correction) && (!writeNextCORRcodecblock()))
+        lossyWAVError("Error writing to correction file.", 0x22);
+
+    return true;
+}
+
+
+void Close_Pipeline()
+{
+    if (!closeWavIO())
+        lossyWAVError("Error closing wavIO unit.", 0x11);
+}
+
+
+void Merge_Files(const std::string& lossy_filename, const std::string& output_directory)
+{
+    std::vector<std::string> arguments = {"lossywav", lossy_filename, "-M", "-S", "-o", output_directory};
+    std::vector<char*> argv;
+
+    for (auto& this_argument : arguments)
+        argv.push_back(&this_argument[0]);
+
+    argv.push_back(nullptr);
+
+    nCore_Init();
+    nWAV_Init();
+
+    nParameter_Init(int32_t(arguments.size()), argv.data());
+    nCheck_Switches();
+
+    MergeFiles();
+}
+
+
+bool Run_In_Child(const std::function<void()>& this_case)
+{
+    std::cout.flush();
+
+    pid_t child = fork();
+
+    if (child == 0)
+    {
+        int32_t exit_code = 0;
+
+        try
+        {
+            this_case();
+        }
+        catch (int32_t)
+        {
+            exit_code = 1;
+        }
+
+        std::cout.flush();
+        _exit(exit_code);
+    }
+
+    int status = 0;
+
+    return (child > 0) && (waitpid(child, &status, 0) == child) && (WIFEXITED(status)) && (WEXITSTATUS(status) == 0);
+}
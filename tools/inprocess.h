@@ -0,0 +1,58 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Runs lossyWAV inside the tools: the set up and main loop of lossyWAV.cpp
+    for one file read from and written to caller supplied I/O backends, the
+    -M merge of a lossy and correction file pair, and a way to run each such
+    file in its own process, as lossyWAV keeps its per-file state in globals.
+===========================================================================**/
+
+#ifndef inprocess_h_
+#define inprocess_h_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../units/nCore.h"
+#include "../units/nIO.h"
+
+bool Discard_Output(void* context, const void* buffpointer, uint64_t bytestowrite);    // tIO_Sink.
+
+void Open_Pipeline(const std::vector<std::string>& options, tIO_Backend* input, tIO_Backend* lossy, tIO_Backend* correction);
+                                    // options as on the command line, after the input name. The input
+                                    // is given as STDIN, "-S" is always added.
+
+bool Process_Next_Codec_Block();    // false at the end of the input.
+
+void Close_Pipeline();
+
+void Merge_Files(const std::string& lossy_filename, const std::string& output_directory);
+                                    // as "lossywav <lossy_filename> -M -o <output_directory>": the
+                                    // correction file is found next to the lossy file.
+
+bool Run_In_Child(const std::function<void()>& this_case);
+                                    // false if this_case failed or raised a lossyWAV error. Output to
+                                    // std::cout is flushed before and after.
+
+#endif // inprocess_h_
@@ -0,0 +1,345 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    lossywav-bench: throughput of lossyWAV on synthetic signals, to compare
+    machines and to catch performance regressions.
+
+    Micro-benchmarks time FFT_DIT_Real at each length and, on 44.1kHz
+    stereo pink noise part way through processing, FillFFT_Input_From_WAVE,
+    the spreading functions, the warped lattice filter, Make_Filter (the
+    Levinson recursion), Remove_Bits and the WAV read / write transfers.
+    End-to-end runs process whole synthetic files in memory and report the
+    speed as a multiple of real-time.
+
+    Each case runs in its own process, as lossyWAV keeps its state in
+    globals set up once per file.
+
+    Usage: lossywav-bench [--seconds <n>] [--full] [--micro | --e2e] [-- <lossyWAV options>]
+===========================================================================**/
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../units/nCore.h"
+#include "../units/fftw_interface.h"
+#include "../units/nFFT.h"
+#include "../units/nFillFFT.h"
+#include "../units/nIO.h"
+#include "../units/nRemoveBits.h"
+#include "../units/nSGNS.h"
+#include "../units/nSpreading.h"
+#include "../units/nWav.h"
+#include "inprocess.h"
+#include "synthetic.h"
+
+static const int32_t TRIALS = 5;
+static const double TRIAL_SECONDS = 0.02;
+static const int32_t WARM_UP_CODEC_BLOCKS = 128;
+
+static std::vector<std::string> LossyWAV_Options = {"--stdout"};
+static double Seconds = 10.0;
+
+
+//============================================================================
+// Best of TRIALS timings of this_call, in nanoseconds per call.
+//============================================================================
+template <class tCall> static double Time_Call(tCall this_call)
+{
+    int64_t repeats = 1;
+    double best = 0;
+
+    for (int32_t trial = 0; trial < TRIALS; )
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (int64_t repeat = 0; repeat < repeats; ++repeat)
+            this_call();
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (elapsed < TRIAL_SECONDS)
+        {
+            repeats <<= 1;
+            continue;
+        }
+
+        double this_time = elapsed * 1e9 / repeats;
+
+        if ((trial == 0) || (this_time < best))
+            best = this_time;
+
+        ++trial;
+    }
+
+    return best;
+}
+
+
+static void Run_Case(const std::function<void()>& this_case)
+{
+    if (!Run_In_Child(this_case))
+        std::cout << "  (failed)" << std::endl;
+}
+
+
+static void Report(const std::string& name, double ns_per_call, double per_call, const char* unit)
+{
+    std::cout << "  " << std::left << std::setw(42) << name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(12) << ns_per_call
+              << std::setprecision(3) << std::setw(12) << (ns_per_call / per_call) << " ns/" << unit << std::endl;
+}
+
+
+static void Bench_FFT()
+{
+    nCore_Init();
+    nFFT_Init(MAX_FFT_BIT_LENGTH);
+
+    std::cout << "FFT_DIT_Real                                    ns/call" << std::endl;
+
+    for (int32_t bit_length = 5; bit_length <= MAX_FFT_BIT_LENGTH; ++bit_length)
+    {
+        uint32_t seed = 0x12345678;
+
+        for (int32_t ff_i = 0; ff_i < (1 << bit_length); ++ff_i)
+        {
+            seed = seed * 1664525 + 1013904223;
+            FFT_Array.DReal[ff_i] = (int32_t(seed >> 8) - 0x800000) * (1.0 / 0x800000);
+        }
+
+        FFT_Proc_Rec this_FFT_plan;
+        this_FFT_plan.DComplex = FFT_Array.DComplex;
+
+        double this_time = Time_Call([&]()
+        {
+            this_FFT_plan.NumberOfBitsNeeded = bit_length;
+            FFT_DIT_Real(&this_FFT_plan);
+        });
+
+        Report(std::to_string(1 << bit_length) + " points", this_time, 1 << bit_length, "point");
+    }
+}
+
+
+//============================================================================
+// Processing stages on the state part way through a file, so that filters,
+// histories and bits-to-remove are those of real processing.
+//============================================================================
+static void Bench_Stages()
+{
+    std::vector<uint8_t> wav = Synthetic_WAV(SIGNAL_PINK, 44100, 2, 16, Seconds);
+    tIO_Memory input(wav.data(), wav.size());
+    tIO_Callback output(Discard_Output, nullptr);
+
+    Open_Pipeline(LossyWAV_Options, &input, &output, nullptr);
+
+    for (int32_t this_block = 0; this_block < WARM_UP_CODEC_BLOCKS; ++this_block)
+    {
+        if (!Process_Next_Codec_Block())
+            lossyWAVError("Synthetic signal too short.", 0x21);
+    }
+
+    std::cout << "Stages, 44.1kHz 16 bit stereo pink noise         ns/call" << std::endl;
+
+    Current.Channel = 0;
+
+    for (int32_t this_analysis_number = 1; this_analysis_number <= PRECALC_ANALYSES; ++this_analysis_number)
+    {
+        if (!settings.analysis[this_analysis_number].active)
+            continue;
+
+        Current.Analysis.number = this_analysis_number;
+        Current.FFT = FFT_PreCalc_Data_Rec[Current.Analysis.bits[this_analysis_number]];
+
+        FFT_Proc_Rec this_FFT_plan;
+        this_FFT_plan.FFT = &FFT_PreCalc_Data_Rec[Current.FFT.bit_length];
+        this_FFT_plan.FFT_Array = &FFT_Array;
+        this_FFT_plan.Task.block_start = 0;
+
+        Results_Type* this_result = &results.WAVE[this_analysis_number][Current.Channel];
+        const std::string length = " (" + std::to_string(Current.FFT.length) + ")";
+
+        Report("FillFFT_Input_From_WAVE" + length, Time_Call([&]() { FillFFT_Input_From_WAVE(&this_FFT_plan); }), Current.FFT.length, "point");
+
+        this_FFT_plan.NumberOfBitsNeeded = Current.FFT.bit_length;
+        FFT_DIT_Real(&this_FFT_plan);
+
+        Report("Spreading_Function_Fused" + length, Time_Call([&]() { Spreading_Function_Fused(&this_FFT_plan, this_result); }), Current.FFT.length_half, "bin");
+        Report("Spreading_Function" + length, Time_Call([&]() { Spreading_Function(this_result); }), Current.FFT.length_half, "bin");
+    }
+
+    if (parameters.shaping.active)
+    {
+        uint32_t seed = 0x12345678;
+        double filter_output = 0;
+
+        //========================================================================
+        // Fed with rounding error sized noise, as in Remove_Bits.
+        //========================================================================
+        Report("Warped_Lattice_Filter_Evaluate / Update", Time_Call([&]()
+        {
+            seed = seed * 1664525 + 1013904223;
+            filter_output += Warped_Lattice_Filter_Evaluate(Current.Channel);
+            Warped_Lattice_Filter_Update(Current.Channel, (int32_t(seed >> 8) - 0x800000) * (0.5 / 0x800000));
+        }), 1, "sample");
+
+        Report("Make_Filter (Levinson)", Time_Call([&]() { Make_Filter(Current.Channel); }), Filter_Order(), "tap");
+    }
+
+    Report("Remove_Bits", Time_Call([&]() { Remove_Bits(); }), AudioData.Size.This, "sample");
+}
+
+
+//============================================================================
+// ReadTransfer / WriteTransfer through the codec block read and write calls.
+//============================================================================
+static void Bench_Transfer(int32_t bits_per_sample, int32_t channels)
+{
+    std::vector<uint8_t> wav = Synthetic_WAV(SIGNAL_PINK, 44100, channels, bits_per_sample, Seconds);
+    tIO_Memory input(wav.data(), wav.size());
+    tIO_Callback output(Discard_Output, nullptr);
+
+    Open_Pipeline(LossyWAV_Options, &input, &output, nullptr);
+
+    int64_t blocks = 1;
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (readNextNextCodecBlock())
+        ++ blocks;
+
+    double read_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / blocks;
+
+    AudioData.Size.This = Global.Codec_Block.Size;
+
+    double write_time = Time_Call([&]() { writeNextBTRDcodecblock(); });
+
+    const std::string format = " (" + std::to_string(bits_per_sample) + " bit, " + std::to_string(channels) + " ch)";
+
+    Report("ReadTransfer" + format, read_time, Global.Codec_Block.Size, "frame");
+    Report("WriteTransfer" + format, write_time, Global.Codec_Block.Size, "frame");
+}
+
+
+static void Bench_End_To_End(int32_t signal, int32_t sample_rate, int32_t channels)
+{
+    const int32_t bits_per_sample = (sample_rate > 48000) ? 24 : 16;
+
+    std::vector<uint8_t> wav = Synthetic_WAV(signal, sample_rate, channels, bits_per_sample, Seconds);
+    tIO_Memory input(wav.data(), wav.size());
+    tIO_Callback output(Discard_Output, nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+
+    Open_Pipeline(LossyWAV_Options, &input, &output, nullptr);
+
+    while (Process_Next_Codec_Block())
+    {
+    }
+
+    Close_Pipeline();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "  " << std::left << std::setw(9) << Synthetic_Signal_Names[signal] << std::right
+              << std::setw(7) << std::fixed << std::setprecision(1) << (sample_rate / 1000.0) << "kHz"
+              << std::setw(4) << bits_per_sample << " bit" << std::setw(3) << channels << " ch"
+              << std::setw(12) << std::setprecision(2) << (Seconds / elapsed) << "x"
+              << std::setw(10) << std::setprecision(4) << (OneOver[Global.Channels] * Stats.total_bits_removed * Global.blocks_processed_recip) << " bits"
+              << (FFTW_Initialised() ? " [F]" : " [I]") << std::endl;
+}
+
+
+int main(int32_t argc, char* argv[])
+{
+    bool full = false;
+    bool micro = true;
+    bool end_to_end = true;
+
+    for (int32_t this_arg = 1; this_arg < argc; ++this_arg)
+    {
+        std::string this_argument = argv[this_arg];
+
+        if ((this_argument == "--seconds") && (this_arg + 1 < argc))
+            Seconds = std::max(1.0, std::atof(argv[++this_arg]));
+        else if (this_argument == "--full")
+            full = true;
+        else if (this_argument == "--micro")
+            end_to_end = false;
+        else if (this_argument == "--e2e")
+            micro = false;
+        else if (this_argument == "--")
+            LossyWAV_Options.insert(LossyWAV_Options.end(), argv + this_arg + 1, argv + argc);
+        else
+        {
+            std::cerr << "Usage: lossywav-bench [--seconds <n>] [--full] [--micro | --e2e] [-- <lossyWAV options>]" << std::endl;
+            return 1;
+        }
+
+        if (this_argument == "--")
+            break;
+    }
+
+    if (micro)
+    {
+        Run_Case(Bench_FFT);
+        Run_Case(Bench_Stages);
+
+        std::cout << "Transfers                                       ns/call" << std::endl;
+
+        Run_Case([]() { Bench_Transfer(16, 2); });
+        Run_Case([]() { Bench_Transfer(24, 2); });
+        Run_Case([]() { Bench_Transfer(24, 8); });
+    }
+
+    if (end_to_end)
+    {
+        const int32_t sample_rates[] = {44100, 96000, 192000};
+        const int32_t channel_counts[] = {1, 2, 8};
+
+        std::cout << "End-to-end, " << std::fixed << std::setprecision(1) << Seconds << "s per file           speed     bits removed" << std::endl;
+
+        for (int32_t this_signal = 0; this_signal < SYNTHETIC_SIGNALS; ++this_signal)
+        {
+            for (int32_t sample_rate : sample_rates)
+            {
+                for (int32_t channels : channel_counts)
+                {
+                    //============================================================
+                    // By default every signal at 44.1kHz stereo, and pink noise
+                    // at every rate and channel count.
+                    //============================================================
+                    if ((full) || ((sample_rate == 44100) && (channels == 2)) || (this_signal == SIGNAL_PINK))
+                        Run_Case([=]() { Bench_End_To_End(this_signal, sample_rate, channels); });
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Synthetic test signals for the tools, see synthetic.h.
+===========================================================================**/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "synthetic.h"
+
+const char* const Synthetic_Signal_Names[SYNTHETIC_SIGNALS] = {"sweep", "pink", "impulses", "silence", "clipped", "tone"};
+
+static const double SYNTHETIC_PI = 3.14159265358979323846;
+
+
+//============================================================================
+// Pink noise by Paul Kellet's economy filter on a linear congruential white
+// noise source, so every platform gives the same sequence.
+//============================================================================
+struct tPink_Noise
+{
+    uint32_t seed;
+    double b0 = 0, b1 = 0, b2 = 0;
+
+    explicit tPink_Noise(uint32_t thisseed) : seed(thisseed) {}
+
+    double White()
+    {
+        seed = seed * 1664525 + 1013904223;
+        return (int32_t(seed >> 8) - 0x800000) * (1.0 / 0x800000);
+    }
+
+    double Next()
+    {
+        double white = White();
+
+        b0 = 0.99765 * b0 + white * 0.0990460;
+        b1 = 0.96300 * b1 + white * 0.2965164;
+        b2 = 0.57000 * b2 + white * 1.0526913;
+
+        return (b0 + b1 + b2 + white * 0.1848) * 0.05;
+    }
+};
+
+
+int32_t Synthetic_Signal(const std::string& name)
+{
+    for (int32_t this_signal = 0; this_signal < SYNTHETIC_SIGNALS; ++this_signal)
+    {
+        if (name == Synthetic_Signal_Names[this_signal])
+            return this_signal;
+    }
+
+    return -1;
+}
+
+
+static void Put_Le(uint8_t* &pB, uint32_t value, int32_t bytes)
+{
+    for (int32_t this_byte = 0; this_byte < bytes; ++this_byte)
+    {
+        *pB++ = uint8_t(value >> (this_byte * 8));
+    }
+}
+
+
+std::vector<uint8_t> Synthetic_WAV(int32_t signal, int32_t sample_rate, int32_t channels, int32_t bits_per_sample, double seconds)
+{
+    const int32_t bytes_per_sample = (bits_per_sample + 7) >> 3;
+    const uint64_t samples = uint64_t(seconds * sample_rate);
+    const uint32_t data_size = uint32_t(samples * channels * bytes_per_sample);
+    const double full_scale = std::ldexp(1.0, bits_per_sample - 1) - 1;
+
+    std::vector<uint8_t> wav(44 + data_size);
+    uint8_t* pB = wav.data();
+
+    //========================================================================
+    // Canonical 44 byte header, WAVE_FORMAT_PCM.
+    //========================================================================
+    std::memcpy(pB, "RIFF", 4);
+    pB += 4;
+    Put_Le(pB, 36 + data_size, 4);
+    std::memcpy(pB, "WAVEfmt ", 8);
+    pB += 8;
+    Put_Le(pB, 16, 4);
+    Put_Le(pB, 1, 2);
+    Put_Le(pB, channels, 2);
+    Put_Le(pB, sample_rate, 4);
+    Put_Le(pB, sample_rate * channels * bytes_per_sample, 4);
+    Put_Le(pB, channels * bytes_per_sample, 2);
+    Put_Le(pB, bits_per_sample, 2);
+    std::memcpy(pB, "data", 4);
+    pB += 4;
+    Put_Le(pB, data_size, 4);
+
+    //========================================================================
+    // Each channel is a slightly different version of the signal, so that
+    // channels are neither identical nor independent.
+    //========================================================================
+    std::vector<tPink_Noise> pink;
+    std::vector<double> phase(channels), frequency(channels);
+
+    const double f_start = 20.0;
+    const double f_end = 0.45 * sample_rate;
+    const double sweep_ratio = std::pow(f_end / f_start, 1.0 / std::max(uint64_t(1), samples));
+
+    for (int32_t this_channel = 0; this_channel < channels; ++this_channel)
+    {
+        pink.push_back(tPink_Noise(0x12345678 + 0x9E3779B9u * this_channel));
+        phase[this_channel] = 0.5 * this_channel;
+        frequency[this_channel] = (signal == SIGNAL_SWEEP) ? f_start : 997.0 * (1.0 + 0.1 * this_channel);
+    }
+
+    for (uint64_t this_sample = 0; this_sample < samples; ++this_sample)
+    {
+        for (int32_t this_channel = 0; this_channel < channels; ++this_channel)
+        {
+            double value = 0;
+
+            switch (signal)
+            {
+            case SIGNAL_SWEEP:
+                value = 0.7071 * std::sin(phase[this_channel]);
+                frequency[this_channel] *= sweep_ratio;
+                break;
+
+            case SIGNAL_PINK:
+                value = pink[this_channel].Next();
+                break;
+
+            case SIGNAL_IMPULSES:
+                if ((this_sample + uint64_t(this_channel) * (sample_rate / 64)) % (sample_rate / 4) == 0)
+                    value = (((this_sample / (sample_rate / 4)) & 1) == 0) ? 1.0 : -1.0;
+                break;
+
+            case SIGNAL_CLIPPED:
+                value = 2.0 * (0.5 * std::sin(phase[this_channel]) + 2.0 * pink[this_channel].Next());
+                value = std::max(-1.0, std::min(1.0, value));
+                break;
+
+            case SIGNAL_TONE:
+                if (((this_sample / (sample_rate / 4)) & 1) == 0)
+                    value = 0.8913 * std::sin(phase[this_channel]);
+                break;
+
+            default:
+                break;
+            }
+
+            phase[this_channel] += 2.0 * SYNTHETIC_PI * frequency[this_channel] / sample_rate;
+
+            if (phase[this_channel] >= SYNTHETIC_PI)
+                phase[this_channel] -= 2.0 * SYNTHETIC_PI;
+
+            int32_t this_value = int32_t(std::lround(std::max(-full_scale, std::min(full_scale, value * full_scale))));
+
+            if (bytes_per_sample == 1)
+                this_value += 128;
+
+            Put_Le(pB, uint32_t(this_value), bytes_per_sample);
+        }
+    }
+
+    return wav;
+}
+
+
+std::vector<uint8_t> Float_WAV(const std::vector<uint8_t>& pcm_wav)
+{
+    const int32_t channels = pcm_wav[22] | (pcm_wav[23] << 8);
+    const uint32_t sample_rate = pcm_wav[24] | (pcm_wav[25] << 8) | (pcm_wav[26] << 16) | (uint32_t(pcm_wav[27]) << 24);
+    const int32_t bits_per_sample = pcm_wav[34] | (pcm_wav[35] << 8);
+    const int32_t bytes_per_sample = (bits_per_sample + 7) >> 3;
+    const uint64_t values = (pcm_wav.size() - 44) / bytes_per_sample;
+    const uint32_t data_size = uint32_t(values * 4);
+    const double scale = std::ldexp(1.0, 1 - bits_per_sample);
+
+    std::vector<uint8_t> wav(58 + data_size);
+    uint8_t* pB = wav.data();
+
+    //========================================================================
+    // WAVE_FORMAT_IEEE_FLOAT: 18 byte 'fmt ' chunk, then 'fact' holding the
+    // length in samples.
+    //========================================================================
+    std::memcpy(pB, "RIFF", 4);
+    pB += 4;
+    Put_Le(pB, 50 + data_size, 4);
+    std::memcpy(pB, "WAVEfmt ", 8);
+    pB += 8;
+    Put_Le(pB, 18, 4);
+    Put_Le(pB, 3, 2);
+    Put_Le(pB, channels, 2);
+    Put_Le(pB, sample_rate, 4);
+    Put_Le(pB, sample_rate * channels * 4, 4);
+    Put_Le(pB, channels * 4, 2);
+    Put_Le(pB, 32, 2);
+    Put_Le(pB, 0, 2);
+    std::memcpy(pB, "fact", 4);
+    pB += 4;
+    Put_Le(pB, 4, 4);
+    Put_Le(pB, uint32_t(values / channels), 4);
+    std::memcpy(pB, "data", 4);
+    pB += 4;
+    Put_Le(pB, data_size, 4);
+
+    const uint8_t* pPCM = pcm_wav.data() + 44;
+
+    for (uint64_t this_value = 0; this_value < values; ++this_value)
+    {
+        uint32_t this_integer = 0;
+
+        for (int32_t this_byte = 0; this_byte < bytes_per_sample; ++this_byte)
+            this_integer |= uint32_t(*pPCM++) << (this_byte * 8);
+
+        int32_t this_sample = int32_t(this_integer << (32 - bits_per_sample)) >> (32 - bits_per_sample);
+        float this_float = float(this_sample * scale);
+        uint32_t this_bits;
+
+        std::memcpy(&this_bits, &this_float, 4);
+        Put_Le(pB, this_bits, 4);
+    }
+
+    return wav;
+}
@@ -0,0 +1,60 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Synthetic test signals for the tools: sine sweeps, pink noise, impulses,
+    silence, clipped material and tone bursts as 16 / 24 bit PCM WAV images, 1 to 8
+    channels at any sample rate, optionally as 32 bit IEEE float. Output is
+    the same on every run.
+===========================================================================**/
+
+#ifndef synthetic_h_
+#define synthetic_h_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum tSynthetic_Signal
+{
+    SIGNAL_SWEEP,           // logarithmic sine sweep, 20Hz to 45% of the sample rate, -3dBFS.
+    SIGNAL_PINK,            // pink noise at about -21dBFS RMS.
+    SIGNAL_IMPULSES,        // full scale clicks of alternating sign, four a second, on silence.
+    SIGNAL_SILENCE,         // digital silence.
+    SIGNAL_CLIPPED,         // sine and pink noise driven 6dB past full scale and hard clipped.
+    SIGNAL_TONE,            // -1dBFS sine switched on and off every quarter second on digital silence:
+                            // a spectrum of very high dynamic range.
+    SYNTHETIC_SIGNALS
+};
+
+extern const char* const Synthetic_Signal_Names[SYNTHETIC_SIGNALS];
+
+int32_t Synthetic_Signal(const std::string& name);     // -1 if not a signal name.
+
+std::vector<uint8_t> Synthetic_WAV(int32_t signal, int32_t sample_rate, int32_t channels, int32_t bits_per_sample, double seconds);
+
+std::vector<uint8_t> Float_WAV(const std::vector<uint8_t>& pcm_wav);
+                                    // a 16 / 24 bit image from Synthetic_WAV as 32 bit IEEE float, with
+                                    // the 'fact' chunk that format requires. Samples are scaled by
+                                    // 2^-(bits - 1), so converting back to integers is exact.
+
+#endif // synthetic_h_
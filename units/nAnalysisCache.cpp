@@ -0,0 +1,398 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#include "nAnalysisCache.h"
+#include "nAnalysisFile.h"
+#include "nCore.h"
+#include "nSupport.h"
+
+namespace {
+
+//============================================================================
+// One file per combination of settings and input format in the cache
+// directory, named after a hash of them. Native byte order:
+//   header  : "LWACACHE", version and record size (uint32), settings hash.
+//   entries : 128 bit key of the codec block samples, then the analysis
+//             record as written by Pack_Analysis.
+// The whole file is read at the start. At the end, holding an flock on
+// "<file>.lock", it is read again for entries other encodes have added since,
+// the new entries are added after them (oldest dropped over the size limit)
+// and the result is written to "<file>.new" and renamed over the file, so a
+// reader never sees a partly written file.
+//============================================================================
+static const char     ANALYSIS_CACHE_ID[8] = {'L', 'W', 'A', 'C', 'A', 'C', 'H', 'E'};
+static const uint32_t ANALYSIS_CACHE_VERSION = 1;
+static const int32_t  ANALYSIS_CACHE_ERROR = 0x24;
+
+struct Analysis_Cache_Header
+{
+    char     ID[8];
+    uint32_t Version;
+    uint32_t Record_Size;
+    uint64_t Settings_Hash;
+};
+
+struct Analysis_Cache_Key
+{
+    uint64_t a;
+    uint64_t b;
+
+    bool operator==(const Analysis_Cache_Key& other) const { return (a == other.a) && (b == other.b); }
+};
+
+struct Analysis_Cache_Key_Hash
+{
+    size_t operator()(const Analysis_Cache_Key& key) const { return size_t(key.a); }
+};
+
+struct
+{
+    bool                 Active = false;
+    std::string          Filename;
+    uint64_t             Settings_Hash = 0;
+    uint64_t             Entry_Size = 0;
+    uint64_t             Loaded = 0;                 // bytes of Entries read from the file.
+    std::vector<uint8_t> Entries;
+    std::unordered_map<Analysis_Cache_Key, uint64_t, Analysis_Cache_Key_Hash> Index;
+    Analysis_Cache_Key   This_Key;
+} AnalysisCache;
+
+
+inline uint64_t Rotate_Left(uint64_t value, int32_t bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+
+inline uint64_t Final_Mix(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDuLL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53uLL;
+    value ^= value >> 33;
+    return value;
+}
+
+
+//============================================================================
+// Two independently mixed 64 bit lanes, i.e. a 128 bit key.
+//============================================================================
+struct Block_Hasher
+{
+    uint64_t a = 0x9E3779B97F4A7C15uLL;
+    uint64_t b = 0xD6E8FEB86659FD93uLL;
+
+    inline void Add(uint64_t value)
+    {
+        a = Rotate_Left(a ^ (value * 0x87C37B91114253D5uLL), 31) * 0x4CF5AD432745937FuLL;
+        b = (Rotate_Left(b + (value * 0x52DCE729uLL), 27) ^ a) * 0x38495AB5uLL + 0x9E3779B97F4A7C15uLL;
+    }
+
+    void Add(const std::string& text)
+    {
+        for (size_t thischar = 0; thischar < text.length(); ++thischar)
+        {
+            Add(uint8_t(text[thischar]));
+        }
+    }
+
+    Analysis_Cache_Key Key() const
+    {
+        Analysis_Cache_Key thiskey = {Final_Mix(a + b), Final_Mix(b ^ Rotate_Left(a, 17))};
+        return thiskey;
+    }
+};
+
+
+void Add_Entry(uint64_t offset)
+{
+    Analysis_Cache_Key thiskey;
+
+    std::memcpy(&thiskey, &AnalysisCache.Entries[offset], sizeof(thiskey));
+    AnalysisCache.Index[thiskey] = offset;
+}
+
+
+void Load_Cache_File()
+{
+    Analysis_Cache_Header fileheader;
+    std::ifstream cachefile(AnalysisCache.Filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!cachefile.good())
+    {
+        return;
+    }
+
+    cachefile.seekg(0, std::ios::end);
+    uint64_t filesize = cachefile.tellg();
+    cachefile.seekg(0, std::ios::beg);
+
+    if ((filesize < sizeof(fileheader))
+     || (!cachefile.read((char*) &fileheader, sizeof(fileheader)))
+     || (std::memcmp(fileheader.ID, ANALYSIS_CACHE_ID, sizeof(fileheader.ID)) != 0)
+     || (fileheader.Version != ANALYSIS_CACHE_VERSION)
+     || (fileheader.Record_Size != Analysis_Record_Size())
+     || (fileheader.Settings_Hash != AnalysisCache.Settings_Hash))
+    {
+        lossyWAVWarning("Ignoring unrecognised analysis cache file " + AnalysisCache.Filename);
+        return;
+    }
+
+    // A partly written last entry is dropped.
+    AnalysisCache.Loaded = (filesize - sizeof(fileheader)) - ((filesize - sizeof(fileheader)) % AnalysisCache.Entry_Size);
+    AnalysisCache.Entries.resize(AnalysisCache.Loaded);
+
+    if ((AnalysisCache.Loaded > 0) && (!cachefile.read((char*) AnalysisCache.Entries.data(), AnalysisCache.Loaded)))
+    {
+        lossyWAVWarning("Reading analysis cache file " + AnalysisCache.Filename);
+        AnalysisCache.Loaded = 0;
+        AnalysisCache.Entries.clear();
+        return;
+    }
+
+    for (uint64_t offset = 0; offset < AnalysisCache.Loaded; offset += AnalysisCache.Entry_Size)
+    {
+        Add_Entry(offset);
+    }
+}
+
+
+bool Write_Cache_File(const std::string& thisname, uint64_t offset)
+{
+    Analysis_Cache_Header thisheader;
+    std::ofstream cachefile(thisname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!cachefile.good())
+    {
+        return false;
+    }
+
+    std::memcpy(thisheader.ID, ANALYSIS_CACHE_ID, sizeof(thisheader.ID));
+    thisheader.Version = ANALYSIS_CACHE_VERSION;
+    thisheader.Record_Size = Analysis_Record_Size();
+    thisheader.Settings_Hash = AnalysisCache.Settings_Hash;
+
+    cachefile.write((const char*) &thisheader, sizeof(thisheader));
+    cachefile.write((const char*) &AnalysisCache.Entries[offset], AnalysisCache.Entries.size() - offset);
+    cachefile.close();
+
+    return !cachefile.fail();
+}
+
+} // namespace
+
+
+void nAnalysisCache_Init()
+{
+    Block_Hasher settingshasher;
+    char hashtext[17];
+
+    AnalysisCache.Active = (parameters.analysis_file.cache != "") && (!Replaying_Analysis());
+
+    if (!AnalysisCache.Active)
+    {
+        return;
+    }
+
+    if (!DirectoryExists(parameters.analysis_file.cache))
+    {
+        lossyWAVError("Analysis cache directory not found: " + parameters.analysis_file.cache, ANALYSIS_CACHE_ERROR);
+    }
+
+    settingshasher.Add(strings.version_short);
+    settingshasher.Add(strings.parameter);
+    settingshasher.Add(Global.sample_rate);
+    settingshasher.Add(Global.Channels);
+    settingshasher.Add(Global.bits_per_sample);
+    settingshasher.Add(Global.Codec_Block.Size);
+    settingshasher.Add(Analysis_Filter_Order());
+
+    AnalysisCache.Settings_Hash = settingshasher.Key().a;
+    AnalysisCache.Entry_Size = sizeof(Analysis_Cache_Key) + Analysis_Record_Size();
+
+    std::snprintf(hashtext, sizeof(hashtext), "%016llx", (unsigned long long) AnalysisCache.Settings_Hash);
+
+    AnalysisCache.Filename = parameters.analysis_file.cache;
+
+    if ((AnalysisCache.Filename.back() != '/') && (AnalysisCache.Filename.back() != '\\'))
+    {
+        AnalysisCache.Filename += '/';
+    }
+
+    AnalysisCache.Filename += std::string("lossyWAV-") + hashtext + ".cache";
+
+    Load_Cache_File();
+}
+
+
+bool Caching_Analysis()
+{
+    return AnalysisCache.Active;
+}
+
+
+bool Find_Cached_Analysis()
+{
+    static const int32_t Block_Sizes_Index[4] = {PREV_CODEC_BLOCK, LAST_CODEC_BLOCK, THIS_CODEC_BLOCK, NEXT_CODEC_BLOCK};
+    const int32_t block_sizes[4] = {AudioData.Size.Prev, AudioData.Size.Last, AudioData.Size.This, AudioData.Size.Next};
+    Block_Hasher blockhasher;
+
+    if (!AnalysisCache.Active)
+    {
+        return false;
+    }
+
+    blockhasher.Add(AnalysisCache.Settings_Hash);
+    blockhasher.Add(Global.first_codec_block);
+    blockhasher.Add(Global.last_codec_block);
+
+    for (int32_t this_block = 0; this_block < 4; ++this_block)
+    {
+        blockhasher.Add(block_sizes[this_block]);
+
+        for (int32_t this_channel = 0; this_channel < Global.Channels; ++this_channel)
+        {
+            DATA64* samples = AudioData.WAVEPTR[Block_Sizes_Index[this_block]][this_channel];
+
+            for (int32_t this_sample = 0; this_sample < block_sizes[this_block]; ++this_sample)
+            {
+                blockhasher.Add(samples[this_sample].Int64);
+            }
+        }
+    }
+
+    AnalysisCache.This_Key = blockhasher.Key();
+
+    auto found = AnalysisCache.Index.find(AnalysisCache.This_Key);
+
+    if ((found != AnalysisCache.Index.end()) && (Unpack_Analysis(&AnalysisCache.Entries[found->second + sizeof(Analysis_Cache_Key)])))
+    {
+        ++ Stats.Cache.hits;
+        return true;
+    }
+
+    ++ Stats.Cache.misses;
+    return false;
+}
+
+
+void Cache_Analysis(int64_t skipped_filters)
+{
+    uint64_t offset = AnalysisCache.Entries.size();
+
+    AnalysisCache.Entries.resize(offset + AnalysisCache.Entry_Size);
+
+    std::memcpy(&AnalysisCache.Entries[offset], &AnalysisCache.This_Key, sizeof(Analysis_Cache_Key));
+    Pack_Analysis(&AnalysisCache.Entries[offset + sizeof(Analysis_Cache_Key)], skipped_filters);
+
+    Add_Entry(offset);
+}
+
+
+void nAnalysisCache_Close()
+{
+    uint64_t limit;
+    uint64_t keep;
+    uint64_t offset;
+    std::string tempname;
+    std::vector<uint8_t> newentries;
+    Analysis_Cache_Key thiskey;
+
+    if ((!AnalysisCache.Active) || (AnalysisCache.Entries.size() == AnalysisCache.Loaded))
+    {
+        return;
+    }
+
+    AnalysisCache.Active = false;
+
+#ifndef _WIN32
+    int lockfd = open((AnalysisCache.Filename + ".lock").c_str(), O_RDWR | O_CREAT, 0666);
+
+    if ((lockfd < 0) || (flock(lockfd, LOCK_EX) != 0))
+    {
+        lossyWAVWarning("Locking analysis cache file " + AnalysisCache.Filename);
+    }
+#endif
+
+    //========================================================================
+    // Re-read the file and add the new entries other encodes have not.
+    //========================================================================
+    newentries.assign(AnalysisCache.Entries.begin() + AnalysisCache.Loaded, AnalysisCache.Entries.end());
+
+    AnalysisCache.Loaded = 0;
+    AnalysisCache.Entries.clear();
+    AnalysisCache.Index.clear();
+
+    Load_Cache_File();
+
+    for (offset = 0; offset < newentries.size(); offset += AnalysisCache.Entry_Size)
+    {
+        std::memcpy(&thiskey, &newentries[offset], sizeof(thiskey));
+
+        if (AnalysisCache.Index.find(thiskey) == AnalysisCache.Index.end())
+        {
+            AnalysisCache.Entries.insert(AnalysisCache.Entries.end(), newentries.begin() + offset, newentries.begin() + offset + AnalysisCache.Entry_Size);
+            Add_Entry(AnalysisCache.Entries.size() - AnalysisCache.Entry_Size);
+        }
+    }
+
+    //========================================================================
+    // Write the newest entries that fit the limit to a new file.
+    //========================================================================
+    limit = (parameters.analysis_file.cache_size > 0 ? uint64_t(parameters.analysis_file.cache_size) : 256) << 20;
+    keep = (limit - std::min(limit, uint64_t(sizeof(Analysis_Cache_Header)))) / AnalysisCache.Entry_Size * AnalysisCache.Entry_Size;
+    keep = std::min(keep, uint64_t(AnalysisCache.Entries.size()));
+    tempname = AnalysisCache.Filename + ".new";
+
+    if ((AnalysisCache.Entries.size() > AnalysisCache.Loaded)
+     && ((!Write_Cache_File(tempname, AnalysisCache.Entries.size() - keep))
+      || (std::rename(tempname.c_str(), AnalysisCache.Filename.c_str()) != 0)))
+    {
+        std::remove(tempname.c_str());
+        lossyWAVWarning("Writing analysis cache file " + AnalysisCache.Filename);
+    }
+
+#ifndef _WIN32
+    if (lockfd >= 0)
+    {
+        close(lockfd);
+    }
+#endif
+}
@@ -0,0 +1,50 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#ifndef nAnalysisCache_h_
+#define nAnalysisCache_h_
+
+#include "nCore.h"
+
+//============================================================================
+// Persistent cache of codec block analyses (--analysis-cache). A block's
+// analysis depends only on the settings and the samples of the Prev, Last,
+// This and Next codec blocks, so identical audio in another file (or later
+// in the same one) can reuse the bits to remove and noise shaping filters
+// found the first time.
+//============================================================================
+
+void nAnalysisCache_Init();         // after nInitial_Setup, once the settings string is complete.
+
+bool Caching_Analysis();
+
+bool Find_Cached_Analysis();        // true if this codec block was found and its analysis restored.
+void Cache_Analysis(int64_t skipped_filters);   // after a missed codec block has been analysed.
+
+void nAnalysisCache_Close();        // writes new entries, keeping the file within --analysis-cache-size.
+
+#endif // nAnalysisCache_h_
@@ -0,0 +1,300 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "nAnalysisFile.h"
+#include "nCore.h"
+#include "nIO.h"
+#include "nSGNS.h"
+
+namespace {
+
+//============================================================================
+// File layout, native byte order:
+//   header : "LWANALYS", version, channels, codec-block size, bits per
+//            sample, filter order (0 if no adaptive filters are stored) and
+//            the length of the settings string, as uint32; then the
+//            settings string itself.
+//   blocks : per codec block, the number of filters skipped (uint8); per
+//            channel the bits to remove (uint8) and the analysis that set
+//            them (uint8); then per channel the filter order reflection
+//            coefficients (double).
+//============================================================================
+static const char     ANALYSIS_FILE_ID[8] = {'L', 'W', 'A', 'N', 'A', 'L', 'Y', 'S'};
+static const uint32_t ANALYSIS_FILE_VERSION = 1;
+static const int32_t  ANALYSIS_FILE_ERROR = 0x23;
+
+struct Analysis_File_Header
+{
+    char     ID[8];
+    uint32_t Version;
+    uint32_t Channels;
+    uint32_t Codec_Block_Size;
+    uint32_t Bits_Per_Sample;
+    uint32_t Filter_Order;
+    uint32_t Settings_Length;
+};
+
+struct
+{
+    tIO_Backend*         IO = nullptr;
+    bool                 Saving = false;
+    bool                 Replaying = false;
+    int32_t              Filter_Order = 0;
+    std::vector<uint8_t> Record;
+} AnalysisFile;
+
+
+void Make_Header(Analysis_File_Header& thisheader)
+{
+    std::memcpy(thisheader.ID, ANALYSIS_FILE_ID, sizeof(thisheader.ID));
+    thisheader.Version = ANALYSIS_FILE_VERSION;
+    thisheader.Channels = Global.Channels;
+    thisheader.Codec_Block_Size = Global.Codec_Block.Size;
+    thisheader.Bits_Per_Sample = Global.bits_per_sample;
+    thisheader.Filter_Order = AnalysisFile.Filter_Order;
+    thisheader.Settings_Length = strings.parameter.length();
+}
+
+} // namespace
+
+
+void nAnalysisFile_Init()
+{
+    Analysis_File_Header thisheader;
+    Analysis_File_Header fileheader;
+    std::string filesettings;
+
+    AnalysisFile.Saving = (parameters.analysis_file.save != "");
+    AnalysisFile.Replaying = (parameters.analysis_file.replay != "");
+
+    if ((!AnalysisFile.Saving) && (!AnalysisFile.Replaying))
+    {
+        return;
+    }
+
+    AnalysisFile.Filter_Order = Analysis_Filter_Order();
+    AnalysisFile.Record.resize(Analysis_Record_Size());
+
+    Make_Header(thisheader);
+
+    if (AnalysisFile.Saving)
+    {
+        AnalysisFile.IO = nIO_Open_Output(parameters.analysis_file.save);
+
+        if ((AnalysisFile.IO == nullptr)
+         || (!AnalysisFile.IO->Write(&thisheader, sizeof(thisheader)))
+         || (!AnalysisFile.IO->Write(strings.parameter.data(), strings.parameter.length())))
+        {
+            lossyWAVError("Writing to analysis file " + parameters.analysis_file.save, ANALYSIS_FILE_ERROR);
+        }
+
+        return;
+    }
+
+    AnalysisFile.IO = nIO_Open_Input(parameters.analysis_file.replay);
+
+    if (AnalysisFile.IO == nullptr)
+    {
+        lossyWAVError("Cannot open analysis file " + parameters.analysis_file.replay, ANALYSIS_FILE_ERROR);
+    }
+
+    if ((AnalysisFile.IO->Read(&fileheader, sizeof(fileheader)) != sizeof(fileheader))
+     || (std::memcmp(fileheader.ID, ANALYSIS_FILE_ID, sizeof(fileheader.ID)) != 0)
+     || (fileheader.Version != ANALYSIS_FILE_VERSION))
+    {
+        lossyWAVError("Not a lossyWAV analysis file: " + parameters.analysis_file.replay, ANALYSIS_FILE_ERROR);
+    }
+
+    filesettings.resize(fileheader.Settings_Length);
+
+    if ((fileheader.Settings_Length > 0)
+     && (AnalysisFile.IO->Read(&filesettings[0], fileheader.Settings_Length) != fileheader.Settings_Length))
+    {
+        lossyWAVError("Not a lossyWAV analysis file: " + parameters.analysis_file.replay, ANALYSIS_FILE_ERROR);
+    }
+
+    if ((fileheader.Channels != thisheader.Channels)
+     || (fileheader.Codec_Block_Size != thisheader.Codec_Block_Size)
+     || (fileheader.Bits_Per_Sample != thisheader.Bits_Per_Sample)
+     || (fileheader.Filter_Order != thisheader.Filter_Order))
+    {
+        lossyWAVError("Analysis file does not match the input file.", ANALYSIS_FILE_ERROR);
+    }
+
+    if (filesettings != strings.parameter)
+    {
+        lossyWAVError("Analysis file was saved with other settings: " + filesettings, ANALYSIS_FILE_ERROR);
+    }
+}
+
+
+bool Saving_Analysis()
+{
+    return AnalysisFile.Saving;
+}
+
+
+bool Replaying_Analysis()
+{
+    return AnalysisFile.Replaying;
+}
+
+
+int32_t Analysis_Filter_Order()
+{
+    if ((parameters.shaping.active) && (!parameters.shaping.fixed))
+    {
+        return Filter_Order();
+    }
+
+    return 0;
+}
+
+
+uint64_t Analysis_Record_Size()
+{
+    return 1 + Global.Channels * (2 + Analysis_Filter_Order() * sizeof(double));
+}
+
+
+void Pack_Analysis(uint8_t* pR, int64_t skipped_filters)
+{
+    int32_t filter_order = Analysis_Filter_Order();
+
+    *pR++ = uint8_t(std::min(int64_t(255), skipped_filters));
+
+    for (int32_t this_channel = 0; this_channel < Global.Channels; ++this_channel)
+    {
+        *pR++ = uint8_t(process.Channel_Data[this_channel].calc_bits_to_remove);
+        *pR++ = uint8_t(process.Channel_Data[this_channel].min_FFT_result.analysis);
+    }
+
+    for (int32_t this_channel = 0; this_channel < Global.Channels; ++this_channel)
+    {
+        std::memcpy(pR, Filter_Coefficients(this_channel), filter_order * sizeof(double));
+        pR += filter_order * sizeof(double);
+    }
+}
+
+
+bool Unpack_Analysis(const uint8_t* pR)
+{
+    int32_t filter_order = Analysis_Filter_Order();
+
+    Stats.Skipped_Filters += *pR++;
+
+    for (int32_t this_channel = 0; this_channel < Global.Channels; ++this_channel)
+    {
+        Channel_Data_Type* this_channel_data = &process.Channel_Data[this_channel];
+
+        this_channel_data->min_FFT_result.btr = *pR++;
+        this_channel_data->min_FFT_result.analysis = *pR++;
+
+        if ((this_channel_data->min_FFT_result.btr > Global.bits_per_sample) || (this_channel_data->min_FFT_result.analysis > PRECALC_ANALYSES + 2))
+        {
+            return false;
+        }
+    }
+
+    for (int32_t this_channel = 0; this_channel < Global.Channels; ++this_channel)
+    {
+        std::memcpy(Filter_Coefficients(this_channel), pR, filter_order * sizeof(double));
+        pR += filter_order * sizeof(double);
+    }
+
+    return true;
+}
+
+
+void Save_Analysis(int64_t skipped_filters)
+{
+    Pack_Analysis(AnalysisFile.Record.data(), skipped_filters);
+
+    if (!AnalysisFile.IO->Write(AnalysisFile.Record.data(), AnalysisFile.Record.size()))
+    {
+        lossyWAVError("Writing to analysis file " + parameters.analysis_file.save, ANALYSIS_FILE_ERROR);
+    }
+}
+
+
+void Replay_Analysis()
+{
+    if (AnalysisFile.IO->Read(AnalysisFile.Record.data(), AnalysisFile.Record.size()) != AnalysisFile.Record.size())
+    {
+        lossyWAVError("Analysis file ended before the input file.", ANALYSIS_FILE_ERROR);
+    }
+
+    if (!Unpack_Analysis(AnalysisFile.Record.data()))
+    {
+        lossyWAVError("Analysis file is corrupt.", ANALYSIS_FILE_ERROR);
+    }
+}
+
+
+void nAnalysisFile_Close()
+{
+    uint8_t thisbyte;
+    bool closed_ok = true;
+
+    if (AnalysisFile.IO == nullptr)
+    {
+        return;
+    }
+
+    if (AnalysisFile.Replaying)
+    {
+        if (AnalysisFile.IO->Read(&thisbyte, 1) != 0)
+        {
+            lossyWAVError("Analysis file is longer than the input file.", ANALYSIS_FILE_ERROR);
+        }
+    }
+
+    closed_ok = AnalysisFile.IO->Close();
+
+    delete AnalysisFile.IO;
+    AnalysisFile.IO = nullptr;
+
+    if (!closed_ok)
+    {
+        lossyWAVError("Closing analysis file.", ANALYSIS_FILE_ERROR);
+    }
+}
+
+
+void nAnalysisFile_Cleanup()
+{
+    if (AnalysisFile.IO != nullptr)
+    {
+        AnalysisFile.IO->Close();
+        delete AnalysisFile.IO;
+        AnalysisFile.IO = nullptr;
+    }
+}
@@ -0,0 +1,57 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#ifndef nAnalysisFile_h_
+#define nAnalysisFile_h_
+
+#include "nCore.h"
+
+//============================================================================
+// Analysis sidecar: --save-analysis records each codec block's per channel
+// bits to remove and adaptive noise shaping filter; --replay-analysis reads
+// them back in place of the FFT analyses, leaving only the bit removal.
+//============================================================================
+
+int32_t  Analysis_Filter_Order();                       // 0 unless adaptive noise shaping filters are made.
+uint64_t Analysis_Record_Size();                        // bytes per codec block.
+
+void Pack_Analysis(uint8_t* pR, int64_t skipped_filters);
+bool Unpack_Analysis(const uint8_t* pR);               // false if the record is out of range.
+
+void nAnalysisFile_Init();          // after nInitial_Setup, once the settings string is complete.
+
+bool Saving_Analysis();
+bool Replaying_Analysis();
+
+void Save_Analysis(int64_t skipped_filters);            // after the bits have been removed from this codec block.
+void Replay_Analysis();                                 // before the bits are removed from this codec block.
+
+void nAnalysisFile_Close();         // at the end of processing; errors if the file is not complete.
+
+void nAnalysisFile_Cleanup();
+
+#endif // nAnalysisFile_h_
@@ -326,6 +326,9 @@ void nCore_Init()
     Stats.Count.rclips = 0;
     Stats.Count.aclips = 0;
 
+    Stats.Cache.hits = 0;
+    Stats.Cache.misses = 0;
+
     Stats.total_bits_removed = 0;
     Stats.total_bits_lost = 0;
 
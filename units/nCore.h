@@ -90,6 +90,16 @@ enum
     TEN_OFFSET = 308
 };
 
+//==============================================================================
+// Precision of the window, FFT and spreading calculations (--analysis-precision).
+//==============================================================================
+enum
+{
+    ANALYSIS_PRECISION_DOUBLE = 0,
+    ANALYSIS_PRECISION_FLOAT = 1,
+    ANALYSIS_PRECISION_COMPARE = 2
+};
+
 //==========================================================================================================
 // Many thanks to "http://keisan.casio.com/has10/Free.cgi" for the online high precision calculator.
 //==========================================================================================================
@@ -252,6 +262,7 @@ struct FFT_Proc_Rec
         void* FFT_Array;         //
         tDComplex* DComplex;     // dynamic array to contain FFT data - set by programmer's code.
         double* DReal;           //
+        float* FReal;            // packed float real input / interleaved float complex output.
     } __attribute__ ((aligned(16)));
 
     FFT_Data_Rec* FFT __attribute__ ((aligned(16)));            // pointer to FFT bit-length related constants - set and used in FFT code.
@@ -275,6 +286,7 @@ extern struct FFT_Array_type
     {
         tDComplex DComplex[MAX_FFT_LENGTH];
         double DReal[MAX_FFT_LENGTH * 2];
+        float FReal[MAX_FFT_LENGTH * 2];
     };
 } FFT_Array  __attribute__ ((aligned(16)));
 
@@ -430,6 +442,7 @@ extern struct parameters_type
         bool dccorrect;
         int32_t analyses;
         int32_t underlap;
+        int32_t precision;
     } fft;
 
     bool parameters_checked;
@@ -437,6 +450,10 @@ extern struct parameters_type
     struct
     {
         std::string logfilename;
+        std::string jsonfilename;
+        std::string tracefilename;
+        int32_t progressfd;
+        int32_t progressdup;            // copy of progressfd made by nParameter_Init.
         bool silent;
         bool detail;
         bool verbosity;
@@ -448,6 +465,7 @@ extern struct parameters_type
         bool sampledist;
         bool logfileopened;
         bool perchannel;
+        bool perfcounters;
         bool bitdist;
         bool freqdist;
         bool postanalyse;
@@ -486,11 +504,22 @@ extern struct parameters_type
         bool    interp_warp;
     } shaping;
 
+    struct
+    {
+        std::string save;
+        std::string replay;
+        std::string cache;
+        int32_t cache_size;
+    } analysis_file;
+
     double quality;
     double scaling;
     int32_t priority;
     int32_t help;
     int32_t limit;
+    int32_t output_bits;
+    int32_t read_buffer;
+    int32_t write_buffer;
 } parameters     __attribute__ ((aligned(16)));
 
 struct Analysis_Type
@@ -545,6 +574,10 @@ struct FFT_Spreading_Type
     double old_minimum;
     double new_minimum;
     double alt_average;
+    int32_t old_min_bin;
+    int32_t new_min_bin;
+    int64_t position; // absolute start sample of the FFT held in LastUnity / LastRoot, -1 if none.
+    int32_t float_btr; // bits to remove from the float analysis of the same FFT, compare mode only.
 };
 
 struct Channel_Data_Type
@@ -603,9 +636,18 @@ extern struct process_type
     int32_t  end_overlap_length[MAX_FFT_BIT_LENGTH + 1];
     int32_t  actual_analysis_blocks_start[MAX_FFT_BIT_LENGTH + 1];
     uint64_t Analyses_Completed[PRECALC_ANALYSES + 1];
+    uint64_t Analyses_Reused[PRECALC_ANALYSES + 1];
 
-    uint64_t Old_Min_Used_History[PRECALC_ANALYSES + 1][MAX_FFT_LENGTH_HALF]    __attribute__ ((aligned(16)));
-    uint64_t New_Min_Used_History[PRECALC_ANALYSES + 1][MAX_FFT_LENGTH_HALF]    __attribute__ ((aligned(16)));
+    struct
+    {
+        uint64_t FFTs;
+        uint64_t FFTs_Differ;
+        uint64_t Blocks;
+        uint64_t Blocks_Differ;
+    } Precision_Compare;
+
+    uint64_t* Old_Min_Used_History[PRECALC_ANALYSES + 1];   // --spread only; MAX_FFT_LENGTH_HALF bins.
+    uint64_t* New_Min_Used_History[PRECALC_ANALYSES + 1];
     uint64_t Alt_Ave_Used[PRECALC_ANALYSES + 1];
     uint64_t Old_Min_Used[PRECALC_ANALYSES + 1];
     uint64_t New_Min_Used[PRECALC_ANALYSES + 1];
@@ -698,6 +740,12 @@ extern struct Stats_type
         int64_t xclips;
     } Count;
 
+    struct
+    {
+        int64_t hits;
+        int64_t misses;
+    } Cache;
+
     int64_t total_bits_removed;
     int64_t total_bits_lost;
 }
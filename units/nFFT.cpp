@@ -94,21 +94,25 @@
 
 ==============================================================================**/
 #include "math.h"
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 #include "nMaths.h"
 #include "nFFT.h"
+#include "nFFT_Factors.h"
 #include "nCore.h"
 
-//#define FACTOR_16
-//#define FACTOR_8_4
-#define FACTOR_4_8
-//#define FACTOR_4_2
-//#define FACTOR_2
-
 static tDComplex* A_Arr [32+1]   __attribute__ ((aligned(16)));
 static tDComplex* A_Arr_Conj [32+1]   __attribute__ ((aligned(16)));
 
 static int32_t* RevBits [32+1]   __attribute__ ((aligned(16)));
 
+static float* A_Arr_Float [32+1]   __attribute__ ((aligned(16)));   // interleaved Re, Im pairs.
+static int32_t* RevBits_Float [32+1]   __attribute__ ((aligned(16)));
+static int32_t nFFT_Float_MAX_FFT_BIT_LENGTH = 0;
+
 static double cos_pi_over_32[32] __attribute__ ((aligned(16)));
 
 static int32_t nFFT_MAX_FFT_BIT_LENGTH  __attribute__ ((aligned(16))) = 0;
@@ -1510,116 +1514,15 @@ void Radix_16R_DIT(FFT_Proc_Rec* this_FFT_plan)
 }
 
 
-#ifdef FACTOR_2
-void FFT_DIT_01(FFT_Proc_Rec* this_FFT)     { Radix_02FS_DIT(this_FFT); }
-void FFT_DIT_02(FFT_Proc_Rec* this_FFT)     { Radix_04FS_DIT(this_FFT); }
-void FFT_DIT_03(FFT_Proc_Rec* this_FFT)     { Radix_08FS_DIT(this_FFT); }
-void FFT_DIT_04(FFT_Proc_Rec* this_FFT)     { Radix_16FS_DIT(this_FFT); }
-void FFT_DIT_05(FFT_Proc_Rec* this_FFT)     { Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_06(FFT_Proc_Rec* this_FFT)     { Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_07(FFT_Proc_Rec* this_FFT)     { Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_08(FFT_Proc_Rec* this_FFT)     { Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_09(FFT_Proc_Rec* this_FFT)     { Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_10(FFT_Proc_Rec* this_FFT)     { Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_11(FFT_Proc_Rec* this_FFT)     { Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_12(FFT_Proc_Rec* this_FFT)     { Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_13(FFT_Proc_Rec* this_FFT)     { Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_XX(FFT_Proc_Rec* this_FFT)
-{
-    while (this_FFT->BlockBitLen<this_FFT->NumberOfBitsNeeded)
-        Radix_02F_DIT(this_FFT);
-}
-
-
-void IFFT_DIT_01(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_02(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_03(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_04(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_05(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_06(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_07(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_08(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_09(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_10(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_11(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_12(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_13(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_XX(FFT_Proc_Rec* this_FFT)
-{
-    while (this_FFT->BlockBitLen<(this_FFT->NumberOfBitsNeeded-1))
-        Radix_02R_DIT(this_FFT);
-}
-
-#endif
-
-
-#ifdef FACTOR_4_2
-void FFT_DIT_01(FFT_Proc_Rec* this_FFT)     { Radix_02FS_DIT(this_FFT); }
-void FFT_DIT_02(FFT_Proc_Rec* this_FFT)     { Radix_04FS_DIT(this_FFT); }
-void FFT_DIT_03(FFT_Proc_Rec* this_FFT)     { Radix_08FS_DIT(this_FFT); }
-void FFT_DIT_04(FFT_Proc_Rec* this_FFT)     { Radix_16FS_DIT(this_FFT); }
-void FFT_DIT_05(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_06(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_07(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_08(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_09(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_10(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_11(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-void FFT_DIT_12(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_13(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_02F_DIT(this_FFT); }
-
-void IFFT_DIT_01(FFT_Proc_Rec* this_FFT)    { Radix_02RS_DIT(this_FFT); }
-void IFFT_DIT_02(FFT_Proc_Rec* this_FFT)    { Radix_04RS_DIT(this_FFT); }
-void IFFT_DIT_03(FFT_Proc_Rec* this_FFT)    { Radix_08RS_DIT(this_FFT); }
-void IFFT_DIT_04(FFT_Proc_Rec* this_FFT)    { Radix_16RS_DIT(this_FFT); }
-void IFFT_DIT_05(FFT_Proc_Rec* this_FFT)    { Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_06(FFT_Proc_Rec* this_FFT)    { Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_07(FFT_Proc_Rec* this_FFT)    { Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_08(FFT_Proc_Rec* this_FFT)    { Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_09(FFT_Proc_Rec* this_FFT)    { Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_10(FFT_Proc_Rec* this_FFT)    { Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_11(FFT_Proc_Rec* this_FFT)    { Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_12(FFT_Proc_Rec* this_FFT)    { Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_13(FFT_Proc_Rec* this_FFT)    { Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_02R_DIT(this_FFT); }
-
-void FFT_DIT_XX(FFT_Proc_Rec* this_FFT)
-{
-    while ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>1)
-        Radix_04F_DIT(this_FFT);
-
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>0)
-        Radix_02F_DIT(this_FFT);
-}
-
-void IFFT_DIT_XX(FFT_Proc_Rec* this_FFT)
-{
-    while ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>1)
-    {
-        Radix_04R_DIT(this_FFT);
-    }
-
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>0)
-    {
-        Radix_02R_DIT(this_FFT);
-    }
-}
-#endif
-
-
-#ifdef FACTOR_4_8
+//=====================================================================================================================
+// Single stage forward FFTs of 2 to 16 points, and the forward FFT of more than FFT_FACTORISED_MAX_BIT_LENGTH bits.
+// Forward FFTs of 5 to FFT_FACTORISED_MAX_BIT_LENGTH bits are chosen by nFFT_Init from FFT_DIT_Factorisations below.
+// Inverse FFTs are radix 4, then 8.
+//=====================================================================================================================
 void FFT_DIT_01(FFT_Proc_Rec* this_FFT)     { Radix_02FS_DIT(this_FFT); }
 void FFT_DIT_02(FFT_Proc_Rec* this_FFT)     { Radix_04FS_DIT(this_FFT); }
 void FFT_DIT_03(FFT_Proc_Rec* this_FFT)     { Radix_08FS_DIT(this_FFT); }
 void FFT_DIT_04(FFT_Proc_Rec* this_FFT)     { Radix_16FS_DIT(this_FFT); }
-void FFT_DIT_05(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
-void FFT_DIT_06(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_07(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
-void FFT_DIT_08(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_09(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
-void FFT_DIT_10(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_11(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
-void FFT_DIT_12(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_13(FFT_Proc_Rec* this_FFT)     { Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
 
 void IFFT_DIT_01(FFT_Proc_Rec* this_FFT)    { Radix_02RS_DIT(this_FFT); }
 void IFFT_DIT_02(FFT_Proc_Rec* this_FFT)    { Radix_04RS_DIT(this_FFT); }
@@ -1659,149 +1562,246 @@ void IFFT_DIT_XX(FFT_Proc_Rec* this_FFT)
     }
 }
 
-#endif
 
+//=====================================================================================================================
+// Compile-time specialised forward FFT stages. LENGTH_BITS is the bit length of the complete FFT and BLOCK_BITS the
+// value of BlockBitLen before the stage, so strides, twiddle offsets and loop trip counts are all constants. The
+// arithmetic is the same as Radix_02F_DIT / Radix_04F_DIT / Radix_08F_DIT so results are identical.
+//=====================================================================================================================
+template <int32_t LENGTH_BITS, int32_t BLOCK_BITS>
+static inline void Radix_02F_T(tDComplex* DComplex)
+{
+    const int32_t DataStride = 1 << BLOCK_BITS;
+    const int32_t BlockLength = DataStride << 1;
+    const tDComplex* this_A_Arr = A_Arr[BLOCK_BITS + 1];
 
-#ifdef FACTOR_8_4
-void FFT_DIT_01(FFT_Proc_Rec* this_FFT)     { Radix_02FS_DIT(this_FFT); }
-void FFT_DIT_02(FFT_Proc_Rec* this_FFT)     { Radix_04FS_DIT(this_FFT); }
-void FFT_DIT_03(FFT_Proc_Rec* this_FFT)     { Radix_08FS_DIT(this_FFT); }
-void FFT_DIT_04(FFT_Proc_Rec* this_FFT)     { Radix_16FS_DIT(this_FFT); }
-void FFT_DIT_05(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_06(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
-void FFT_DIT_07(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_08(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_04F_DIT(this_FFT);}
-void FFT_DIT_09(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT);}
-void FFT_DIT_10(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_11(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_12(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
-void FFT_DIT_13(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_04F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
+    for (int32_t i = 0; i < (1 << LENGTH_BITS); i += BlockLength)
+    {
+        tDComplex* D0 = &DComplex[i];
+        tDComplex* D1 = D0 + DataStride;
 
-void IFFT_DIT_01(FFT_Proc_Rec* this_FFT)    { Radix_02RS_DIT(this_FFT); }
-void IFFT_DIT_02(FFT_Proc_Rec* this_FFT)    { Radix_04RS_DIT(this_FFT); }
-void IFFT_DIT_03(FFT_Proc_Rec* this_FFT)    { Radix_08RS_DIT(this_FFT); }
-void IFFT_DIT_04(FFT_Proc_Rec* this_FFT)    { Radix_16RS_DIT(this_FFT); }
-void IFFT_DIT_05(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_06(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); }
-void IFFT_DIT_07(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_08(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_04R_DIT(this_FFT);}
-void IFFT_DIT_09(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT);}
-void IFFT_DIT_10(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_11(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_12(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); }
-void IFFT_DIT_13(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_04R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
+        tDComplex V1 = D1[0];
+        D1[0] = D0[0] - V1;
+        D0[0] += V1;
 
-void FFT_DIT_XX(FFT_Proc_Rec* this_FFT)
-{
-    while ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>2)
-    {
-        Radix_08F_DIT(this_FFT);
-    }
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>1)
-    {
-        Radix_04F_DIT(this_FFT);
-    }
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>0)
-    {
-        Radix_02F_DIT(this_FFT);
+        for (int32_t n = 1; n < DataStride; n++)
+        {
+            tDComplex V1 = (D1[n] * this_A_Arr[n]);
+            D1[n] = D0[n] - V1;
+            D0[n] += V1;
+        }
     }
 }
 
-void IFFT_DIT_XX(FFT_Proc_Rec* this_FFT)
+
+static inline void Butterfly_04F(tDComplex* D0, tDComplex* D1, tDComplex* D2, tDComplex* D3, tDComplex V0, tDComplex V1, tDComplex V2, tDComplex V3)
 {
-    while ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>2)
-    {
-        Radix_08R_DIT(this_FFT);
-    }
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>1)
-    {
-        Radix_04R_DIT(this_FFT);
-    }
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>0)
+    tDComplex Y0 = (V0 + V2);
+    tDComplex Y1 = (V1 + V3);
+    tDComplex Y2 = (V0 - V2);
+    tDComplex Y3 = (V1 - V3).divided_by_i();
+
+    *D0 = (Y0 + Y1);
+    *D1 = (Y2 + Y3);
+    *D2 = (Y0 - Y1);
+    *D3 = (Y2 - Y3);
+}
+
+
+template <int32_t LENGTH_BITS, int32_t BLOCK_BITS>
+static inline void Radix_04F_T(tDComplex* DComplex)
+{
+    const int32_t DataStride = 1 << BLOCK_BITS;
+    const int32_t BlockLength = DataStride << 2;
+    const tDComplex* this_A_Arr = A_Arr[BLOCK_BITS + 2];
+
+    for (int32_t i = 0; i < (1 << LENGTH_BITS); i += BlockLength)
     {
-        Radix_02R_DIT(this_FFT);
+        tDComplex* D0 = &DComplex[i];
+        tDComplex* D1 = D0 + DataStride;
+        tDComplex* D2 = D0 + (DataStride << 1);
+        tDComplex* D3 = D1 + (DataStride << 1);
+
+        Butterfly_04F(D0, D1, D2, D3, D0[0], D2[0], D1[0], D3[0]);
+
+        for (int32_t n = 1; n < DataStride; n++)
+        {
+            Butterfly_04F(&D0[n], &D1[n], &D2[n], &D3[n], D0[n], D2[n] * this_A_Arr[n], D1[n] * this_A_Arr[n << 1], D3[n] * this_A_Arr[n * 3]);
+        }
     }
 }
 
-#endif
 
+static inline void Butterfly_08F(tDComplex* D0, tDComplex* D1, tDComplex* D2, tDComplex* D3, tDComplex* D4, tDComplex* D5, tDComplex* D6, tDComplex* D7,
+                                 tDComplex V0, tDComplex V1, tDComplex V2, tDComplex V3, tDComplex V4, tDComplex V5, tDComplex V6, tDComplex V7)
+{
+    tDComplex X0 = (V0 + V4);
+    tDComplex X1 = (V1 + V7);
+    tDComplex X2 = (V2 + V6);
+    tDComplex X3 = (V3 + V5);
+    tDComplex X4 = (V0 - V4);
+    tDComplex X5 = (V1 - V7);
+    tDComplex X6 = (V2 - V6);
+    tDComplex X7 = (V3 - V5);
 
-#ifdef FACTOR_16
-void FFT_DIT_01(FFT_Proc_Rec* this_FFT)     { Radix_02FS_DIT(this_FFT); }
-void FFT_DIT_02(FFT_Proc_Rec* this_FFT)     { Radix_04FS_DIT(this_FFT); }
-void FFT_DIT_03(FFT_Proc_Rec* this_FFT)     { Radix_08FS_DIT(this_FFT); }
-void FFT_DIT_04(FFT_Proc_Rec* this_FFT)     { Radix_16FS_DIT(this_FFT); }
-void FFT_DIT_05(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_06(FFT_Proc_Rec* this_FFT)     { Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
-void FFT_DIT_07(FFT_Proc_Rec* this_FFT)     { Radix_16F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
-void FFT_DIT_08(FFT_Proc_Rec* this_FFT)     { Radix_16F_DIT(this_FFT); Radix_16F_DIT(this_FFT); }
-void FFT_DIT_09(FFT_Proc_Rec* this_FFT)     { Radix_16F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-void FFT_DIT_10(FFT_Proc_Rec* this_FFT)     { Radix_16F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
-void FFT_DIT_11(FFT_Proc_Rec* this_FFT)     { Radix_16F_DIT(this_FFT); Radix_16F_DIT(this_FFT); Radix_08F_DIT(this_FFT); }
-void FFT_DIT_12(FFT_Proc_Rec* this_FFT)     { Radix_16F_DIT(this_FFT); Radix_16F_DIT(this_FFT); Radix_16F_DIT(this_FFT); }
-void FFT_DIT_13(FFT_Proc_Rec* this_FFT)     { Radix_16F_DIT(this_FFT); Radix_16F_DIT(this_FFT); Radix_08F_DIT(this_FFT); Radix_04F_DIT(this_FFT); }
-
-void IFFT_DIT_01(FFT_Proc_Rec* this_FFT)    { Radix_02R_DIT(this_FFT); }
-void IFFT_DIT_02(FFT_Proc_Rec* this_FFT)    { Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_03(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); }
-void IFFT_DIT_04(FFT_Proc_Rec* this_FFT)    { Radix_16R_DIT(this_FFT); }
-void IFFT_DIT_05(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_06(FFT_Proc_Rec* this_FFT)    { Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); }
-void IFFT_DIT_07(FFT_Proc_Rec* this_FFT)    { Radix_16R_DIT(this_FFT); Radix_08R_DIT(this_FFT); }
-void IFFT_DIT_08(FFT_Proc_Rec* this_FFT)    { Radix_16R_DIT(this_FFT); Radix_16R_DIT(this_FFT); }
-void IFFT_DIT_09(FFT_Proc_Rec* this_FFT)    { Radix_16R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
-void IFFT_DIT_10(FFT_Proc_Rec* this_FFT)    { Radix_16R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_08R_DIT(this_FFT); }
-void IFFT_DIT_11(FFT_Proc_Rec* this_FFT)    { Radix_16R_DIT(this_FFT); Radix_16R_DIT(this_FFT); Radix_08R_DIT(this_FFT); }
-void IFFT_DIT_12(FFT_Proc_Rec* this_FFT)    { Radix_16R_DIT(this_FFT); Radix_16R_DIT(this_FFT); Radix_16R_DIT(this_FFT); }
-void IFFT_DIT_13(FFT_Proc_Rec* this_FFT)    { Radix_16R_DIT(this_FFT); Radix_16R_DIT(this_FFT); Radix_08R_DIT(this_FFT); Radix_04R_DIT(this_FFT); }
+    tDComplex Y0 = (X0 + X2);
+    tDComplex Y1 = (X1 + X3);
+    tDComplex Y2 = (X1 - X3) * cos_pi_over_32[8];
+    tDComplex Y3 = (X5 + X7) * cos_pi_over_32[8];
 
-void FFT_DIT_XX(FFT_Proc_Rec* this_FFT)
+    tDComplex Z1 = (X4 + Y2);
+    tDComplex Z2 = (X0 - X2);
+    tDComplex Z3 = (X4 - Y2);
+    tDComplex Z5 = (Y3 + X6).divided_by_i();
+    tDComplex Z6 = (X5 - X7).divided_by_i();
+    tDComplex Z7 = (Y3 - X6).divided_by_i();
+
+    *D0 = (Y0 + Y1);
+    *D1 = (Z1 + Z5);
+    *D2 = (Z2 + Z6);
+    *D3 = (Z3 + Z7);
+    *D4 = (Y0 - Y1);
+    *D5 = (Z3 - Z7);
+    *D6 = (Z2 - Z6);
+    *D7 = (Z1 - Z5);
+}
+
+
+template <int32_t LENGTH_BITS, int32_t BLOCK_BITS>
+static inline void Radix_08F_T(tDComplex* DComplex)
 {
-    while ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>3)
-    {
-        Radix_16F_DIT(this_FFT);
-    }
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>2)
-    {
-        Radix_08F_DIT(this_FFT);
-    }
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>1)
-    {
-        Radix_04F_DIT(this_FFT);
-    }
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>0)
+    const int32_t DataStride = 1 << BLOCK_BITS;
+    const int32_t BlockLength = DataStride << 3;
+    const tDComplex* this_A_Arr = A_Arr[BLOCK_BITS + 3];
+
+    for (int32_t i = 0; i < (1 << LENGTH_BITS); i += BlockLength)
     {
-        Radix_02F_DIT(this_FFT);
+        tDComplex* D0 = &DComplex[i];
+        tDComplex* D1 = D0 + DataStride;
+        tDComplex* D2 = D0 + (DataStride << 1);
+        tDComplex* D3 = D1 + (DataStride << 1);
+        tDComplex* D4 = D0 + (DataStride << 2);
+        tDComplex* D5 = D1 + (DataStride << 2);
+        tDComplex* D6 = D2 + (DataStride << 2);
+        tDComplex* D7 = D3 + (DataStride << 2);
+
+        Butterfly_08F(D0, D1, D2, D3, D4, D5, D6, D7, D0[0], D4[0], D2[0], D6[0], D1[0], D5[0], D3[0], D7[0]);
+
+        for (int32_t n = 1; n < DataStride; n++)
+        {
+            Butterfly_08F(&D0[n], &D1[n], &D2[n], &D3[n], &D4[n], &D5[n], &D6[n], &D7[n],
+                          D0[n], D4[n] * this_A_Arr[n], D2[n] * this_A_Arr[n << 1], D6[n] * this_A_Arr[n * 3],
+                          D1[n] * this_A_Arr[n << 2], D5[n] * this_A_Arr[n * 5], D3[n] * this_A_Arr[n * 6], D7[n] * this_A_Arr[n * 7]);
+        }
     }
 }
 
-void IFFT_DIT_XX(FFT_Proc_Rec* this_FFT)
+
+template <int32_t LENGTH_BITS, int32_t BLOCK_BITS, int32_t RADIX_BITS> struct Radix_F_T;
+
+template <int32_t LENGTH_BITS, int32_t BLOCK_BITS> struct Radix_F_T<LENGTH_BITS, BLOCK_BITS, 1>
+{
+    static inline void run(tDComplex* DComplex) { Radix_02F_T<LENGTH_BITS, BLOCK_BITS>(DComplex); }
+};
+
+template <int32_t LENGTH_BITS, int32_t BLOCK_BITS> struct Radix_F_T<LENGTH_BITS, BLOCK_BITS, 2>
+{
+    static inline void run(tDComplex* DComplex) { Radix_04F_T<LENGTH_BITS, BLOCK_BITS>(DComplex); }
+};
+
+template <int32_t LENGTH_BITS, int32_t BLOCK_BITS> struct Radix_F_T<LENGTH_BITS, BLOCK_BITS, 3>
 {
-    while ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>2)
+    static inline void run(tDComplex* DComplex) { Radix_08F_T<LENGTH_BITS, BLOCK_BITS>(DComplex); }
+};
+
+
+//=====================================================================================================================
+// Chain of stages, RADIX_BITS lists the radix of each stage in order, e.g. <10, 2, 2, 2, 2, 2> is five radix 4 stages.
+//=====================================================================================================================
+template <int32_t LENGTH_BITS, int32_t BLOCK_BITS, int32_t... RADIX_BITS> struct FFT_Stages_T;
+
+template <int32_t LENGTH_BITS, int32_t BLOCK_BITS> struct FFT_Stages_T<LENGTH_BITS, BLOCK_BITS>
+{
+    static_assert(LENGTH_BITS == BLOCK_BITS, "FFT stages do not add up to the FFT bit length");
+
+    static inline void run(tDComplex*) { }
+};
+
+template <int32_t LENGTH_BITS, int32_t BLOCK_BITS, int32_t THIS_RADIX_BITS, int32_t... RADIX_BITS> struct FFT_Stages_T<LENGTH_BITS, BLOCK_BITS, THIS_RADIX_BITS, RADIX_BITS...>
+{
+    static inline void run(tDComplex* DComplex)
     {
-        Radix_16R_DIT(this_FFT);
+        Radix_F_T<LENGTH_BITS, BLOCK_BITS, THIS_RADIX_BITS>::run(DComplex);
+        FFT_Stages_T<LENGTH_BITS, BLOCK_BITS + THIS_RADIX_BITS, RADIX_BITS...>::run(DComplex);
     }
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>2)
+};
+
+template <int32_t LENGTH_BITS, int32_t... RADIX_BITS>
+static void FFT_DIT_T(FFT_Proc_Rec* this_FFT)
+{
+    if (LENGTH_BITS > nFFT_MAX_FFT_BIT_LENGTH)
+        throw(-1);
+
+    FFT_Stages_T<LENGTH_BITS, 0, RADIX_BITS...>::run(this_FFT->DComplex);
+
+    this_FFT->BlockBitLen = LENGTH_BITS;
+}
+
+
+//=====================================================================================================================
+// Candidate factorisations for 32 to 8192 point forward FFTs, selected per bit length by FFT_DIT_FACTORISATION in
+// nFFT_Factors.h. Shorter FFTs always use the single stage Radix_xxFS_DIT routines.
+//=====================================================================================================================
+const char* const FFT_DIT_Factorisation_Names[FFT_FACTORISATIONS] = { "4, then 8", "4, then 2", "8, then 4" };
+
+void (* const FFT_DIT_Factorisations[FFT_FACTORISATIONS][FFT_FACTORISED_MAX_BIT_LENGTH + 1])(FFT_Proc_Rec*) =
+{
     {
-        Radix_08R_DIT(this_FFT);
-    }
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>1)
+        nullptr, FFT_DIT_01, FFT_DIT_02, FFT_DIT_03, FFT_DIT_04,
+        FFT_DIT_T<5, 2, 3>,
+        FFT_DIT_T<6, 2, 2, 2>,
+        FFT_DIT_T<7, 2, 2, 3>,
+        FFT_DIT_T<8, 2, 2, 2, 2>,
+        FFT_DIT_T<9, 2, 2, 2, 3>,
+        FFT_DIT_T<10, 2, 2, 2, 2, 2>,
+        FFT_DIT_T<11, 2, 2, 2, 2, 3>,
+        FFT_DIT_T<12, 2, 2, 2, 2, 2, 2>,
+        FFT_DIT_T<13, 2, 2, 2, 2, 2, 3>
+    },
     {
-        Radix_04R_DIT(this_FFT);
-    }
-    if ((this_FFT->NumberOfBitsNeeded-this_FFT->BlockBitLen)>0)
+        nullptr, FFT_DIT_01, FFT_DIT_02, FFT_DIT_03, FFT_DIT_04,
+        FFT_DIT_T<5, 2, 2, 1>,
+        FFT_DIT_T<6, 2, 2, 2>,
+        FFT_DIT_T<7, 2, 2, 2, 1>,
+        FFT_DIT_T<8, 2, 2, 2, 2>,
+        FFT_DIT_T<9, 2, 2, 2, 2, 1>,
+        FFT_DIT_T<10, 2, 2, 2, 2, 2>,
+        FFT_DIT_T<11, 2, 2, 2, 2, 2, 1>,
+        FFT_DIT_T<12, 2, 2, 2, 2, 2, 2>,
+        FFT_DIT_T<13, 2, 2, 2, 2, 2, 2, 1>
+    },
     {
-        Radix_02R_DIT(this_FFT);
+        nullptr, FFT_DIT_01, FFT_DIT_02, FFT_DIT_03, FFT_DIT_04,
+        FFT_DIT_T<5, 3, 2>,
+        FFT_DIT_T<6, 3, 3>,
+        FFT_DIT_T<7, 3, 2, 2>,
+        FFT_DIT_T<8, 3, 3, 2>,
+        FFT_DIT_T<9, 3, 3, 3>,
+        FFT_DIT_T<10, 3, 3, 2, 2>,
+        FFT_DIT_T<11, 3, 3, 3, 2>,
+        FFT_DIT_T<12, 3, 3, 3, 3>,
+        FFT_DIT_T<13, 3, 3, 3, 2, 2>
     }
-}
-
-#endif
+};
 
 
 //void (*  FFT_DIT[32+1])(FFT_Proc_Rec*) = {nullptr,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX};
 //void (* IFFT_DIT[32+1])(FFT_Proc_Rec*) = {nullptr, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX};
 
-void (*  FFT_DIT[32+1])(FFT_Proc_Rec*) = {nullptr,  FFT_DIT_01,  FFT_DIT_02,  FFT_DIT_03,  FFT_DIT_04,  FFT_DIT_05,  FFT_DIT_06,  FFT_DIT_07,  FFT_DIT_08,  FFT_DIT_09,  FFT_DIT_10,  FFT_DIT_11,  FFT_DIT_12,  FFT_DIT_13,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX};
+//=====================================================================================================================
+// FFT_DIT[1] to FFT_DIT[FFT_FACTORISED_MAX_BIT_LENGTH] are set by nFFT_Init from FFT_DIT_FACTORISATION.
+//=====================================================================================================================
+void (*  FFT_DIT[32+1])(FFT_Proc_Rec*) = {nullptr,  FFT_DIT_01,  FFT_DIT_02,  FFT_DIT_03,  FFT_DIT_04,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX,  FFT_DIT_XX};
 void (* IFFT_DIT[32+1])(FFT_Proc_Rec*) = {nullptr, IFFT_DIT_01, IFFT_DIT_02, IFFT_DIT_03, IFFT_DIT_04, IFFT_DIT_05, IFFT_DIT_06, IFFT_DIT_07, IFFT_DIT_08, IFFT_DIT_09, IFFT_DIT_10, IFFT_DIT_11, IFFT_DIT_12, IFFT_DIT_13, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX, IFFT_DIT_XX};
 
 
@@ -1921,6 +1921,129 @@ void FFT_DIT_Real(FFT_Proc_Rec* this_FFT_plan)
 }
 
 
+//==============================================================================
+// Single precision radix 2 FFT on interleaved Re, Im float pairs. Butterflies
+// are calculated two at a time using SSE where available.
+//==============================================================================
+static void FFT_DIT_Float_Complex(float* Z, int32_t bits)
+{
+    const int32_t length = 1 << bits;
+
+    for (int32_t sp_i = 1; sp_i < length; sp_i++)
+    {
+        int32_t sp_j = RevBits_Float[bits][sp_i];
+
+        if (sp_i < sp_j)
+        {
+            std::swap(Z[sp_i << 1], Z[sp_j << 1]);
+            std::swap(Z[(sp_i << 1) + 1], Z[(sp_j << 1) + 1]);
+        }
+    }
+
+    for (int32_t sp_i = 0; sp_i < length; sp_i += 2)
+    {
+        float* D0 = &Z[sp_i << 1];
+        float V_Re = D0[2];
+        float V_Im = D0[3];
+        D0[2] = D0[0] - V_Re;
+        D0[3] = D0[1] - V_Im;
+        D0[0] += V_Re;
+        D0[1] += V_Im;
+    }
+
+    for (int32_t stage = 2; stage <= bits; stage++)
+    {
+        const int32_t half = 1 << (stage - 1);
+        const float* W = A_Arr_Float[stage];
+
+        for (int32_t sp_i = 0; sp_i < length; sp_i += (half << 1))
+        {
+            float* D0 = &Z[sp_i << 1];
+            float* D1 = &Z[(sp_i + half) << 1];
+            int32_t n = 0;
+
+#if defined(__SSE__)
+            const __m128 sign = _mm_set_ps(1.0f, -1.0f, 1.0f, -1.0f);
+
+            for (; n + 1 < half; n += 2)
+            {
+                __m128 w = _mm_loadu_ps(&W[n << 1]);
+                __m128 b = _mm_loadu_ps(&D1[n << 1]);
+                __m128 a = _mm_loadu_ps(&D0[n << 1]);
+
+                __m128 w_re = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0));
+                __m128 w_im = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1));
+                __m128 b_swapped = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+
+                __m128 v = _mm_add_ps(_mm_mul_ps(b, w_re), _mm_mul_ps(_mm_mul_ps(b_swapped, w_im), sign));
+
+                _mm_storeu_ps(&D1[n << 1], _mm_sub_ps(a, v));
+                _mm_storeu_ps(&D0[n << 1], _mm_add_ps(a, v));
+            }
+#endif
+
+            for (; n < half; n++)
+            {
+                float b_Re = D1[n << 1];
+                float b_Im = D1[(n << 1) + 1];
+                float V_Re = b_Re * W[n << 1] - b_Im * W[(n << 1) + 1];
+                float V_Im = b_Im * W[n << 1] + b_Re * W[(n << 1) + 1];
+                D1[n << 1] = D0[n << 1] - V_Re;
+                D1[(n << 1) + 1] = D0[(n << 1) + 1] - V_Im;
+                D0[n << 1] += V_Re;
+                D0[(n << 1) + 1] += V_Im;
+            }
+        }
+    }
+}
+
+
+void FFT_DIT_Real_Float(FFT_Proc_Rec* this_FFT_plan)
+{
+    const int32_t bits = this_FFT_plan->NumberOfBitsNeeded - 1;
+
+    if ((bits < 1) || (bits >= nFFT_Float_MAX_FFT_BIT_LENGTH) || (this_FFT_plan->FReal == nullptr))
+        throw(-1);
+
+    float* Z = this_FFT_plan->FReal;
+    const float* this_A_Arr = A_Arr_Float[bits + 1];
+    const int32_t length = 1 << bits;
+
+    FFT_DIT_Float_Complex(Z, bits);
+
+    //========================================================================
+    // Resolve HalfN Real FFT Output to bins 0 to HalfN of the N point Real
+    // FFT, only the non-redundant half of the spectrum is written.
+    //========================================================================
+    for (int32_t D0 = 1; D0 <= (length >> 1); D0++)
+    {
+        int32_t D1 = length - D0;
+
+        float X0_Re = (Z[D0 << 1] + Z[D1 << 1]) * 0.5f;
+        float X0_Im = (Z[(D0 << 1) + 1] + Z[(D1 << 1) + 1]) * 0.5f;
+        float X1_Re = (Z[D0 << 1] - Z[D1 << 1]) * 0.5f;
+        float X1_Im = (Z[(D0 << 1) + 1] - Z[(D1 << 1) + 1]) * 0.5f;
+
+        float V_Re = X0_Im * this_A_Arr[D0 << 1] + X1_Re * this_A_Arr[(D0 << 1) + 1];
+        float V_Im = X0_Im * this_A_Arr[(D0 << 1) + 1] - X1_Re * this_A_Arr[D0 << 1];
+
+        Z[D0 << 1] = X0_Re + V_Re;
+        Z[(D0 << 1) + 1] = X1_Im + V_Im;
+
+        Z[D1 << 1] = X0_Re - V_Re;
+        Z[(D1 << 1) + 1] = V_Im - X1_Im;
+    }
+
+    float Z0_Re = Z[0];
+    float Z0_Im = Z[1];
+
+    Z[length << 1] = Z0_Re - Z0_Im;
+    Z[(length << 1) + 1] = 0;
+    Z[0] = Z0_Re + Z0_Im;
+    Z[1] = 0;
+}
+
+
 void nFFT_Init(int32_t desired_max_fft_bit_length)
 {
     nFFT_MAX_FFT_BIT_LENGTH = desired_max_fft_bit_length;
@@ -1928,6 +2051,11 @@ void nFFT_Init(int32_t desired_max_fft_bit_length)
     if (nFFT_MAX_FFT_BIT_LENGTH > 32)
         throw(-1);
 
+    for (int32_t nf_i = 1; nf_i <= FFT_FACTORISED_MAX_BIT_LENGTH; nf_i++)
+    {
+        FFT_DIT[nf_i] = FFT_DIT_Factorisations[FFT_DIT_FACTORISATION[nf_i]][nf_i];
+    }
+
     for (int32_t nf_i = 0; nf_i < 32; nf_i++)
     {
         cos_pi_over_32[nf_i] = std::cos(nf_i * OneOver[32] * Pi);
@@ -1980,6 +2108,62 @@ void nFFT_Init(int32_t desired_max_fft_bit_length)
     //=========================================================================================================================
 }
 
+void nFFT_Float_Init(int32_t desired_max_fft_bit_length)
+{
+    nFFT_Float_MAX_FFT_BIT_LENGTH = desired_max_fft_bit_length;
+
+    if (nFFT_Float_MAX_FFT_BIT_LENGTH > 32)
+        throw(-1);
+
+    //=========================================================================================================================
+    // Twiddle factors are calculated in double and then rounded, as for the double precision tables.
+    //=========================================================================================================================
+    for (int32_t nf_i = 0; nf_i <= nFFT_Float_MAX_FFT_BIT_LENGTH; nf_i++)
+    {
+        A_Arr_Float[nf_i] = new float[2 << nf_i];
+        RevBits_Float[nf_i] = new int32_t[1 << nf_i];
+
+        double delta = (-TwoPi) / (1 << nf_i);
+
+        for (int32_t nf_j = 0; nf_j < (1 << nf_i); nf_j++)
+        {
+            tDComplex this_twiddle = complex_exp(nf_j * delta);
+            A_Arr_Float[nf_i][nf_j << 1] = this_twiddle.Re;
+            A_Arr_Float[nf_i][(nf_j << 1) + 1] = this_twiddle.Im;
+        }
+
+        DATA32 sp_i, sp_j;
+        for (sp_i.Integer = 0; sp_i.Integer < (1 << nf_i); sp_i.Integer++)
+        {
+            sp_j.Bytes[3] = BitReversedLookupTable[sp_i.Bytes[0]];
+            sp_j.Bytes[2] = BitReversedLookupTable[sp_i.Bytes[1]];
+            sp_j.Bytes[1] = BitReversedLookupTable[sp_i.Bytes[2]];
+            sp_j.Bytes[0] = BitReversedLookupTable[sp_i.Bytes[3]];
+            sp_j.Cardinal >>= (32-nf_i);
+            RevBits_Float[nf_i][sp_i.Integer] = sp_j.Integer;
+        }
+    }
+    //=========================================================================================================================
+}
+
+void nFFT_Float_Cleanup()
+{
+    for (int32_t nf_i = 0; nf_i <= nFFT_Float_MAX_FFT_BIT_LENGTH; nf_i++)
+    {
+        if (A_Arr_Float[nf_i] != nullptr)
+        {
+            delete[] A_Arr_Float[nf_i];
+            A_Arr_Float[nf_i] = nullptr;
+        }
+
+        if (RevBits_Float[nf_i] != nullptr)
+        {
+            delete[] RevBits_Float[nf_i];
+            RevBits_Float[nf_i] = nullptr;
+        }
+    }
+}
+
 void nFFT_Cleanup()
 {
     for (int32_t nf_i = 0; nf_i <= nFFT_MAX_FFT_BIT_LENGTH; nf_i++)
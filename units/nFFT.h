@@ -44,6 +44,18 @@ void Radix_04_DIT(FFT_Proc_Rec*);
 void Radix_02_DIT(FFT_Proc_Rec*);
 //==============================================================================
 
+//==============================================================================
+// Compile-time specialised forward FFTs, one table per factorisation scheme,
+// indexed by bit length. nFFT_Init selects from these using the per bit length
+// choice in nFFT_Factors.h, generated by tools/fftfactors.cpp.
+//==============================================================================
+static const int32_t FFT_FACTORISATIONS = 3;
+static const int32_t FFT_FACTORISED_MAX_BIT_LENGTH = 13;
+
+extern const char* const FFT_DIT_Factorisation_Names[FFT_FACTORISATIONS];
+extern void (* const FFT_DIT_Factorisations[FFT_FACTORISATIONS][FFT_FACTORISED_MAX_BIT_LENGTH + 1])(FFT_Proc_Rec*);
+//==============================================================================
+
 //====================================================================
 
 inline long double Hann(int32_t Index, int32_t fft_bit_length)
@@ -71,6 +83,12 @@ void FFT_DIT_Complex(FFT_Proc_Rec*);
 //==============================================================================
 void FFT_DIT_Real(FFT_Proc_Rec*);
 
+//==============================================================================
+//  Single precision equivalent of FFT_DIT_Real operating on FReal. Only bins
+//  0 to N/2 of the result are written, as interleaved float Re, Im pairs.
+//==============================================================================
+void FFT_DIT_Real_Float(FFT_Proc_Rec*);
+
 //==============================================================================
 //  Calculates the (in place) Inverse n Fourier Transform of the array of
 //  complex numbers represented by FFT_Input to produce the output
@@ -88,4 +106,10 @@ void nFFT_Init(int32_t desired_max_fft_bit_length);
 //==============================================================================
 void nFFT_Cleanup();
 
+//==============================================================================
+// Initialise / free lookup tables for the single precision FFT routine.
+//==============================================================================
+void nFFT_Float_Init(int32_t desired_max_fft_bit_length);
+void nFFT_Float_Cleanup();
+
 #endif // nFFT_h
@@ -0,0 +1,18 @@
+//==============================================================================
+// Forward FFT factorisation per bit length, an index into FFT_DIT_Factorisations
+// (0 = radix 4 then 8, 1 = radix 4 then 2, 2 = radix 8 then 4). This table is
+// the only selection of forward factorisation: nFFT_Init copies it into
+// FFT_DIT for bit lengths 1 to FFT_FACTORISED_MAX_BIT_LENGTH.
+//
+// "make -f Makefile.unix fft-factors" times tools/fftfactors.cpp on the build
+// machine and writes its selection to fftfactors.h for comparison. Replacing
+// this file with it is a maintainer step and must be committed. The default
+// below is radix 4 then 8 throughout.
+//==============================================================================
+
+#ifndef nFFT_Factors_h_
+#define nFFT_Factors_h_
+
+static const int32_t FFT_DIT_FACTORISATION[13 + 1] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+#endif // nFFT_Factors_h_
@@ -31,6 +31,7 @@
 #include "nFillFFT.h"
 
 double* window_function[MAX_FFT_BIT_LENGTH + 1];
+float* window_function_float[MAX_FFT_BIT_LENGTH + 1];
 
 struct fill_fft_lookup_type
 {
@@ -73,6 +74,38 @@ double FillFFT_Input_From_WAVE(FFT_Proc_Rec* this_FFT_plan)
 }
 
 
+//============================================================================
+// Single precision equivalent of FillFFT_Input_From_WAVE for use with
+// FFT_DIT_Real_Float. DC offset and RMS are still accumulated in double.
+//============================================================================
+double FillFFT_Float_Input_From_WAVE(FFT_Proc_Rec* this_FFT_plan)
+{
+    double ff_k = 0;
+    double ff_l = 0;
+    int32_t ff_n = (Global.Codec_Block.Size << 1) + this_FFT_plan->Task.block_start;
+    float* this_window_function = window_function_float[this_FFT_plan->FFT->bit_length];
+
+    for (int32_t ff_i = 0; ff_i<this_FFT_plan->FFT->length; ff_i++)
+    {
+        int32_t ff_j = ff_i + ff_n;
+        float ff_m = AudioData.WAVEPTR[fill_fft_lookup[ff_j].block][Current.Channel][fill_fft_lookup[ff_j].offset].Integers[0] * settings.scaling_factor;
+        ff_k+= ff_m;
+        this_FFT_plan->FReal[ff_i] = ff_m;
+    }
+
+    float ff_average = ff_k * this_FFT_plan->FFT->length_recip * settings.dccorrect_multiplier;
+
+    for (int32_t ff_i = 0; ff_i < this_FFT_plan->FFT->length; ff_i++)
+    {
+        float ff_m = this_FFT_plan->FReal[ff_i] - ff_average;
+        ff_l+= ff_m * ff_m;
+        this_FFT_plan->FReal[ff_i] = ff_m * this_window_function[ff_i];
+    }
+
+    return nlog2(ff_l * this_FFT_plan->FFT->length_recip) * 0.50f;
+}
+
+
 double FillFFT_Input_From_BTRD(FFT_Proc_Rec* this_FFT_plan)
 {
     double ff_m;
@@ -160,6 +193,21 @@ void nFillFFT_Init()
         }
     }
     //=========================================================================================================================
+    // Single precision copies of the window function arrays for --analysis-precision float / compare.
+    //=========================================================================================================================
+    if (parameters.fft.precision != ANALYSIS_PRECISION_DOUBLE)
+    {
+        for (int32_t nf_i = 1; nf_i <= MAX_FFT_BIT_LENGTH; nf_i++)
+        {
+            window_function_float[nf_i] = new float[1 << nf_i];
+
+            for (int32_t nf_j = 0; nf_j < 1 << nf_i; nf_j++)
+            {
+                window_function_float[nf_i][nf_j] = window_function[nf_i][nf_j];
+            }
+        }
+    }
+    //=========================================================================================================================
 }
 
 void nFillFFT_Cleanup()
@@ -173,6 +221,11 @@ void nFillFFT_Cleanup()
         {
             delete[] window_function[ff_i];
         }
+
+        if (window_function_float[ff_i] != nullptr)
+        {
+            delete[] window_function_float[ff_i];
+        }
     }
     //=========================================================================================================================
 }
@@ -29,11 +29,13 @@
 #define nFillFFT_h_
 
 extern double* window_function[];
+extern float* window_function_float[];
 
 void nFillFFT_Init();
 void nFillFFT_Cleanup();
 
 double FillFFT_Input_From_WAVE(FFT_Proc_Rec*);
+double FillFFT_Float_Input_From_WAVE(FFT_Proc_Rec*);
 double FillFFT_Input_From_BTRD(FFT_Proc_Rec*);
 double FillFFT_Input_From_CORR(FFT_Proc_Rec*);
 
@@ -0,0 +1,1314 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "nIO.h"
+#include "nCore.h"
+#include "nTrace.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#endif // _WIN32
+
+
+//============================================================================
+// Defaults: a backend only overrides what its transport can do.
+//============================================================================
+uint64_t tIO_Backend::Read(void* buffpointer, uint64_t bytestoread)
+{
+    buffpointer = buffpointer;
+    bytestoread = bytestoread;
+    return 0;
+}
+
+
+bool tIO_Backend::Write(const void* buffpointer, uint64_t bytestowrite)
+{
+    buffpointer = buffpointer;
+    bytestowrite = bytestowrite;
+    return false;
+}
+
+
+bool tIO_Backend::Seek(uint64_t position)
+{
+    position = position;
+    return false;
+}
+
+
+uint8_t* tIO_Backend::Window(uint64_t bytestoread, uint64_t& bytesread)
+{
+    bytestoread = bytestoread;
+    bytesread = 0;
+    return nullptr;
+}
+
+
+bool tIO_Backend::Reserve(uint64_t bytestowrite)
+{
+    bytestowrite = bytestowrite;
+    return false;
+}
+
+
+bool tIO_Backend::Flush()
+{
+    return true;
+}
+
+
+bool tIO_Backend::Close()
+{
+    return Flush();
+}
+
+
+bool tIO_Backend::Is_File() const
+{
+    return false;
+}
+
+
+bool tIO_Backend::Is_Mapped() const
+{
+    return false;
+}
+
+
+#ifdef _WIN32
+//============================================================================
+// Standard input: keep reading until the request is satisfied, backing off
+// while the pipe is empty and giving up after 32 empty reads.
+//============================================================================
+uint64_t tIO_Stdin::Read(void* buffpointer, uint64_t bytestoread)
+{
+    uint64_t bytesthisread, bytesread, byteslefttoread;
+    uint64_t lastwinerror;
+
+    bytesread = 0;
+    Retries = 0;
+
+    while ((bytesread < bytestoread) && (!Broken))
+    {
+        byteslefttoread = bytestoread - bytesread;
+
+        std::cin.read(static_cast<char *>(buffpointer) + bytesread, byteslefttoread);
+
+        bytesthisread = std::cin.gcount();
+
+        if (std::cin.good())
+        {
+            lastwinerror = 0;
+        }
+        else
+        {
+            lastwinerror = GetLastError();
+        }
+
+        if (bytesthisread == 0)
+        {
+            ++ Retries;
+            Sleep(PowersOf.TwoX[TWO_OFFSET + std::min(7u, Retries) -11]*1000);
+        }
+        else
+        {
+            Retries = 0;
+        }
+
+        if ((lastwinerror == ERROR_BROKEN_PIPE) || (Retries == 32))
+        {
+            Broken = true;
+        }
+
+        bytesread += bytesthisread;
+    }
+
+    return bytesread;
+}
+#endif // _WIN32
+
+
+//============================================================================
+// Standard output.
+//============================================================================
+bool tIO_Stdout::Write(const void* buffpointer, uint64_t bytestowrite)
+{
+    std::cout.write(static_cast<const char *>(buffpointer), bytestowrite);
+
+    return !std::cout.bad();
+}
+
+
+bool tIO_Stdout::Flush()
+{
+    std::cout.flush();
+
+    return !std::cout.bad();
+}
+
+
+bool tIO_Stdout::Close()
+{
+    return Flush();
+}
+
+
+//============================================================================
+// std::fstream, used where POSIX descriptors are not available.
+//============================================================================
+bool tIO_FStream::Open(const std::string& thisname, bool forwriting)
+{
+    if (forwriting)
+    {
+        Stream.open(thisname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+    else
+    {
+        Stream.open(thisname.c_str(), std::ios::in | std::ios::binary);
+    }
+
+    return Stream.good();
+}
+
+
+uint64_t tIO_FStream::Read(void* buffpointer, uint64_t bytestoread)
+{
+    Stream.read((char *) buffpointer, bytestoread);
+
+    return Stream.gcount();
+}
+
+
+bool tIO_FStream::Write(const void* buffpointer, uint64_t bytestowrite)
+{
+    Stream.write((const char *) buffpointer, bytestowrite);
+
+    return !Stream.bad();
+}
+
+
+bool tIO_FStream::Seek(uint64_t position)
+{
+    Stream.seekp(position);
+
+    return !Stream.bad();
+}
+
+
+bool tIO_FStream::Flush()
+{
+    Stream.flush();
+
+    return !Stream.bad();
+}
+
+
+bool tIO_FStream::Close()
+{
+    if (Stream.is_open())
+    {
+        Stream.close();
+    }
+
+    return !Stream.bad();
+}
+
+
+#ifndef _WIN32
+//============================================================================
+// POSIX file descriptor. Reads block until data arrives and only come up
+// short at end of file; a descriptor in non-blocking mode is waited on with
+// poll() rather than retried.
+//============================================================================
+bool tIO_Fd::Wait(short events)
+{
+    struct pollfd thispoll;
+
+    thispoll.fd = fd;
+    thispoll.events = events;
+    thispoll.revents = 0;
+
+    while (poll(&thispoll, 1, -1) < 0)
+    {
+        if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool tIO_Fd::Retry_After_Error()
+{
+    if (errno == EINTR)
+    {
+        return true;
+    }
+
+    if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+    {
+        return Wait(Writing ? POLLOUT : POLLIN);
+    }
+
+    return false;
+}
+
+
+tIO_Fd::~tIO_Fd()
+{
+    Close();
+}
+
+
+bool tIO_Fd::Allocate_Buffer()
+{
+    void* thisbuffer = nullptr;
+
+    if (posix_memalign(&thisbuffer, IO_BUFFER_ALIGN, IO_BUFFER_SIZE) != 0)
+    {
+        return false;
+    }
+
+    Buffer = static_cast<uint8_t*>(thisbuffer);
+
+    return true;
+}
+
+
+//============================================================================
+// Use an already open descriptor, e.g. STDIN_FILENO. It is left open by
+// Close().
+//============================================================================
+bool tIO_Fd::Attach(int thisfd, bool forwriting)
+{
+    fd = thisfd;
+    Owns_fd = false;
+    Writing = forwriting;
+
+    return Allocate_Buffer();
+}
+
+
+bool tIO_Fd::Open(const std::string& thisname, bool forwriting)
+{
+    Writing = forwriting;
+
+    if (forwriting)
+    {
+        fd = open(thisname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    }
+    else
+    {
+        fd = open(thisname.c_str(), O_RDONLY);
+    }
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (!forwriting)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+
+    Owns_fd = true;
+
+    if (!Allocate_Buffer())
+    {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+
+uint64_t tIO_Fd::Read(void* buffpointer, uint64_t bytestoread)
+{
+    uint8_t* pB = static_cast<uint8_t*>(buffpointer);
+    uint64_t bytesread = std::min(bytestoread, Used - Next);
+    ssize_t  bytesthisread;
+
+    std::memcpy(pB, Buffer + Next, bytesread);
+    Next += bytesread;
+
+    while ((bytesread < bytestoread) && (!Failed))
+    {
+        if (bytestoread - bytesread >= IO_DIRECT_SIZE)
+        {
+            bytesthisread = read(fd, pB + bytesread, bytestoread - bytesread);      // large requests bypass Buffer.
+        }
+        else
+        {
+            bytesthisread = read(fd, Buffer, IO_BUFFER_SIZE);
+        }
+
+        if (bytesthisread < 0)
+        {
+            Failed = !Retry_After_Error();
+            continue;
+        }
+
+        if (bytesthisread == 0)
+        {
+            break;
+        }
+
+        if (bytestoread - bytesread >= IO_DIRECT_SIZE)
+        {
+            bytesread += bytesthisread;
+        }
+        else
+        {
+            Used = bytesthisread;
+            Next = std::min(Used, bytestoread - bytesread);
+            std::memcpy(pB + bytesread, Buffer, Next);
+            bytesread += Next;
+        }
+    }
+
+    return bytesread;
+}
+
+
+bool tIO_Fd::Write_All(const uint8_t* buffpointer, uint64_t bytestowrite)
+{
+    ssize_t byteswritten;
+
+    while ((bytestowrite > 0) && (!Failed))
+    {
+        byteswritten = write(fd, buffpointer, bytestowrite);
+
+        if (byteswritten < 0)
+        {
+            Failed = !Retry_After_Error();
+            continue;
+        }
+
+        buffpointer += byteswritten;
+        bytestowrite -= byteswritten;
+    }
+
+    return !Failed;
+}
+
+
+//============================================================================
+// Anything still held in Buffer and the caller's block go out together in
+// one writev(), so large blocks are never copied into Buffer first.
+//============================================================================
+bool tIO_Fd::Write_Vector(const uint8_t* buffpointer, uint64_t bytestowrite)
+{
+    struct iovec thisiov[2];
+    int     first = 0;
+    ssize_t byteswritten;
+
+    thisiov[0].iov_base = Buffer;
+    thisiov[0].iov_len = Used;
+    thisiov[1].iov_base = const_cast<uint8_t*>(buffpointer);
+    thisiov[1].iov_len = bytestowrite;
+
+    if (Used == 0)
+    {
+        first = 1;
+    }
+
+    while ((first < 2) && (!Failed))
+    {
+        byteswritten = writev(fd, &thisiov[first], 2 - first);
+
+        if (byteswritten < 0)
+        {
+            Failed = !Retry_After_Error();
+            continue;
+        }
+
+        while ((first < 2) && (uint64_t(byteswritten) >= thisiov[first].iov_len))
+        {
+            byteswritten -= thisiov[first].iov_len;
+            ++ first;
+        }
+
+        if (first < 2)
+        {
+            thisiov[first].iov_base = static_cast<uint8_t*>(thisiov[first].iov_base) + byteswritten;
+            thisiov[first].iov_len -= byteswritten;
+        }
+    }
+
+    Used = 0;
+
+    return !Failed;
+}
+
+
+bool tIO_Fd::Write(const void* buffpointer, uint64_t bytestowrite)
+{
+    if (bytestowrite >= IO_DIRECT_SIZE)
+    {
+        return Write_Vector(static_cast<const uint8_t*>(buffpointer), bytestowrite);
+    }
+
+    if (Used + bytestowrite > IO_BUFFER_SIZE)
+    {
+        if (!Flush())
+        {
+            return false;
+        }
+    }
+
+    std::memcpy(Buffer + Used, buffpointer, bytestowrite);
+    Used += bytestowrite;
+
+    return true;
+}
+
+
+bool tIO_Fd::Seek(uint64_t position)
+{
+    if (!Flush())
+    {
+        return false;
+    }
+
+    Used = 0;
+    Next = 0;
+
+    return (lseek(fd, position, SEEK_SET) == off_t(position));
+}
+
+
+bool tIO_Fd::Reserve(uint64_t bytestowrite)
+{
+#ifdef FALLOC_FL_KEEP_SIZE
+    off_t position = lseek(fd, 0, SEEK_CUR);
+
+    if ((!Writing) || (position < 0))
+    {
+        return false;
+    }
+
+    return (fallocate(fd, FALLOC_FL_KEEP_SIZE, position + Used, bytestowrite) == 0);
+#else
+    bytestowrite = bytestowrite;
+    return false;
+#endif
+}
+
+
+bool tIO_Fd::Flush()
+{
+    if ((Writing) && (Used > 0))
+    {
+        Write_All(Buffer, Used);
+        Used = 0;
+    }
+
+    return !Failed;
+}
+
+
+bool tIO_Fd::Close()
+{
+    if (fd >= 0)
+    {
+        Flush();
+
+        if ((Owns_fd) && (close(fd) != 0))
+        {
+            Failed = true;
+        }
+
+        fd = -1;
+    }
+
+    if (Buffer != nullptr)
+    {
+        free(Buffer);
+        Buffer = nullptr;
+    }
+
+    return !Failed;
+}
+#endif // _WIN32
+
+
+#ifdef HAVE_MMAP
+//============================================================================
+// Memory mapped file.
+//============================================================================
+tIO_Mmap::~tIO_Mmap()
+{
+    Close();
+}
+
+
+bool tIO_Mmap::Open(const std::string& thisname)
+{
+    struct stat st;
+    void* thisdata;
+    int fd = open(thisname.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if ((fstat(fd, &st) != 0) || (!S_ISREG(st.st_mode)) || (st.st_size <= 0))
+    {
+        close(fd);
+        return false;
+    }
+
+    thisdata = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (thisdata == MAP_FAILED)
+    {
+        return false;
+    }
+
+    madvise(thisdata, st.st_size, MADV_SEQUENTIAL);
+
+    Data = (uint8_t*) thisdata;
+    Size = st.st_size;
+    Pos = 0;
+    Released = 0;
+
+    return true;
+}
+
+
+uint64_t tIO_Mmap::Read(void* buffpointer, uint64_t bytestoread)
+{
+    uint64_t bytesread = std::min(bytestoread, Size - Pos);
+
+    std::memcpy(buffpointer, Data + Pos, bytesread);
+    Pos += bytesread;
+
+    return bytesread;
+}
+
+
+bool tIO_Mmap::Seek(uint64_t position)
+{
+    Pos = std::min(position, Size);
+
+    return (Pos == position);
+}
+
+
+uint8_t* tIO_Mmap::Window(uint64_t bytestoread, uint64_t& bytesread)
+{
+    static const uint64_t page_mask = uint64_t(sysconf(_SC_PAGESIZE)) - 1;
+
+    uint8_t* window = Data + Pos;
+    uint64_t release_to = Pos & ~page_mask;
+
+    if (release_to > Released)
+    {
+        madvise(Data + Released, release_to - Released, MADV_DONTNEED);
+        Released = release_to;
+    }
+
+    bytesread = std::min(bytestoread, Size - Pos);
+    Pos += bytesread;
+
+    if (Pos < Size)
+    {
+        uint64_t ahead_from = Pos & ~page_mask;
+        madvise(Data + ahead_from, std::min(bytestoread, Size - ahead_from), MADV_WILLNEED);
+    }
+
+    return window;
+}
+
+
+bool tIO_Mmap::Close()
+{
+    if (Data != nullptr)
+    {
+        munmap(Data, Size);
+        Data = nullptr;
+        Size = 0;
+        Pos = 0;
+    }
+
+    return true;
+}
+#endif // HAVE_MMAP
+
+
+//============================================================================
+// Memory.
+//============================================================================
+tIO_Memory::tIO_Memory(const void* thisdata, uint64_t thissize)
+{
+    View = static_cast<const uint8_t*>(thisdata);
+    View_Size = thissize;
+}
+
+
+uint64_t tIO_Memory::Read(void* buffpointer, uint64_t bytestoread)
+{
+    uint64_t bytesread = std::min(bytestoread, Size() - Pos);
+
+    std::memcpy(buffpointer, Data() + Pos, bytesread);
+    Pos += bytesread;
+
+    return bytesread;
+}
+
+
+bool tIO_Memory::Write(const void* buffpointer, uint64_t bytestowrite)
+{
+    const uint8_t* pB = static_cast<const uint8_t*>(buffpointer);
+
+    if (View != nullptr)
+    {
+        return false;
+    }
+
+    if (Pos + bytestowrite > Owned.size())
+    {
+        Owned.resize(Pos + bytestowrite);
+    }
+
+    std::memcpy(Owned.data() + Pos, pB, bytestowrite);
+    Pos += bytestowrite;
+
+    return true;
+}
+
+
+bool tIO_Memory::Seek(uint64_t position)
+{
+    Pos = std::min(position, Size());
+
+    return (Pos == position);
+}
+
+
+uint8_t* tIO_Memory::Window(uint64_t bytestoread, uint64_t& bytesread)
+{
+    uint8_t* window = const_cast<uint8_t*>(Data()) + Pos;
+
+    bytesread = std::min(bytestoread, Size() - Pos);
+    Pos += bytesread;
+
+    return window;
+}
+
+
+//============================================================================
+// Callback sink.
+//============================================================================
+bool tIO_Callback::Write(const void* buffpointer, uint64_t bytestowrite)
+{
+    return Sink(Context, buffpointer, bytestowrite);
+}
+
+
+#ifdef HAVE_STD_THREAD
+//============================================================================
+// Read-ahead. Blocks are filled in turn by the helper; Lock guards Filled,
+// Stopping and Finished. The helper stops after the first short read.
+//============================================================================
+tIO_ReadAhead::tIO_ReadAhead(tIO_Backend* thisinner, uint64_t thisblocksize)
+    : Inner(thisinner), Block_Size(thisblocksize)
+{
+}
+
+
+tIO_ReadAhead::~tIO_ReadAhead()
+{
+    Stop();
+
+    delete[] Blocks[0].Data;
+    delete[] Blocks[1].Data;
+
+    if (Owns_Inner)
+    {
+        delete Inner;
+    }
+}
+
+
+bool tIO_ReadAhead::Start(bool owned)
+{
+    for (int32_t thisblock = 0; thisblock < 2; ++thisblock)
+    {
+        Blocks[thisblock].Data = new (std::nothrow) uint8_t[Block_Size];
+
+        if (Blocks[thisblock].Data == nullptr)
+        {
+            return false;
+        }
+    }
+
+    try
+    {
+        Worker = std::thread(&tIO_ReadAhead::Run, this);
+    }
+    catch (const std::system_error&)
+    {
+        return false;
+    }
+
+    Owns_Inner = owned;
+
+    return true;
+}
+
+
+void tIO_ReadAhead::Run()
+{
+    int32_t thisblock = 0;
+    uint64_t bytesread;
+    std::unique_lock<std::mutex> guard(Lock);
+
+    Trace_Thread_Name("read-ahead");
+
+    while (true)
+    {
+        Changed.wait(guard, [&] { return Stopping || (!Blocks[thisblock].Filled); });
+
+        if (Stopping)
+        {
+            break;
+        }
+
+        guard.unlock();
+        int64_t trace_read = Trace_Start();
+        bytesread = Inner->Read(Blocks[thisblock].Data, Block_Size);
+        Trace_Stop("read-ahead", trace_read);
+        guard.lock();
+
+        Blocks[thisblock].Size = bytesread;
+        Blocks[thisblock].Next = 0;
+        Blocks[thisblock].Filled = true;
+        Changed.notify_all();
+
+        if (bytesread < Block_Size)
+        {
+            break;
+        }
+
+        thisblock ^= 1;
+    }
+
+    Finished = true;
+    Changed.notify_all();
+}
+
+
+void tIO_ReadAhead::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        Stopping = true;
+    }
+
+    Changed.notify_all();
+
+    if (Worker.joinable())
+    {
+        Worker.join();
+    }
+}
+
+
+// Bytes left in the current block, handing it back to the helper and moving
+// on once it has been used up; 0 at end of input.
+uint64_t tIO_ReadAhead::Available()
+{
+    std::unique_lock<std::mutex> guard(Lock);
+    tBlock* thisblock = &Blocks[Current];
+
+    if ((thisblock->Filled) && (thisblock->Next == thisblock->Size))
+    {
+        if (thisblock->Size < Block_Size)
+        {
+            return 0;
+        }
+
+        thisblock->Filled = false;
+        Changed.notify_all();
+
+        Current ^= 1;
+        thisblock = &Blocks[Current];
+    }
+
+    if (!(thisblock->Filled || Finished))
+    {
+        int64_t trace_wait = Trace_Start();
+        Changed.wait(guard, [&] { return thisblock->Filled || Finished; });
+        Trace_Stop("wait for read-ahead", trace_wait);
+    }
+
+    return (thisblock->Filled) ? (thisblock->Size - thisblock->Next) : 0;
+}
+
+
+uint64_t tIO_ReadAhead::Read(void* buffpointer, uint64_t bytestoread)
+{
+    uint8_t* dest = (uint8_t*) buffpointer;
+    uint64_t bytesread = 0;
+    uint64_t available;
+
+    while (bytesread < bytestoread)
+    {
+        available = Available();
+
+        if (available == 0)
+        {
+            break;
+        }
+
+        tBlock& thisblock = Blocks[Current];
+        available = std::min(available, bytestoread - bytesread);
+
+        std::memcpy(dest + bytesread, thisblock.Data + thisblock.Next, available);
+        thisblock.Next += available;
+        bytesread += available;
+    }
+
+    return bytesread;
+}
+
+
+uint8_t* tIO_ReadAhead::Window(uint64_t bytestoread, uint64_t& bytesread)
+{
+    uint64_t available = Available();
+    tBlock& thisblock = Blocks[Current];
+    uint8_t* window = thisblock.Data + thisblock.Next;
+
+    if ((available < bytestoread) && (thisblock.Size == Block_Size))
+    {
+        bytesread = 0;
+        return nullptr;                       // straddles two blocks: the caller copies instead.
+    }
+
+    bytesread = std::min(available, bytestoread);
+    thisblock.Next += bytesread;
+
+    return window;
+}
+
+
+bool tIO_ReadAhead::Close()
+{
+    Stop();
+
+    return Inner->Close();
+}
+
+
+//============================================================================
+// Write-behind. Buffers are used in turn: Queued buffers from Draining on
+// belong to the writer, the one at Filling to the caller. Lock guards
+// Draining, Queued, Stopping and Failed.
+//============================================================================
+tIO_WriteBehind::tIO_WriteBehind(tIO_Backend* thisinner, uint64_t thisbuffersize)
+    : Inner(thisinner), Buffer_Size(thisbuffersize)
+{
+}
+
+
+tIO_WriteBehind::~tIO_WriteBehind()
+{
+    Stop();
+
+    for (int32_t thisbuffer = 0; thisbuffer < WRITE_BEHIND_BUFFERS; ++thisbuffer)
+    {
+        delete[] Buffers[thisbuffer].Data;
+    }
+
+    if (Owns_Inner)
+    {
+        delete Inner;
+    }
+}
+
+
+bool tIO_WriteBehind::Start(bool owned)
+{
+    for (int32_t thisbuffer = 0; thisbuffer < WRITE_BEHIND_BUFFERS; ++thisbuffer)
+    {
+        Buffers[thisbuffer].Data = new (std::nothrow) uint8_t[Buffer_Size];
+
+        if (Buffers[thisbuffer].Data == nullptr)
+        {
+            return false;
+        }
+    }
+
+    try
+    {
+        Worker = std::thread(&tIO_WriteBehind::Run, this);
+    }
+    catch (const std::system_error&)
+    {
+        return false;
+    }
+
+    Owns_Inner = owned;
+
+    return true;
+}
+
+
+void tIO_WriteBehind::Run()
+{
+    bool written;
+    std::unique_lock<std::mutex> guard(Lock);
+
+    Trace_Thread_Name("write-behind");
+
+    while (true)
+    {
+        Changed.wait(guard, [&] { return Stopping || (Queued > 0); });
+
+        if (Queued == 0)
+        {
+            break;
+        }
+
+        tBuffer& thisbuffer = Buffers[Draining];
+
+        guard.unlock();
+        int64_t trace_write = Trace_Start();
+        written = Inner->Write(thisbuffer.Data, thisbuffer.Used);
+        Trace_Stop("write-behind", trace_write);
+        guard.lock();
+
+        Failed = Failed || (!written);
+        thisbuffer.Used = 0;
+        Draining = (Draining + 1) % WRITE_BEHIND_BUFFERS;
+        Queued--;
+        Changed.notify_all();
+    }
+}
+
+
+void tIO_WriteBehind::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        Stopping = true;
+    }
+
+    Changed.notify_all();
+
+    if (Worker.joinable())
+    {
+        Worker.join();
+    }
+}
+
+
+// Queue the buffer being filled and wait for the next one to be free.
+void tIO_WriteBehind::Submit()
+{
+    std::unique_lock<std::mutex> guard(Lock);
+
+    Queued++;
+    Changed.notify_all();
+
+    Filling = (Filling + 1) % WRITE_BEHIND_BUFFERS;
+
+    if (Queued == WRITE_BEHIND_BUFFERS)
+    {
+        int64_t trace_wait = Trace_Start();
+        Changed.wait(guard, [&] { return Queued < WRITE_BEHIND_BUFFERS; });
+        Trace_Stop("wait for write-behind", trace_wait);
+    }
+}
+
+
+bool tIO_WriteBehind::Drain()
+{
+    if (Buffers[Filling].Used > 0)
+    {
+        Submit();
+    }
+
+    std::unique_lock<std::mutex> guard(Lock);
+
+    if (Queued > 0)
+    {
+        int64_t trace_wait = Trace_Start();
+        Changed.wait(guard, [&] { return Queued == 0; });
+        Trace_Stop("wait for write-behind", trace_wait);
+    }
+
+    return !Failed;
+}
+
+
+bool tIO_WriteBehind::Write(const void* buffpointer, uint64_t bytestowrite)
+{
+    const uint8_t* pB = static_cast<const uint8_t*>(buffpointer);
+    uint64_t thiscopy;
+
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+
+        if (Failed)
+        {
+            return false;
+        }
+    }
+
+    if (bytestowrite >= Buffer_Size)
+    {
+        return Drain() && Inner->Write(buffpointer, bytestowrite);
+    }
+
+    while (bytestowrite > 0)
+    {
+        tBuffer& thisbuffer = Buffers[Filling];
+
+        thiscopy = std::min(bytestowrite, Buffer_Size - thisbuffer.Used);
+        std::memcpy(thisbuffer.Data + thisbuffer.Used, pB, thiscopy);
+        thisbuffer.Used += thiscopy;
+        pB += thiscopy;
+        bytestowrite -= thiscopy;
+
+        if (thisbuffer.Used == Buffer_Size)
+        {
+            Submit();
+        }
+    }
+
+    return true;
+}
+
+
+bool tIO_WriteBehind::Seek(uint64_t position)
+{
+    return Drain() && Inner->Seek(position);
+}
+
+
+bool tIO_WriteBehind::Reserve(uint64_t bytestowrite)
+{
+    return Drain() && Inner->Reserve(bytestowrite);
+}
+
+
+bool tIO_WriteBehind::Flush()
+{
+    return Drain() && Inner->Flush();
+}
+
+
+bool tIO_WriteBehind::Close()
+{
+    bool closed_ok = Drain();
+
+    Stop();
+
+    return Inner->Close() && closed_ok;
+}
+#endif // HAVE_STD_THREAD
+
+
+//============================================================================
+// Backend selection: mapping, then descriptor, then std::fstream.
+//============================================================================
+tIO_Backend* nIO_Open_Input(const std::string& thisname)
+{
+#ifdef HAVE_MMAP
+    tIO_Mmap* thismmap = new (std::nothrow) tIO_Mmap;
+
+    if ((thismmap != nullptr) && (thismmap->Open(thisname)))
+    {
+        return thismmap;
+    }
+
+    delete thismmap;
+#endif
+
+#ifndef _WIN32
+    tIO_Fd* thisfd = new (std::nothrow) tIO_Fd;
+
+    if ((thisfd != nullptr) && (thisfd->Open(thisname, false)))
+    {
+        return thisfd;
+    }
+
+    delete thisfd;
+#endif
+
+    tIO_FStream* thisstream = new (std::nothrow) tIO_FStream;
+
+    if ((thisstream != nullptr) && (thisstream->Open(thisname, false)))
+    {
+        return thisstream;
+    }
+
+    delete thisstream;
+
+    return nullptr;
+}
+
+
+tIO_Backend* nIO_Open_Stdin()
+{
+#ifdef _WIN32
+    return new tIO_Stdin;
+#else
+    tIO_Fd* thisfd = new tIO_Fd;
+
+    if (!thisfd->Attach(STDIN_FILENO, false))
+    {
+        delete thisfd;
+        return nullptr;
+    }
+
+    return thisfd;
+#endif
+}
+
+
+tIO_Backend* nIO_Open_Stdout()
+{
+#ifdef _WIN32
+    return new tIO_Stdout;
+#else
+    tIO_Fd* thisfd = new tIO_Fd;
+
+    if (!thisfd->Attach(STDOUT_FILENO, true))
+    {
+        delete thisfd;
+        return nullptr;
+    }
+
+    return thisfd;
+#endif
+}
+
+
+tIO_Backend* nIO_Open_Output(const std::string& thisname)
+{
+#ifndef _WIN32
+    tIO_Fd* thisfd = new (std::nothrow) tIO_Fd;
+
+    if ((thisfd != nullptr) && (thisfd->Open(thisname, true)))
+    {
+        return thisfd;
+    }
+
+    delete thisfd;
+#endif
+
+    tIO_FStream* thisstream = new (std::nothrow) tIO_FStream;
+
+    if ((thisstream != nullptr) && (thisstream->Open(thisname, true)))
+    {
+        return thisstream;
+    }
+
+    delete thisstream;
+
+    return nullptr;
+}
+
+
+tIO_Backend* nIO_Read_Ahead(tIO_Backend* thisinner, bool owned, uint64_t thisblocksize)
+{
+#ifdef HAVE_STD_THREAD
+    tIO_ReadAhead* thisreadahead = new (std::nothrow) tIO_ReadAhead(thisinner, thisblocksize);
+
+    if (thisreadahead == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (!thisreadahead->Start(owned))
+    {
+        delete thisreadahead;
+        return nullptr;
+    }
+
+    return thisreadahead;
+#else
+    thisinner = thisinner;
+    owned = owned;
+    thisblocksize = thisblocksize;
+    return nullptr;
+#endif
+}
+
+
+tIO_Backend* nIO_Write_Behind(tIO_Backend* thisinner, bool owned, uint64_t thisbuffersize)
+{
+#ifdef HAVE_STD_THREAD
+    tIO_WriteBehind* thiswritebehind = new (std::nothrow) tIO_WriteBehind(thisinner, thisbuffersize);
+
+    if (thiswritebehind == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (!thiswritebehind->Start(owned))
+    {
+        delete thiswritebehind;
+        return nullptr;
+    }
+
+    return thiswritebehind;
+#else
+    thisinner = thisinner;
+    owned = owned;
+    thisbuffersize = thisbuffersize;
+    return nullptr;
+#endif
+}
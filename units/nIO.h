@@ -0,0 +1,356 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#ifndef nIO_h_
+#define nIO_h_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_STD_THREAD
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#endif
+
+//============================================================================
+// Byte transport underneath the RIFF chunk logic in nWav.cpp. A backend is
+// chosen per file when it is opened; all reads, writes and seeks of a WAV
+// file go through it.
+//============================================================================
+class tIO_Backend
+{
+public:
+    virtual ~tIO_Backend() {}
+
+    virtual uint64_t Read(void* buffpointer, uint64_t bytestoread);         // Bytes actually read; short only at end of input.
+
+    virtual bool     Write(const void* buffpointer, uint64_t bytestowrite);  // False if not all bytes could be written.
+
+    virtual bool     Seek(uint64_t position);                                // Absolute position; false if not seekable.
+
+    virtual uint8_t* Window(uint64_t bytestoread, uint64_t& bytesread);      // In-place access to the next bytes, advancing as Read would.
+                                                                             // nullptr if the backend cannot hand out its storage.
+
+    virtual bool     Reserve(uint64_t bytestowrite);                         // Allocate space for the next bytes ahead of writing them;
+                                                                             // the file size is unchanged. False if not supported.
+
+    virtual bool     Flush();
+
+    virtual bool     Close();                                                // False if the backend reported an error.
+
+    virtual bool     Is_File() const;
+
+    virtual bool     Is_Mapped() const;                                      // Window() always hands out the backend's own storage,
+                                                                             // so there is nothing to gain from reading ahead.
+};
+
+
+#ifdef _WIN32
+//============================================================================
+// Standard input through std::cin, for where there is no POSIX descriptor.
+//============================================================================
+class tIO_Stdin : public tIO_Backend
+{
+public:
+    uint64_t Read(void* buffpointer, uint64_t bytestoread);
+
+private:
+    uint32_t Retries = 0;
+    bool     Broken = false;
+};
+#endif // _WIN32
+
+
+class tIO_Stdout : public tIO_Backend
+{
+public:
+    bool Write(const void* buffpointer, uint64_t bytestowrite);
+    bool Flush();
+    bool Close();
+};
+
+
+class tIO_FStream : public tIO_Backend
+{
+public:
+    bool Open(const std::string& thisname, bool forwriting);
+
+    uint64_t Read(void* buffpointer, uint64_t bytestoread);
+    bool     Write(const void* buffpointer, uint64_t bytestowrite);
+    bool     Seek(uint64_t position);
+    bool     Flush();
+    bool     Close();
+    bool     Is_File() const { return true; }
+
+private:
+    std::fstream Stream;
+};
+
+
+#ifndef _WIN32
+//============================================================================
+// Unbuffered POSIX descriptor with its own large, page aligned buffer, so
+// that the many small header reads and writes do not each cost a system
+// call. Large blocks bypass the buffer in both directions.
+//============================================================================
+class tIO_Fd : public tIO_Backend
+{
+public:
+    ~tIO_Fd();
+
+    bool Open(const std::string& thisname, bool forwriting);
+    bool Attach(int thisfd, bool forwriting);
+
+    uint64_t Read(void* buffpointer, uint64_t bytestoread);
+    bool     Write(const void* buffpointer, uint64_t bytestowrite);
+    bool     Seek(uint64_t position);
+    bool     Reserve(uint64_t bytestowrite);
+    bool     Flush();
+    bool     Close();
+    bool     Is_File() const { return Owns_fd; }
+
+private:
+    static const uint64_t IO_BUFFER_SIZE = 1 << 20;
+    static const uint64_t IO_DIRECT_SIZE = 1 << 16;                         // requests this large bypass Buffer.
+    static const uint64_t IO_BUFFER_ALIGN = 4096;
+
+    int      fd = -1;
+    bool     Owns_fd = true;
+    bool     Writing = false;
+    bool     Failed = false;
+    uint8_t* Buffer = nullptr;
+    uint64_t Used = 0;                        // bytes held in Buffer.
+    uint64_t Next = 0;                        // next unread byte in Buffer (reading only).
+
+    bool     Allocate_Buffer();
+    bool     Wait(short events);
+    bool     Retry_After_Error();
+    bool     Write_All(const uint8_t* buffpointer, uint64_t bytestowrite);
+    bool     Write_Vector(const uint8_t* buffpointer, uint64_t bytestowrite);
+};
+#endif // _WIN32
+
+
+#ifdef HAVE_MMAP
+//============================================================================
+// Whole file mapped read-only. Window() hands out the mapping itself so that
+// sample data can be deinterleaved without being copied first; pages behind
+// the current window are released and the next window is requested ahead.
+//============================================================================
+class tIO_Mmap : public tIO_Backend
+{
+public:
+    ~tIO_Mmap();
+
+    bool Open(const std::string& thisname);
+
+    uint64_t Read(void* buffpointer, uint64_t bytestoread);
+    bool     Seek(uint64_t position);
+    uint8_t* Window(uint64_t bytestoread, uint64_t& bytesread);
+    bool     Close();
+    bool     Is_File() const { return true; }
+    bool     Is_Mapped() const { return true; }
+
+private:
+    uint8_t* Data = nullptr;
+    uint64_t Size = 0;
+    uint64_t Pos = 0;                         // next byte to be read.
+    uint64_t Released = 0;                    // bytes below this have been given back to the kernel.
+};
+#endif // HAVE_MMAP
+
+
+//============================================================================
+// Caller supplied input, or output collected in memory. For benchmarks,
+// tests and library use.
+//============================================================================
+class tIO_Memory : public tIO_Backend
+{
+public:
+    tIO_Memory() {}                                            // Empty, growing output buffer.
+    tIO_Memory(const void* thisdata, uint64_t thissize);       // Read-only view of thisdata; not copied, not freed.
+
+    uint64_t Read(void* buffpointer, uint64_t bytestoread);
+    bool     Write(const void* buffpointer, uint64_t bytestowrite);
+    bool     Seek(uint64_t position);
+    uint8_t* Window(uint64_t bytestoread, uint64_t& bytesread);
+    bool     Is_Mapped() const { return (View != nullptr); }
+
+    const uint8_t* Data() const { return (View != nullptr) ? View : Owned.data(); }
+    uint64_t       Size() const { return (View != nullptr) ? View_Size : Owned.size(); }
+
+private:
+    const uint8_t*       View = nullptr;
+    uint64_t             View_Size = 0;
+    std::vector<uint8_t> Owned;
+    uint64_t             Pos = 0;
+};
+
+
+//============================================================================
+// Output handed to a caller supplied function as it is produced. Not
+// seekable, so the header cannot be rewritten afterwards.
+//============================================================================
+typedef bool (*tIO_Sink)(void* context, const void* buffpointer, uint64_t bytestowrite);
+
+class tIO_Callback : public tIO_Backend
+{
+public:
+    tIO_Callback(tIO_Sink thissink, void* thiscontext) : Sink(thissink), Context(thiscontext) {}
+
+    bool Write(const void* buffpointer, uint64_t bytestowrite);
+
+private:
+    tIO_Sink Sink;
+    void*    Context;
+};
+
+
+#ifdef HAVE_STD_THREAD
+//============================================================================
+// Reads another input backend ahead on a helper thread: one block is filled
+// while the caller consumes the other. Window() hands out a block in place
+// when the request fits in what is left of it, which it always does when
+// every request is one block (or the remainder of the input).
+//============================================================================
+class tIO_ReadAhead : public tIO_Backend
+{
+public:
+    tIO_ReadAhead(tIO_Backend* thisinner, uint64_t thisblocksize);
+    ~tIO_ReadAhead();
+
+    bool Start(bool owned);                                   // Allocates the blocks and starts reading; false if either fails.
+                                                              // Once started, thisinner is deleted with this if owned.
+
+    uint64_t Read(void* buffpointer, uint64_t bytestoread);
+    uint8_t* Window(uint64_t bytestoread, uint64_t& bytesread);
+    bool     Close();
+    bool     Is_File() const { return Inner->Is_File(); }
+
+private:
+    struct tBlock
+    {
+        uint8_t* Data = nullptr;
+        uint64_t Size = 0;                    // bytes read into Data.
+        uint64_t Next = 0;                    // next byte to hand out.
+        bool     Filled = false;              // true: the caller's; false: the helper's to fill.
+    };
+
+    tIO_Backend* Inner;
+    bool         Owns_Inner = false;
+    uint64_t     Block_Size;
+    tBlock       Blocks[2];
+    int32_t      Current = 0;                 // block being consumed.
+    bool         Stopping = false;
+    bool         Finished = false;            // helper has read its last block.
+
+    std::thread             Worker;
+    std::mutex              Lock;
+    std::condition_variable Changed;
+
+    void     Run();
+    void     Stop();
+    uint64_t Available();
+};
+
+
+//============================================================================
+// Writes to another output backend from a helper thread. Write() copies into
+// the next free buffer of a small pool; full buffers are queued and written
+// in order, so only a full pool holds up the caller. A request of a whole
+// buffer or more is not copied: the queue is emptied and it is handed to the
+// inner backend directly, which can write it in place. Seek(), Reserve() and
+// Flush() wait for the queue to empty first. A failed write is reported by
+// the next Write(), Flush() or Close().
+//============================================================================
+class tIO_WriteBehind : public tIO_Backend
+{
+public:
+    tIO_WriteBehind(tIO_Backend* thisinner, uint64_t thisbuffersize);
+    ~tIO_WriteBehind();
+
+    bool Start(bool owned);                                   // Allocates the pool and starts the writer; false if either fails.
+                                                              // Once started, thisinner is deleted with this if owned.
+
+    bool Write(const void* buffpointer, uint64_t bytestowrite);
+    bool Seek(uint64_t position);
+    bool Reserve(uint64_t bytestowrite);
+    bool Flush();
+    bool Close();
+    bool Is_File() const { return Inner->Is_File(); }
+
+private:
+    static const int32_t WRITE_BEHIND_BUFFERS = 4;
+
+    struct tBuffer
+    {
+        uint8_t* Data = nullptr;
+        uint64_t Used = 0;
+    };
+
+    tIO_Backend* Inner;
+    bool         Owns_Inner = false;
+    uint64_t     Buffer_Size;
+    tBuffer      Buffers[WRITE_BEHIND_BUFFERS];
+    int32_t      Filling = 0;                 // buffer the caller is copying into.
+    int32_t      Draining = 0;                // oldest queued buffer.
+    int32_t      Queued = 0;                  // buffers handed to the writer and not yet written.
+    bool         Stopping = false;
+    bool         Failed = false;
+
+    std::thread             Worker;
+    std::mutex              Lock;
+    std::condition_variable Changed;
+
+    void Run();
+    void Stop();
+    void Submit();
+    bool Drain();
+};
+#endif // HAVE_STD_THREAD
+
+
+tIO_Backend* nIO_Open_Input(const std::string& thisname);     // Best available backend for a named file; nullptr on failure.
+
+tIO_Backend* nIO_Open_Stdin();                                // Blocking descriptor reader where available.
+
+tIO_Backend* nIO_Open_Stdout();                               // Buffered descriptor writer where available.
+
+tIO_Backend* nIO_Open_Output(const std::string& thisname);    // Creates / truncates thisname; nullptr on failure.
+
+tIO_Backend* nIO_Read_Ahead(tIO_Backend* thisinner, bool owned, uint64_t thisblocksize);
+                                                              // Reads thisinner ahead from its current position; nullptr if
+                                                              // not available, in which case thisinner is left untouched.
+
+tIO_Backend* nIO_Write_Behind(tIO_Backend* thisinner, bool owned, uint64_t thisbuffersize);
+                                                              // Writes to thisinner from a helper thread; nullptr as above.
+
+#endif // nIO_h_
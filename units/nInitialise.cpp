@@ -266,6 +266,19 @@ void nCheck_Switches()
         strings.parameter += NumToStr(parameters.fft.underlap);
     }
 
+    if (parameters.fft.precision == ANALYSIS_PRECISION_FLOAT)
+    {
+        strings.parameter += " --analysis-precision float";
+    }
+    else if (parameters.fft.precision == ANALYSIS_PRECISION_COMPARE)
+    {
+        strings.parameter += " --analysis-precision compare";
+    }
+    else
+    {
+        parameters.fft.precision = ANALYSIS_PRECISION_DOUBLE;
+    }
+
     if (parameters.feedback.rclips > -1)
     {
         strings.parameter += " --maxclips ";
@@ -311,6 +324,12 @@ void nInitial_Setup()
         strings.parameter += NumToStr(parameters.Static);
     }
 
+    if (parameters.output_bits != 0)
+    {
+        strings.parameter += " --output-bits ";
+        strings.parameter += NumToStr(parameters.output_bits);
+    }
+
     if (parameters.limit != -1)
     {
         Global.upper_freq_limit = std::min(floor(Global.sample_rate * 0.453515), parameters.limit * 1.0);
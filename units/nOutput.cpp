@@ -27,6 +27,8 @@
 
 #include <iostream>
 #include <cmath>
+#include <cstdio>
+#include <sstream>
 
 #if defined(_MSC_VER)
 #include <intrin.h>
@@ -39,11 +41,10 @@
 #include "nMaths.h"
 #include "nSpreading.h"
 #include "fftw_interface.h"
+#include "nPerfCounters.h"
 #include "nSGNS.h"
 #include "nParameter.h"
-
-// Global
-uint8_t* bit_removal_history;
+#include "nStatsJSON.h"
 
 const char hyphen_string[256] = "---------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------";
 const char bits_filled[256]   = "OOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOO";
@@ -73,6 +74,20 @@ int bar_length;
 std::string Titles [16];
 std::string Header;
 
+//============================================================================
+// --detail: rows of the bits-to-remove table are formatted as the codec-
+// blocks are processed and appended to a temporary file, so only the row
+// being filled is held in memory however long the input.
+//============================================================================
+struct
+{
+    std::FILE*  rows = nullptr;
+    std::string row;
+    double      row_total = 0;
+    uint64_t    entries = 0;                  // channel entries added so far.
+    uint64_t    per_row = 0;
+} Detail;
+
 
 void Make_Bars(int32_t MB_Width, int32_t MB_Item, int32_t MB_Value, int32_t MB_Count, int32_t MB_Summary = 0)
 {
@@ -121,14 +136,46 @@ void Make_Bars(int32_t MB_Width, int32_t MB_Item, int32_t MB_Value, int32_t MB_C
 }
 
 
+void Add_Bit_Removal_Detail(int32_t bits_removed)
+{
+    std::ostringstream this_entry;
+    uint64_t rb_l = Detail.entries % Detail.per_row;
+
+    if (rb_l == 0)
+    {
+        std::string time_string;
+
+        time_string_make(time_string, double(Detail.entries / Global.Channels) * Global.Codec_Block.Size / Global.sample_rate);
+        Detail.row_total = 0;
+        this_entry << '|' << time_string << '|';
+    }
+
+    Detail.row_total += bits_removed;
+    this_entry << std::setw(2) << bits_removed << (((Detail.entries % Global.Channels) == uint64_t(Global.Channels - 1)) ? '|' : ',');
+
+    if (rb_l == Detail.per_row - 1)
+    {
+        this_entry << std::fixed << std::setw(4) << std::setprecision(0) << Detail.row_total << '|' << std::endl;
+    }
+
+    Detail.row += this_entry.str();
+
+    if ((rb_l == Detail.per_row - 1) && (Detail.rows != nullptr))
+    {
+        std::fwrite(Detail.row.data(), 1, Detail.row.length(), Detail.rows);
+        Detail.row.clear();
+    }
+
+    ++ Detail.entries;
+}
+
+
 void remove_bits_detailed_output(std::ostream& ToOutput)
 {
     uint64_t rb_i, rb_l;
-    int32_t rb_j, rb_k;
     uint64_t ss_k;
     double btr_row_tot;
     int32_t channel;
-    std::string time_string;
     ToOutput << std::endl << "Detailed bits-to-remove data per channel per codec-block.\n";
     ss_k = (Display_Width - (8 + 2) - (4 + 1)) / (3 * Global.Channels);
     Titles[0] = "";
@@ -154,44 +201,26 @@ void remove_bits_detailed_output(std::ostream& ToOutput)
         }
 
     ToOutput << "Tot |" << std::endl << mid_bar << std::endl;
-    ss_k = ss_k * Global.Channels;
-    btr_row_tot = 0;
-    rb_j = 0;
+    ss_k = Detail.per_row;
+    btr_row_tot = Detail.row_total;
 
-    for (rb_i = 0; rb_i < Global.blocks_processed; rb_i ++)
-        for (channel = 0; channel < Global.Channels; channel ++)
-        {
-            rb_l = rb_j % ss_k;
+    if (Detail.rows != nullptr)
+    {
+        char buffer[65536];
+        size_t bytesread;
 
-            if (rb_l == 0)
-            {
-                time_string_make(time_string, double(rb_i) * Global.Codec_Block.Size / Global.sample_rate);
-                btr_row_tot = 0;
-                ToOutput << '|' << time_string << '|';
-            }
+        std::fflush(Detail.rows);
+        std::rewind(Detail.rows);
 
-            rb_k = bit_removal_history[rb_j];
-            btr_row_tot = btr_row_tot + rb_k;
-            ToOutput << std::setw(2) << rb_k;
+        while ((bytesread = std::fread(buffer, 1, sizeof(buffer), Detail.rows)) > 0)
+            ToOutput.write(buffer, bytesread);
 
-            if (channel == Global.Channels - 1)
-            {
-                ToOutput << '|';
-            }
-            else
-            {
-                ToOutput << ',';
-            }
-
-            if (rb_l == ss_k - 1)
-            {
-                ToOutput << std::fixed << std::setw(4) << std::setprecision(0) << btr_row_tot << '|' << std::endl;
-            }
+        std::fseek(Detail.rows, 0, SEEK_END);
+    }
 
-            ++ rb_j;
-        }
+    ToOutput << Detail.row;
 
-    rb_l = rb_j % ss_k;
+    rb_l = Detail.entries % ss_k;
 
     if ((rb_l < ss_k - 1) && (rb_l > 0))
     {
@@ -1250,6 +1279,27 @@ void Write_Min_Bin_Dist(std::ostream& ToOutput)
         }
 
     ToOutput << mid_bar << std::endl;
+    Titles[0] = "| FFT results re-used from a previous FFT at the same position";
+    Titles[1] = "";
+    Titles[2] = "";
+    Header = "";
+
+    Make_Bars(Display_Width, 4, 7, 1);
+    ToOutput << std::endl << "FFT Re-use Results, per analysis" << std::endl << top_bar
+             << std::endl << "|FFT " << Titles[0] << '|' << std::endl << mid_bar << std::endl;
+
+    for (nt_j = 1; nt_j <= PRECALC_ANALYSES; nt_j ++)
+        if (settings.analysis[nt_j].active)
+        {
+            Old_Percent = double(process.Analyses_Reused[nt_j]) / process.Analyses_Completed[nt_j] * 100;
+            Bar_Full_Len = nRoundEvenInt32(Old_Percent * bar_length * OneOver[100]);
+            Old_Bar_Str = std::string(bits_filled, Bar_Full_Len) + std::string(bits_empty, bar_length - Bar_Full_Len);
+            ToOutput << '|' << std::setw(4) << Current.Analysis.length[nt_j]
+                     << '|' << std::fixed << std::setw(6) << std::setprecision(2) << Old_Percent << "%|" << Old_Bar_Str
+                     << '|' << std::endl;
+        }
+
+    ToOutput << mid_bar << std::endl;
 }
 
 
@@ -1283,6 +1333,8 @@ void Process_Output()
 
         Global.last_print = Global.blocks_processed;
     }
+
+    nStatsJSON_Progress();
 }
 
 std::string SChar(int32_t SVal)
@@ -1392,6 +1444,22 @@ void Write_Results(std::ostream& ToOutput)
 
     ToOutput << std::endl;
 
+    if (parameters.fft.precision == ANALYSIS_PRECISION_COMPARE)
+    {
+        ToOutput << "Precision : float analysis bits-to-remove differs for " << process.Precision_Compare.FFTs_Differ << " of " << process.Precision_Compare.FFTs << " FFTs ("
+                 << std::fixed << std::setprecision(4) << (100.0 * process.Precision_Compare.FFTs_Differ / std::max(uint64_t(1), process.Precision_Compare.FFTs)) << "%)"
+                 << std::endl << "            and " << process.Precision_Compare.Blocks_Differ << " of " << process.Precision_Compare.Blocks << " codec-block channels ("
+                 << std::fixed << std::setprecision(4) << (100.0 * process.Precision_Compare.Blocks_Differ / std::max(uint64_t(1), process.Precision_Compare.Blocks)) << "%)." << std::endl;
+    }
+
+    if ((Stats.Cache.hits + Stats.Cache.misses) > 0)
+    {
+        ToOutput << "Cache     : " << Stats.Cache.hits << " hits; " << Stats.Cache.misses << " misses ("
+                 << std::fixed << std::setprecision(2) << (100.0 * Stats.Cache.hits / (Stats.Cache.hits + Stats.Cache.misses)) << "% of codec-blocks reused)." << std::endl;
+    }
+
+    Write_PerfCounters(ToOutput);
+
     if (parameters.output.freqdist)
     {
         for (int32_t this_analysis_number = 1; this_analysis_number < (PRECALC_ANALYSES + 1); this_analysis_number++)
@@ -1492,6 +1560,8 @@ void write_cleanup()
 
         close_log_file();
     }
+
+    nStatsJSON_Results();
 }
 
 
@@ -1523,4 +1593,26 @@ void nOutput_Init()
         parameters.output.width = 79;
     }
     Display_Width = parameters.output.width;
+
+    if (parameters.output.detail)
+    {
+        Detail.per_row = (Display_Width - (8 + 2) - (4 + 1)) / (3 * Global.Channels) * Global.Channels;
+        Detail.rows = std::tmpfile();
+
+        if (Detail.rows == nullptr)
+        {
+            lossyWAVWarning("Cannot create temporary file for bit-removal history.");
+            parameters.output.detail = false;
+        }
+    }
+}
+
+
+void nOutput_Cleanup()
+{
+    if (Detail.rows != nullptr)
+    {
+        std::fclose(Detail.rows);
+        Detail.rows = nullptr;
+    }
 }
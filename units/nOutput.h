@@ -28,15 +28,14 @@
 #ifndef nOutput_h_
 #define nOutput_h_
 
-static const size_t   bit_removal_history_array_size = 8388608;
-extern unsigned char* bit_removal_history;
-
 int Bit_Scan_Left(int32_t BSL_Int);
 int Bit_Scan_Right(int32_t BSR_Int);
 
 void nOutput_Init();
+void nOutput_Cleanup();
 void write_cleanup();
 void lsb_analysis();
 void Process_Output();
+void Add_Bit_Removal_Detail(int32_t bits_removed);   // --detail: each channel of each codec-block in turn.
 
 #endif // nOutput_h_
@@ -31,6 +31,12 @@
 #error Neither Windows API nor POSIX setpriority() seems to be available.
 #endif
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#endif
+
 #include <cstdlib>
 
 #include "nCore.h"
@@ -124,6 +130,19 @@ const char lossyWAV_advanced_help [] =
     "                     512) n.b. FFT lengths stated are for 44.1/48kHz audio,\n"
     "                     higher sample rates will automatically increase all FFT\n"
     "                     lengths as required.\n"
+    "    --analysis-cache <t>\n"
+    "                     keep the analysis of each codec-block in a cache file in\n"
+    "                     directory t, keyed on its audio and the settings, and\n"
+    "                     reuse it when the same audio is met again.\n"
+    "    --analysis-cache-size <n>\n"
+    "                     size limit in MiB of each cache file, oldest entries are\n"
+    "                     dropped first; the whole file is read into memory on\n"
+    "                     each run; (1 <= n <= 65536; default=256).\n"
+    "    --analysis-precision <t>\n"
+    "                     select precision of window, FFT and spreading\n"
+    "                     calculations: t = double (default), float or compare;\n"
+    "                     compare uses double and reports how often float would\n"
+    "                     have selected different bits-to-remove.\n"
     "-D, --dynamic <n>    select minimum_bits_to_keep_dynamic to n bits (default\n"
     "                     2.71 at -q X and 5.00 at -q I, 1.0 <= n <= 7.0.\n"
     "    --feedback [n]   enable experimental bit removal / adaptive noise shaping\n"
@@ -155,6 +174,21 @@ const char lossyWAV_advanced_help [] =
     "                     default=on; (DC offset calculated per FFT data set).\n"
     "-n, --noskew         disable application of low frequency level reduction prior\n"
     "                     to determination of bits-to-remove.\n"
+    "    --output-bits <n>\n"
+    "                     bit-depth of the integer PCM written when the input is\n"
+    "                     32-bit IEEE float; (n = 16, 24 or 32, default=24).\n"
+    "    --read-buffer <n>\n"
+    "                     size in KiB of each of the two buffers the input is read\n"
+    "                     ahead into; 0 disables read-ahead; (0 <= n <= 65536;\n"
+    "                     default=128, one codec-block when reading from STDIN).\n"
+    "    --replay-analysis <t>\n"
+    "                     take bits-to-remove and noise shaping filters from\n"
+    "                     analysis file t, made by --save-analysis from the same\n"
+    "                     audio and settings, instead of analysing the audio.\n"
+    "                     Analysis displays are not available when replaying.\n"
+    "    --save-analysis <t>\n"
+    "                     write bits-to-remove and noise shaping filters of each\n"
+    "                     codec-block to analysis file t.\n"
     "    --scale <n>      factor to scale audio by; (0.03125 < n <= 8.0; default=1).\n"
     "-s, --shaping        modify settings for noise shaping used in bit-removal:\n"
     "       a, altfilter  enable alternative adaptive shaping filter method.\n"
@@ -178,6 +212,11 @@ const char lossyWAV_advanced_help [] =
     "                     3<=n<=28, limited to bits-per-sample - 3).\n"
     "-U, --underlap <n>   enable underlap mode to increase number of FFT analyses\n"
     "                     performed at each FFT length, (n = 2, 4 or 8, default=2).\n"
+    "    --write-buffer <n>\n"
+    "                     size in KiB of each of the four buffers the output files\n"
+    "                     (not stdout) are written behind from; larger writes go\n"
+    "                     straight to the file; 0 disables write-behind;\n"
+    "                     (0 <= n <= 65536; default=1024).\n"
     "\n"
     "Output Options:\n"
     "\n"
@@ -189,12 +228,23 @@ const char lossyWAV_advanced_help [] =
     "                     'all' parameter displays all calculated analyses.\n"
     "-H, --histogram      show sample value histogram (input, lossy and correction).\n"
     "    --perchannel     show selected distribution data per channel.\n"
+    "    --perf-counters  show hardware performance counters per sample for each\n"
+    "                     processing stage (Linux perf events, where permitted).\n"
     "-p, --postanalyse    enable frequency analysis display of output and\n"
     "                     correction data in addition to input data.\n"
+    "    --progress-fd <n>\n"
+    "                     write progress about once a second to open file\n"
+    "                     descriptor n as one JSON object per line: samples\n"
+    "                     processed and total, rate, bits removed and ETA.\n"
     "    --sampledist     show distribution of lowest / highest significant bit of\n"
     "                     input samples and bit-removed samples.\n"
     "    --spread [full]  show detailed [more detailed] results from the spreading/\n"
     "                     averaging algorithm.\n"
+    "    --stats-json <t> append results, and progress while processing, to file t\n"
+    "                     as one JSON object per line.\n"
+    "    --trace <t>      write a timeline of the processing stages of each\n"
+    "                     codec-block and of the I/O threads to file t as Chrome\n"
+    "                     trace events (chrome://tracing, Perfetto).\n"
     "-W, --width <n>      select width of output options (79<=n<=255).\n"
     "\n"
     "System Options:\n"
@@ -635,6 +685,20 @@ bool check_parameter()
         return true;
     }
 
+    if (current_parameter == "--perf-counters")
+    {
+        parmError = "performance counter output";
+
+        if (parameters.output.perfcounters)
+        {
+            parmerror_multiple_selection();
+        }
+
+        parameters.output.perfcounters = true;
+
+        return true;
+    }
+
     if (current_parameter == "--bitdist")
     {
         parmError = "bits-to-remove distribution";
@@ -933,6 +997,70 @@ bool check_parameter()
         return true;
     }
 
+    if (current_parameter == "--progress-fd")
+    {
+        parmError = "progress file descriptor";
+
+        if (parameters.output.progressfd != -1)
+        {
+            parmerror_multiple_selection();
+        }
+
+        if (!GetNextParamStr())
+        {
+            parmerror_no_value_given();
+        }
+
+        if (!StringIsANumber(current_parameter))
+        {
+            parmerror_val_error();
+        }
+
+        parameters.output.progressfd = std::atoi(current_parameter.c_str());
+
+        check_permitted_values(parameters.output.progressfd, 1, 65535);
+
+        return true;
+    }
+
+    if (current_parameter == "--stats-json")
+    {
+        parmError = "JSON statistics file";
+
+        if (parameters.output.jsonfilename != "")
+        {
+            parmerror_multiple_selection();
+        }
+
+        if (!GetNextParamStr())
+        {
+            parmerror_no_value_given();
+        }
+
+        parameters.output.jsonfilename = current_parameter;
+
+        return true;
+    }
+
+    if (current_parameter == "--trace")
+    {
+        parmError = "trace file";
+
+        if (parameters.output.tracefilename != "")
+        {
+            parmerror_multiple_selection();
+        }
+
+        if (!GetNextParamStr())
+        {
+            parmerror_no_value_given();
+        }
+
+        parameters.output.tracefilename = current_parameter;
+
+        return true;
+    }
+
     if (current_parameter == "--stdinname")
     {
         parmError = "pseudo filename";
@@ -1629,6 +1757,40 @@ bool check_parameter()
         return true;
     }
 
+    if (current_parameter == "--analysis-precision")
+    {
+        parmError = "analysis precision";
+
+        if (parameters.fft.precision != -1)
+        {
+            parmerror_multiple_selection();
+        }
+
+        if (!GetNextParamStr())
+        {
+            parmerror_no_value_given();
+        }
+
+        if (current_parameter == "double")
+        {
+            parameters.fft.precision = ANALYSIS_PRECISION_DOUBLE;
+        }
+        else if (current_parameter == "float")
+        {
+            parameters.fft.precision = ANALYSIS_PRECISION_FLOAT;
+        }
+        else if (current_parameter == "compare")
+        {
+            parameters.fft.precision = ANALYSIS_PRECISION_COMPARE;
+        }
+        else
+        {
+            parmerror_val_error();
+        }
+
+        return true;
+    }
+
     if ((parmchar() == 'm') || (current_parameter == "--midside"))
     {
         parmError = "midside";
@@ -1671,6 +1833,158 @@ bool check_parameter()
         return true;
     }
 
+    if (current_parameter == "--output-bits")
+    {
+        parmError = "output bits";
+
+        if (parameters.output_bits != 0)
+        {
+            parmerror_multiple_selection();
+        }
+
+        if (!GetNextParamStr())
+        {
+            parmerror_no_value_given();
+        }
+
+        if (!StringIsANumber(current_parameter))
+        {
+            parmerror_val_error();
+        }
+
+        parameters.output_bits = std::atoi(current_parameter.c_str());
+
+        check_permitted_values(parameters.output_bits, 16, 32);
+
+        if ((parameters.output_bits & 7) != 0)
+        {
+            lossyWAVError("Permitted output bits values : 16, 24, 32", 0x31);
+        }
+
+        return true;
+    }
+
+    if (current_parameter == "--read-buffer")
+    {
+        parmError = "read buffer size";
+
+        if (parameters.read_buffer != -1)
+        {
+            parmerror_multiple_selection();
+        }
+
+        if (!GetNextParamStr())
+        {
+            parmerror_no_value_given();
+        }
+
+        if (!StringIsANumber(current_parameter))
+        {
+            parmerror_val_error();
+        }
+
+        parameters.read_buffer = std::atoi(current_parameter.c_str());
+
+        check_permitted_values(parameters.read_buffer, 0, 65536);
+
+        return true;
+    }
+
+    if (current_parameter == "--analysis-cache")
+    {
+        parmError = "analysis cache directory";
+
+        if (parameters.analysis_file.cache != "")
+        {
+            parmerror_multiple_selection();
+        }
+
+        if (!GetNextParamStr())
+        {
+            parmerror_no_value_given();
+        }
+
+        parameters.analysis_file.cache = current_parameter;
+
+        return true;
+    }
+
+    if (current_parameter == "--analysis-cache-size")
+    {
+        parmError = "analysis cache size";
+
+        if (parameters.analysis_file.cache_size != -1)
+        {
+            parmerror_multiple_selection();
+        }
+
+        if (!GetNextParamStr())
+        {
+            parmerror_no_value_given();
+        }
+
+        if (!StringIsANumber(current_parameter))
+        {
+            parmerror_val_error();
+        }
+
+        parameters.analysis_file.cache_size = std::atoi(current_parameter.c_str());
+
+        check_permitted_values(parameters.analysis_file.cache_size, 1, 65536);
+
+        return true;
+    }
+
+    if ((current_parameter == "--save-analysis") || (current_parameter == "--replay-analysis"))
+    {
+        parmError = "analysis file";
+
+        if ((parameters.analysis_file.save != "") || (parameters.analysis_file.replay != ""))
+        {
+            parmerror_multiple_selection();
+        }
+
+        std::string this_parameter = current_parameter;
+
+        if (!GetNextParamStr())
+        {
+            parmerror_no_value_given();
+        }
+
+        if (this_parameter == "--save-analysis")
+            parameters.analysis_file.save = current_parameter;
+        else
+            parameters.analysis_file.replay = current_parameter;
+
+        return true;
+    }
+
+    if (current_parameter == "--write-buffer")
+    {
+        parmError = "write buffer size";
+
+        if (parameters.write_buffer != -1)
+        {
+            parmerror_multiple_selection();
+        }
+
+        if (!GetNextParamStr())
+        {
+            parmerror_no_value_given();
+        }
+
+        if (!StringIsANumber(current_parameter))
+        {
+            parmerror_val_error();
+        }
+
+        parameters.write_buffer = std::atoi(current_parameter.c_str());
+
+        check_permitted_values(parameters.write_buffer, 0, 65536);
+
+        return true;
+    }
+
     if ((parmchar() == 'U') || (current_parameter == "--underlap"))
     {
         parmError = "underlap";
@@ -1726,6 +2040,7 @@ bool getParms()
     parameters.fft.analyses = 3;
     parameters.fft.underlap = 0;
     parameters.fft.dccorrect = true;
+    parameters.fft.precision = -1;
 
     parameters.feedback.active = false;
     parameters.feedback.numeric = -99;
@@ -1736,6 +2051,10 @@ bool getParms()
     parameters.feedback.verbose = false;
 
     parameters.output.logfilename = "";
+    parameters.output.jsonfilename = "";
+    parameters.output.tracefilename = "";
+    parameters.output.progressfd = -1;
+    parameters.output.progressdup = -1;
     parameters.shaping.active = true;
     parameters.shaping.warp = true;
     parameters.shaping.hybrid = false;
@@ -1751,10 +2070,18 @@ bool getParms()
     parameters.feedback.rclips = -1;
     parameters.help = 0;
     parameters.limit = -1;
+    parameters.output_bits = 0;
+    parameters.read_buffer = -1;
+    parameters.write_buffer = -1;
+    parameters.analysis_file.save = "";
+    parameters.analysis_file.replay = "";
+    parameters.analysis_file.cache = "";
+    parameters.analysis_file.cache_size = -1;
     parameters.Static = -1;
     parameters.dynamic = -1;
 
     parameters.output.perchannel = false;
+    parameters.output.perfcounters = false;
     parameters.output.bitdist = false;
     parameters.output.spread = -1;
     parameters.output.sampledist = false;
@@ -2058,6 +2385,12 @@ void nParameter_Init(int32_t argc, char* argv[])
             lossyWAVError("Correct parameter is incompatible\n"
                           "                   with STDOUT file output mode.", 0x31);
         }
+
+        if (parameters.output.progressfd == 1)
+        {
+            lossyWAVError("Progress file descriptor 1 is STDOUT,\n"
+                          "                   which is used for WAV output.", 0x31);
+        }
     }
     else
     {
@@ -2182,6 +2515,29 @@ void nParameter_Init(int32_t argc, char* argv[])
         }
     }
 
+    //========================================================================
+    // Take a copy of the progress descriptor before any file is opened, as
+    // a descriptor that is not open yet would be handed to one of the output
+    // files. The copy shares the caller's file status flags, which are left
+    // as they are.
+    //========================================================================
+    if (parameters.output.progressfd != -1)
+    {
+#ifdef _WIN32
+        if (_get_osfhandle(parameters.output.progressfd) != -1)
+        {
+            parameters.output.progressdup = _dup(parameters.output.progressfd);
+        }
+#else
+        parameters.output.progressdup = fcntl(parameters.output.progressfd, F_DUPFD_CLOEXEC, 3);
+#endif
+
+        if (parameters.output.progressdup == -1)
+        {
+            lossyWAVError("Progress file descriptor " + NumToStr(parameters.output.progressfd) + " is not open.", 0x31);
+        }
+    }
+
     if (parameters.output.logfilename == "")
     {
         parameters.output.logfilename = "lossyWAV.log";
@@ -2192,9 +2548,3 @@ void nParameter_Init(int32_t argc, char* argv[])
 
     parameters.output.logfilename = parameters.WavOutDir + parameters.output.logfilename;
 }
-
-void nParameter_Cleanup()
-{
-    if (bit_removal_history != nullptr)
-        delete[] bit_removal_history;
-}
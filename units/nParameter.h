@@ -35,8 +35,6 @@ extern std::ofstream LogOutput;
 
 void nParameter_Init(int32_t argc, char* argv[]);
 
-void nParameter_Cleanup();
-
 std::string WAVFilePrintName();
 void open_log_file();
 void close_log_file();
@@ -0,0 +1,382 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+
+#ifdef HAVE_PERF_EVENT_OPEN
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "nPerfCounters.h"
+#include "nCore.h"
+#include "nSupport.h"
+
+bool Perf_Counting = false;
+
+namespace {
+
+//============================================================================
+// One perf event group on the calling thread, user mode only, read with a
+// single read() at each stage boundary. Stages may nest: each keeps its own
+// starting snapshot. Counts are scaled by time enabled / time running, so
+// a multiplexed group still gives estimates. The read-ahead / write-behind
+// threads are not counted; Read and Write are this thread's share of I/O.
+//============================================================================
+enum {PERF_CYCLES, PERF_INSTRUCTIONS, PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_BRANCH_MISSES, PERF_COUNTERS};
+
+struct tPerf_Counter_Def
+{
+    const char* title;
+    const char* json;
+    uint32_t    type;
+    uint64_t    config;
+};
+
+#ifdef HAVE_PERF_EVENT_OPEN
+static const tPerf_Counter_Def Perf_Counter_Defs[PERF_COUNTERS] =
+{
+    {"    Cycles", "cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"    Instr.", "instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"  L1D miss", "l1d_misses",    PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"  LLC miss", "llc_misses",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"  Br. miss", "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+#else
+static const tPerf_Counter_Def Perf_Counter_Defs[PERF_COUNTERS] =
+{
+    {"    Cycles", "cycles",        0, 0},
+    {"    Instr.", "instructions",  0, 0},
+    {"  L1D miss", "l1d_misses",    0, 0},
+    {"  LLC miss", "llc_misses",    0, 0},
+    {"  Br. miss", "branch_misses", 0, 0},
+};
+#endif
+
+static const char* const Perf_Stage_Titles[PERF_STAGES] =
+{
+    "Codec-block", "Read", "FillFFT", "FFT", "Spreading", "Filter design", "Remove bits", "Post-analysis", "Write"
+};
+
+static const char* const Perf_Stage_JSON[PERF_STAGES] =
+{
+    "codec_block", "read", "fillfft", "fft", "spreading", "filter", "remove_bits", "postanalysis", "write"
+};
+
+struct tPerf_Snapshot
+{
+    uint64_t enabled;
+    uint64_t running;
+    uint64_t value[PERF_COUNTERS];
+};
+
+struct
+{
+    bool           used = false;
+    int            group_fd = -1;
+    int            fd[PERF_COUNTERS];
+    int32_t        slot[PERF_COUNTERS];     // position in the group read, -1 if not available.
+    int32_t        slots = 0;
+
+    tPerf_Snapshot start[PERF_STAGES];
+    double         total[PERF_STAGES][PERF_COUNTERS];
+    uint64_t       calls[PERF_STAGES];
+    uint64_t       unscheduled[PERF_STAGES];
+} Perf;
+
+
+#ifdef HAVE_PERF_EVENT_OPEN
+int Perf_Event_Open(const tPerf_Counter_Def& counter, int group_fd)
+{
+    perf_event_attr attr;
+
+    std::memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = counter.type;
+    attr.config = counter.config;
+    attr.disabled = (group_fd == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return int(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+#endif
+
+
+bool Perf_Read(tPerf_Snapshot& snapshot)
+{
+#ifdef HAVE_PERF_EVENT_OPEN
+    uint64_t buffer[3 + PERF_COUNTERS];
+    ssize_t bytes = read(Perf.group_fd, buffer, sizeof(buffer));
+
+    if (bytes < ssize_t((3 + Perf.slots) * sizeof(uint64_t)))
+        return false;
+
+    snapshot.enabled = buffer[1];
+    snapshot.running = buffer[2];
+
+    for (int32_t this_counter = 0; this_counter < PERF_COUNTERS; ++this_counter)
+        snapshot.value[this_counter] = (Perf.slot[this_counter] == -1) ? 0 : buffer[3 + Perf.slot[this_counter]];
+
+    return true;
+#else
+    snapshot = snapshot;
+    return false;
+#endif
+}
+
+
+void Write_Per_Sample(std::ostream& ToOutput, double value, int32_t width, int32_t precision)
+{
+    ToOutput << std::fixed << std::setw(width) << std::setprecision(precision) << value;
+}
+
+} // namespace
+
+
+void Perf_Counters_Start(int32_t stage)
+{
+    if (!Perf_Read(Perf.start[stage]))
+        Perf_Counting = false;
+}
+
+
+void Perf_Counters_Stop(int32_t stage)
+{
+    tPerf_Snapshot stop;
+
+    if (!Perf_Read(stop))
+    {
+        Perf_Counting = false;
+        return;
+    }
+
+    const tPerf_Snapshot& start = Perf.start[stage];
+    const uint64_t running = stop.running - start.running;
+
+    ++ Perf.calls[stage];
+
+    if (running == 0)
+    {
+        ++ Perf.unscheduled[stage];
+        return;
+    }
+
+    const double scale = double(stop.enabled - start.enabled) / running;
+
+    for (int32_t this_counter = 0; this_counter < PERF_COUNTERS; ++this_counter)
+        Perf.total[stage][this_counter] += scale * (stop.value[this_counter] - start.value[this_counter]);
+}
+
+
+void nPerfCounters_Init()
+{
+    for (int32_t this_stage = 0; this_stage < PERF_STAGES; ++this_stage)
+    {
+        Perf.calls[this_stage] = 0;
+        Perf.unscheduled[this_stage] = 0;
+
+        for (int32_t this_counter = 0; this_counter < PERF_COUNTERS; ++this_counter)
+            Perf.total[this_stage][this_counter] = 0;
+    }
+
+    for (int32_t this_counter = 0; this_counter < PERF_COUNTERS; ++this_counter)
+    {
+        Perf.fd[this_counter] = -1;
+        Perf.slot[this_counter] = -1;
+    }
+
+    if (!parameters.output.perfcounters)
+        return;
+
+#ifdef HAVE_PERF_EVENT_OPEN
+    //==========================================================================
+    // The first counter that opens leads the group; any other that cannot be
+    // opened (e.g. a cache event a virtual machine does not expose) is left
+    // out and reported as n/a.
+    //==========================================================================
+    int first_error = 0;
+
+    for (int32_t this_counter = 0; this_counter < PERF_COUNTERS; ++this_counter)
+    {
+        Perf.fd[this_counter] = Perf_Event_Open(Perf_Counter_Defs[this_counter], Perf.group_fd);
+
+        if (Perf.fd[this_counter] == -1)
+        {
+            if (first_error == 0)
+                first_error = errno;
+
+            continue;
+        }
+
+        if (Perf.group_fd == -1)
+            Perf.group_fd = Perf.fd[this_counter];
+
+        Perf.slot[this_counter] = Perf.slots++;
+    }
+
+    if (Perf.group_fd == -1)
+    {
+        lossyWAVWarning(std::string("Hardware performance counters not available (") + std::strerror(first_error)
+                        + (((first_error == EACCES) || (first_error == EPERM)) ? ", see /proc/sys/kernel/perf_event_paranoid" : "")
+                        + "), --perf-counters ignored.");
+        return;
+    }
+
+    ioctl(Perf.group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(Perf.group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    Perf.used = true;
+    Perf_Counting = true;
+#else
+    lossyWAVWarning("Hardware performance counters are not supported by this build, --perf-counters ignored.");
+#endif
+}
+
+
+void nPerfCounters_Close()
+{
+    Perf_Counting = false;
+
+#ifdef HAVE_PERF_EVENT_OPEN
+    if (Perf.group_fd != -1)
+        ioctl(Perf.group_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    for (int32_t this_counter = 0; this_counter < PERF_COUNTERS; ++this_counter)
+    {
+        if (Perf.fd[this_counter] != -1)
+            close(Perf.fd[this_counter]);
+
+        Perf.fd[this_counter] = -1;
+    }
+#endif
+
+    Perf.group_fd = -1;
+}
+
+
+//============================================================================
+// Counts per sample, i.e. per sample of one channel, with instructions per
+// cycle. Stages that never ran are left out.
+//============================================================================
+void Write_PerfCounters(std::ostream& ToOutput)
+{
+    if (!Perf.used)
+        return;
+
+    const double per_sample = 1.0 / std::max(int64_t(1), int64_t(Global.samples_processed) * Global.Channels);
+
+    ToOutput << "Counters  : per sample, user mode, processing thread only." << std::endl
+             << "  Stage          ";
+
+    for (int32_t this_counter = 0; this_counter < PERF_COUNTERS; ++this_counter)
+    {
+        ToOutput << Perf_Counter_Defs[this_counter].title;
+
+        if (this_counter == PERF_INSTRUCTIONS)
+            ToOutput << "   IPC";
+    }
+
+    ToOutput << std::endl;
+
+    for (int32_t this_stage = 0; this_stage < PERF_STAGES; ++this_stage)
+    {
+        if (Perf.calls[this_stage] == 0)
+            continue;
+
+        ToOutput << "  " << std::left << std::setw(15) << Perf_Stage_Titles[this_stage] << std::right;
+
+        for (int32_t this_counter = 0; this_counter < PERF_COUNTERS; ++this_counter)
+        {
+            if (Perf.slot[this_counter] == -1)
+                ToOutput << std::setw(10) << "n/a";
+            else
+                Write_Per_Sample(ToOutput, Perf.total[this_stage][this_counter] * per_sample, 10, (this_counter <= PERF_INSTRUCTIONS) ? 2 : 4);
+
+            if (this_counter == PERF_INSTRUCTIONS)
+            {
+                if ((Perf.slot[PERF_CYCLES] == -1) || (Perf.slot[PERF_INSTRUCTIONS] == -1) || (Perf.total[this_stage][PERF_CYCLES] <= 0))
+                    ToOutput << std::setw(6) << "n/a";
+                else
+                    Write_Per_Sample(ToOutput, Perf.total[this_stage][PERF_INSTRUCTIONS] / Perf.total[this_stage][PERF_CYCLES], 6, 2);
+            }
+        }
+
+        ToOutput << std::endl;
+    }
+
+    if (Perf.unscheduled[PERF_STAGE_CODEC_BLOCK] > 0)
+    {
+        ToOutput << "            counters were not scheduled for " << Perf.unscheduled[PERF_STAGE_CODEC_BLOCK] << " of "
+                 << Perf.calls[PERF_STAGE_CODEC_BLOCK] << " codec-blocks." << std::endl;
+    }
+}
+
+
+void Write_PerfCounters_JSON(std::ostream& ToOutput)
+{
+    if (!Perf.used)
+        return;
+
+    const double per_sample = 1.0 / std::max(int64_t(1), int64_t(Global.samples_processed) * Global.Channels);
+    bool first_stage = true;
+
+    ToOutput << ",\"perf_counters\":{";
+
+    for (int32_t this_stage = 0; this_stage < PERF_STAGES; ++this_stage)
+    {
+        if (Perf.calls[this_stage] == 0)
+            continue;
+
+        if (!first_stage)
+            ToOutput << ',';
+
+        first_stage = false;
+
+        ToOutput << '"' << Perf_Stage_JSON[this_stage] << "\":{\"calls\":" << Perf.calls[this_stage];
+
+        for (int32_t this_counter = 0; this_counter < PERF_COUNTERS; ++this_counter)
+        {
+            ToOutput << ",\"" << Perf_Counter_Defs[this_counter].json << "\":";
+
+            if (Perf.slot[this_counter] == -1)
+                ToOutput << "null";
+            else
+                ToOutput << std::fixed << std::setprecision(6) << (Perf.total[this_stage][this_counter] * per_sample);
+        }
+
+        ToOutput << '}';
+    }
+
+    ToOutput << '}';
+}
@@ -0,0 +1,78 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#ifndef nPerfCounters_h_
+#define nPerfCounters_h_
+
+#include <ostream>
+
+//============================================================================
+// --perf-counters: hardware performance counters (cycles, instructions, L1D
+// and last level cache misses, branch misses) of the processing thread,
+// attributed to the stages of each codec block and reported per sample.
+// Where perf events are not permitted (or not built in) a warning is given
+// and processing continues uncounted.
+//============================================================================
+
+enum tPerf_Stage
+{
+    PERF_STAGE_CODEC_BLOCK,         // everything below, plus output, caching, etc.
+    PERF_STAGE_READ,                // Shift_Codec_Blocks and readNextNextCodecBlock.
+    PERF_STAGE_FILLFFT,             // windowing / DC correction into the FFT input.
+    PERF_STAGE_FFT,
+    PERF_STAGE_SPREADING,
+    PERF_STAGE_FILTER,              // Make_Filter.
+    PERF_STAGE_REMOVE_BITS,         // Remove_Bits, including noise shaping.
+    PERF_STAGE_POSTANALYSIS,
+    PERF_STAGE_WRITE,               // writeNextBTRDcodecblock and writeNextCORRcodecblock.
+    PERF_STAGES
+};
+
+extern bool Perf_Counting;
+
+void Perf_Counters_Start(int32_t stage);
+void Perf_Counters_Stop(int32_t stage);
+
+inline void Perf_Start(int32_t stage)
+{
+    if (Perf_Counting)
+        Perf_Counters_Start(stage);
+}
+
+inline void Perf_Stop(int32_t stage)
+{
+    if (Perf_Counting)
+        Perf_Counters_Stop(stage);
+}
+
+void nPerfCounters_Init();          // before the main processing loop.
+void nPerfCounters_Close();         // after the main processing loop; totals are kept.
+
+void Write_PerfCounters(std::ostream& ToOutput);
+void Write_PerfCounters_JSON(std::ostream& ToOutput);   // ",\"perf_counters\":{...}", if counted.
+
+#endif // nPerfCounters_h_
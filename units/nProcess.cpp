@@ -34,6 +34,10 @@
 #include "nRemoveBits.h"
 #include "nOutput.h"
 #include "nProcess.h"
+#include "nAnalysisCache.h"
+#include "nAnalysisFile.h"
+#include "nPerfCounters.h"
+#include "nTrace.h"
 
 
 void Add_to_Unity(Results_Type* this_result)
@@ -90,24 +94,6 @@ void Zero_FFT_unity_results(Results_Type* this_result)
 }
 
 
-void Post_Process_FFT_Results(FFT_Proc_Rec* this_FFT_plan, Results_Type* this_result)
-{
-    for (int32_t sa_i = 0; sa_i <= Current.Analysis.upper_process_bin[Current.Analysis.number]; ++sa_i)
-    {
-        double sc_y = this_FFT_plan->DComplex[sa_i].magnitude();
-
-        this_result->LastRoot[sa_i] = sc_y;
-        this_result->Root[sa_i] += sc_y;
-
-        this_result->Skewed[sa_i] = sc_y * Skewing_Gain[sa_i << Current.FFT.bit_shift_from_max];
-
-        sc_y *= sc_y;
-        this_result->LastUnity[sa_i] = sc_y;
-        this_result->Unity[sa_i] += sc_y;
-    }
-}
-
-
 void Process_Data_to_History(FFT_Proc_Rec* this_FFT_plan, Results_Type* this_result)
 {
     Zero_FFT_unity_results(this_result);
@@ -155,6 +141,61 @@ void Process_Data_to_History(FFT_Proc_Rec* this_FFT_plan, Results_Type* this_res
 }
 
 
+//============================================================================
+// Single precision window, FFT and spreading of the current WAVE data. Root /
+// Unity results are only updated when this_result is given. The FFT is always
+// FFT_DIT_Real_Float, also when FFTW is loaded for the double analysis.
+//============================================================================
+void Process_Data_Float(FFT_Proc_Rec* this_FFT_plan, Results_Type* this_result)
+{
+    Perf_Start(PERF_STAGE_FILLFFT);
+
+    double filled = FillFFT_Float_Input_From_WAVE(this_FFT_plan);
+
+    Perf_Stop(PERF_STAGE_FILLFFT);
+
+    if (filled == 0)
+    {
+        if (this_result != nullptr)
+        {
+            Fill_Last_with_Zero(this_result);
+        }
+
+        spreading.old_minimum = Max_dB;
+        spreading.new_minimum = Max_dB;
+        spreading.alt_average = Max_dB;
+    }
+    else
+    {
+        Perf_Start(PERF_STAGE_FFT);
+
+        FFT_DIT_Real_Float(this_FFT_plan);
+
+        Perf_Stop(PERF_STAGE_FFT);
+
+        Perf_Start(PERF_STAGE_SPREADING);
+
+        Spreading_Function_Float(this_FFT_plan, this_result);
+
+        Perf_Stop(PERF_STAGE_SPREADING);
+    }
+}
+
+
+//============================================================================
+// Bits to remove indicated by the lowest of the current spreading results.
+//============================================================================
+int32_t Spreading_Bits_To_Remove()
+{
+    double Spreading_result = std::min(spreading.alt_average, std::min(spreading.new_minimum, spreading.old_minimum));
+
+    Spreading_result -= HannWindowRMS;
+    Spreading_result -= Spreading_result * (Spreading_result < 0);
+
+    return spreading.threshold_index[int(std::min((THRESHOLD_INDEX_SPREAD_RANGE - 1.0), Spreading_result) * THRESHOLD_INDEX_SPREAD)];
+}
+
+
 void Add_to_Histogram()
 {
     for (int32_t sa_j = 0; sa_j < Global.Channels; ++sa_j)
@@ -167,195 +208,311 @@ void Add_to_Histogram()
 }
 
 
-void Process_This_Codec_Block()
+//============================================================================
+// FFT analyses of the current channel down to its bits to remove, and the
+// adaptive noise shaping filter made from them. Returns the bits to remove
+// the float analyses chose (compare precision only).
+//============================================================================
+int32_t Analyse_This_Channel()
 {
-    int32_t this_channel;
     int32_t this_analysis_number;
     int32_t this_analysis_block_number;
-    int32_t codec_block_dependent_bits_to_remove;
-    int32_t local_channels;
     double Spreading_result;
-    double bits_removed_this_codec_block;
     int32_t Spreading_Used;
+    int32_t float_min_btr = 0;
 
-    process.limits.minstart = -(AudioData.Size.Prev+AudioData.Size.Last);
-    process.limits.maxend = (AudioData.Size.This+AudioData.Size.Next);
+    process.Channel_Data[Current.Channel].maximum_bits_to_remove = settings.static_maximum_bits_to_remove;
+    process.Channel_Data[Current.Channel].min_FFT_result.btr = settings.static_maximum_bits_to_remove;
+    process.Channel_Data[Current.Channel].min_FFT_result.analysis = 7;
 
-    codec_block_dependent_bits_to_remove = Global.bits_per_sample;
-    bits_removed_this_codec_block = 0;
+    process.dynamic_maximum_bits_to_remove = int(std::max(0.0, floor(AudioData.Channel_Log2_RMS[Current.Channel] - settings.dynamic_minimum_bits_to_keep)));
 
-    if (parameters.midside && (Global.Channels == 2))
-        local_channels = 4;
-    else
-        local_channels = Global.Channels;
+    if (process.dynamic_maximum_bits_to_remove < process.Channel_Data[Current.Channel].maximum_bits_to_remove)
+    {
+        process.Channel_Data[Current.Channel].maximum_bits_to_remove = process.dynamic_maximum_bits_to_remove;
+        process.Channel_Data[Current.Channel].min_FFT_result.btr = process.dynamic_maximum_bits_to_remove;
+        process.Channel_Data[Current.Channel].min_FFT_result.analysis = 8;
+    }
 
-    for (this_channel = 0; this_channel < local_channels; this_channel++)
+    float_min_btr = process.Channel_Data[Current.Channel].min_FFT_result.btr;
+
+    for (this_analysis_number = 1; this_analysis_number <= PRECALC_ANALYSES; ++this_analysis_number)
     {
-        Current.Channel = this_channel;
-        process.Channel_Data[Current.Channel].maximum_bits_to_remove = settings.static_maximum_bits_to_remove;
-        process.Channel_Data[Current.Channel].min_FFT_result.btr = settings.static_maximum_bits_to_remove;
-        process.Channel_Data[Current.Channel].min_FFT_result.analysis = 7;
+        Current.Analysis.number = this_analysis_number;
+        Current.FFT = FFT_PreCalc_Data_Rec[Current.Analysis.bits[Current.Analysis.number]];
 
-        process.dynamic_maximum_bits_to_remove = int(std::max(0.0, floor(AudioData.Channel_Log2_RMS[Current.Channel] - settings.dynamic_minimum_bits_to_keep)));
+        FFT_Proc_Rec this_FFT_plan;
+        this_FFT_plan.NumberOfBitsNeeded = Current.FFT.bit_length;
+        this_FFT_plan.FFT = &FFT_PreCalc_Data_Rec[Current.FFT.bit_length];
+        this_FFT_plan.FFT_Array = &FFT_Array;
 
-        if (process.dynamic_maximum_bits_to_remove < process.Channel_Data[Current.Channel].maximum_bits_to_remove)
-        {
-            process.Channel_Data[Current.Channel].maximum_bits_to_remove = process.dynamic_maximum_bits_to_remove;
-            process.Channel_Data[Current.Channel].min_FFT_result.btr = process.dynamic_maximum_bits_to_remove;
-            process.Channel_Data[Current.Channel].min_FFT_result.analysis = 8;
-        }
+        results.this_FFT_result.btr = 99;
+        results.this_FFT_result.spreading = Max_dB;
+        results.this_FFT_result.analysis = Current.Analysis.number;
 
-        for (this_analysis_number = 1; this_analysis_number <= PRECALC_ANALYSES; ++this_analysis_number)
-        {
-            Current.Analysis.number = this_analysis_number;
-            Current.FFT = FFT_PreCalc_Data_Rec[Current.Analysis.bits[Current.Analysis.number]];
+        Results_Type* this_result = &results.WAVE[Current.Analysis.number][Current.Channel];
 
-            FFT_Proc_Rec this_FFT_plan;
-            this_FFT_plan.NumberOfBitsNeeded = Current.FFT.bit_length;
-            this_FFT_plan.FFT = &FFT_PreCalc_Data_Rec[Current.FFT.bit_length];
-            this_FFT_plan.FFT_Array = &FFT_Array;
+        if (settings.analysis[this_analysis_number].active)
+        {
+            int64_t trace_analysis = Trace_Start();
 
-            results.this_FFT_result.btr = 99;
-            results.this_FFT_result.spreading = Max_dB;
-            results.this_FFT_result.analysis = Current.Analysis.number;
+            Zero_FFT_unity_results(this_result);
 
-            Results_Type* this_result = &results.WAVE[Current.Analysis.number][Current.Channel];
+            this_FFT_plan.Task.analyses_performed = 0;
 
-            if (settings.analysis[this_analysis_number].active)
+            for (this_analysis_block_number = 0; this_analysis_block_number <= process.analysis_blocks[Current.FFT.bit_length]; ++this_analysis_block_number)
             {
-                Zero_FFT_unity_results(this_result);
+                int32_t this_block_start = floor(process.actual_analysis_blocks_start[this_FFT_plan.FFT->bit_length] + this_analysis_block_number * process.FFT_underlap_length[this_FFT_plan.FFT->bit_length]);
+                this_FFT_plan.Task.block_start = std::min(std::max(this_block_start, process.limits.minstart),process.limits.maxend-this_FFT_plan.FFT->length);
+                this_FFT_plan.Task.analyses_performed++;
+
+                //============================================================================
+                // Re-use the last FFT performed for this analysis / channel if it started at
+                // the same absolute sample, i.e. the final FFT of the previous codec block or
+                // a repeated FFT where the start has been clamped at either end of the file.
+                //============================================================================
+                int64_t this_position = Global.samples_processed - AudioData.Size.This + this_FFT_plan.Task.block_start;
+                FFT_Spreading_Type* this_spreading = &process.FFT_spreading[Current.Analysis.number][Current.Channel];
+
+                if (this_position == this_spreading->position)
+                {
+                    Add_to_Unity(this_result);
 
-                this_FFT_plan.Task.analyses_performed = 0;
+                    spreading.old_minimum = this_spreading->old_minimum;
+                    spreading.new_minimum = this_spreading->new_minimum;
+                    spreading.alt_average = this_spreading->alt_average;
+                    process.old_min_bin = this_spreading->old_min_bin;
+                    process.new_min_bin = this_spreading->new_min_bin;
 
-                for (this_analysis_block_number = 0; this_analysis_block_number <= process.analysis_blocks[Current.FFT.bit_length]; ++this_analysis_block_number)
+                    ++ process.Analyses_Reused[Current.Analysis.number];
+                }
+                else if (parameters.fft.precision == ANALYSIS_PRECISION_FLOAT)
                 {
-                    int32_t this_block_start = floor(process.actual_analysis_blocks_start[this_FFT_plan.FFT->bit_length] + this_analysis_block_number * process.FFT_underlap_length[this_FFT_plan.FFT->bit_length]);
-                    this_FFT_plan.Task.block_start = std::min(std::max(this_block_start, process.limits.minstart),process.limits.maxend-this_FFT_plan.FFT->length);
-                    this_FFT_plan.Task.analyses_performed++;
+                    Process_Data_Float(&this_FFT_plan, this_result);
 
-                    if ((this_analysis_block_number == 0) && (!Global.first_codec_block))
+                    this_spreading->old_minimum = spreading.old_minimum;
+                    this_spreading->new_minimum = spreading.new_minimum;
+                    this_spreading->alt_average = spreading.alt_average;
+                    this_spreading->position = this_position;
+                }
+                else
+                {
+                    //============================================================================
+                    // Compare mode: the float analysis of the same data only supplies the bits
+                    // to remove it would have chosen; the double analysis is then used as normal.
+                    //============================================================================
+                    if (parameters.fft.precision == ANALYSIS_PRECISION_COMPARE)
                     {
-                        Add_to_Unity(this_result);
+                        Process_Data_Float(&this_FFT_plan, nullptr);
+                        this_spreading->float_btr = Spreading_Bits_To_Remove();
+                    }
+
+                    Perf_Start(PERF_STAGE_FILLFFT);
 
-                        spreading.old_minimum = process.FFT_spreading[Current.Analysis.number][Current.Channel].old_minimum;
-                        spreading.new_minimum = process.FFT_spreading[Current.Analysis.number][Current.Channel].new_minimum;
-                        spreading.alt_average = process.FFT_spreading[Current.Analysis.number][Current.Channel].alt_average;
+                    double filled = FillFFT_Input_From_WAVE(&this_FFT_plan);
+
+                    Perf_Stop(PERF_STAGE_FILLFFT);
+
+                    if (filled == 0)
+                    {
+                        Fill_Last_with_Zero(this_result);
+
+                        spreading.old_minimum = Max_dB;
+                        spreading.new_minimum = Max_dB;
+                        spreading.alt_average = Max_dB;
                     }
                     else
-                        if (FillFFT_Input_From_WAVE(&this_FFT_plan) == 0)
-                        {
-                            Fill_Last_with_Zero(this_result);
-
-                            spreading.old_minimum = Max_dB;
-                            spreading.new_minimum = Max_dB;
-                            spreading.alt_average = Max_dB;
-                        }
-                        else
-                        {
-                            if (FFTW_Initialised())
-                                FFTW.Execute_R2C_New_Array(FFTW.Plans[this_FFT_plan.FFT->bit_length],&this_FFT_plan.DReal[0],&this_FFT_plan.DReal[0]);
-                            else
-                                FFT_DIT_Real(&this_FFT_plan);
+                    {
+                        Perf_Start(PERF_STAGE_FFT);
 
-                            Post_Process_FFT_Results(&this_FFT_plan, this_result);
+                        if (FFTW_Initialised())
+                            FFTW.Execute_R2C_New_Array(FFTW.Plans[this_FFT_plan.FFT->bit_length],&this_FFT_plan.DReal[0],&this_FFT_plan.DReal[0]);
+                        else
+                            FFT_DIT_Real(&this_FFT_plan);
 
-                            Spreading_Function(this_result);
-                        }
+                        Perf_Stop(PERF_STAGE_FFT);
 
-                    Spreading_result = spreading.alt_average;
+                        Perf_Start(PERF_STAGE_SPREADING);
 
-                    Spreading_Used = 1;
+                        Spreading_Function_Fused(&this_FFT_plan, this_result);
 
-                    if (spreading.new_minimum < Spreading_result)
-                    {
-                        Spreading_result = spreading.new_minimum;
-                        Spreading_Used = 2;
+                        Perf_Stop(PERF_STAGE_SPREADING);
                     }
 
-                    if (spreading.old_minimum < Spreading_result)
-                    {
-                        Spreading_result = spreading.old_minimum;
-                        Spreading_Used = 3;
-                    }
+                    this_spreading->old_minimum = spreading.old_minimum;
+                    this_spreading->new_minimum = spreading.new_minimum;
+                    this_spreading->alt_average = spreading.alt_average;
+                    this_spreading->old_min_bin = process.old_min_bin;
+                    this_spreading->new_min_bin = process.new_min_bin;
+                    this_spreading->position = this_position;
+                }
 
-                    Spreading_result -= HannWindowRMS;
-                    Spreading_result -= Spreading_result * (Spreading_result < 0);
-                    results.this_FFT_result.spreading = Spreading_result;
-                    int32_t this_spreading_index = int(std::min((THRESHOLD_INDEX_SPREAD_RANGE - 1.0), Spreading_result) * THRESHOLD_INDEX_SPREAD);
-                    results.this_FFT_result.btr = spreading.threshold_index[this_spreading_index];
-                    results.this_FFT_result.start = this_FFT_plan.Task.block_start - Global.Codec_Block.Size;
-                    results.this_FFT_result.analysis = Current.Analysis.number;
+                Spreading_result = spreading.alt_average;
 
-                    if ((parameters.output.spread != -1))
+                Spreading_Used = 1;
+
+                if (spreading.new_minimum < Spreading_result)
+                {
+                    Spreading_result = spreading.new_minimum;
+                    Spreading_Used = 2;
+                }
+
+                if (spreading.old_minimum < Spreading_result)
+                {
+                    Spreading_result = spreading.old_minimum;
+                    Spreading_Used = 3;
+                }
+
+                Spreading_result -= HannWindowRMS;
+                Spreading_result -= Spreading_result * (Spreading_result < 0);
+                results.this_FFT_result.spreading = Spreading_result;
+                int32_t this_spreading_index = int(std::min((THRESHOLD_INDEX_SPREAD_RANGE - 1.0), Spreading_result) * THRESHOLD_INDEX_SPREAD);
+                results.this_FFT_result.btr = spreading.threshold_index[this_spreading_index];
+                results.this_FFT_result.start = this_FFT_plan.Task.block_start - Global.Codec_Block.Size;
+                results.this_FFT_result.analysis = Current.Analysis.number;
+
+                if ((parameters.output.spread != -1))
+                {
+                    switch (Spreading_Used)
                     {
-                        switch (Spreading_Used)
-                        {
-                            case 1:
-                                ++ process.Alt_Ave_Used[Current.Analysis.number];
-                                break;
-
-                            case 2:
-                                ++ process.New_Min_Used_History[Current.Analysis.number][process.new_min_bin];
-                                ++ process.New_Min_Used[Current.Analysis.number];
-                                break;
-
-                            case 3:
-                                ++ process.Old_Min_Used_History[Current.Analysis.number][process.old_min_bin];
-                                ++ process.Old_Min_Used[Current.Analysis.number];
-                                break;
-
-                            default:
-                                lossyWAVError("Invalid spreading result",0x99);
-                        }
-
-                        if (results.this_FFT_result.btr > settings.static_maximum_bits_to_remove)
-                            ++ process.Over_Static[Current.Analysis.number];
-
-                        if (results.this_FFT_result.btr > process.dynamic_maximum_bits_to_remove)
-                            ++ process.Over_Dynamic[Current.Analysis.number];
+                        case 1:
+                            ++ process.Alt_Ave_Used[Current.Analysis.number];
+                            break;
+
+                        case 2:
+                            ++ process.New_Min_Used_History[Current.Analysis.number][process.new_min_bin];
+                            ++ process.New_Min_Used[Current.Analysis.number];
+                            break;
+
+                        case 3:
+                            ++ process.Old_Min_Used_History[Current.Analysis.number][process.old_min_bin];
+                            ++ process.Old_Min_Used[Current.Analysis.number];
+                            break;
+
+                        default:
+                            lossyWAVError("Invalid spreading result",0x99);
                     }
 
-                    if ((results.this_FFT_result.btr < process.Channel_Data[Current.Channel].min_FFT_result.btr) || (process.Channel_Data[Current.Channel].min_FFT_result.btr == -1))
-                        process.Channel_Data[Current.Channel].min_FFT_result = results.this_FFT_result;
+                    if (results.this_FFT_result.btr > settings.static_maximum_bits_to_remove)
+                        ++ process.Over_Static[Current.Analysis.number];
+
+                    if (results.this_FFT_result.btr > process.dynamic_maximum_bits_to_remove)
+                        ++ process.Over_Dynamic[Current.Analysis.number];
                 }
 
-                if (Global.last_codec_block)
+                if ((results.this_FFT_result.btr < process.Channel_Data[Current.Channel].min_FFT_result.btr) || (process.Channel_Data[Current.Channel].min_FFT_result.btr == -1))
+                    process.Channel_Data[Current.Channel].min_FFT_result = results.this_FFT_result;
+
+                if (parameters.fft.precision == ANALYSIS_PRECISION_COMPARE)
                 {
-                    Add_to_Unity(this_result);
-                    this_FFT_plan.Task.analyses_performed++;
-                }
+                    ++ process.Precision_Compare.FFTs;
 
-                process.Analyses_Completed[Current.Analysis.number] += (this_FFT_plan.Task.analyses_performed);
+                    if (this_spreading->float_btr != results.this_FFT_result.btr)
+                        ++ process.Precision_Compare.FFTs_Differ;
 
-                Add_to_History(&this_FFT_plan, this_result);
+                    float_min_btr = std::min(float_min_btr, this_spreading->float_btr);
+                }
+            }
 
-                results.saved_FFT_results[Current.Channel][Current.Analysis.number] = results.this_FFT_result;
-                process.FFT_spreading[Current.Analysis.number][Current.Channel].old_minimum = spreading.old_minimum;
-                process.FFT_spreading[Current.Analysis.number][Current.Channel].new_minimum = spreading.new_minimum;
-                process.FFT_spreading[Current.Analysis.number][Current.Channel].alt_average = spreading.alt_average;
+            if (Global.last_codec_block)
+            {
+                Add_to_Unity(this_result);
+                this_FFT_plan.Task.analyses_performed++;
             }
-        }
 
+            process.Analyses_Completed[Current.Analysis.number] += (this_FFT_plan.Task.analyses_performed);
 
-        if ((parameters.shaping.active) && (!parameters.shaping.fixed))
-        {
-            Make_Filter(Current.Channel);
-        }
+            Add_to_History(&this_FFT_plan, this_result);
 
+            results.saved_FFT_results[Current.Channel][Current.Analysis.number] = results.this_FFT_result;
 
-        if (process.Channel_Data[Current.Channel].min_FFT_result.btr < 0)
-        {
-            process.Channel_Data[Current.Channel].min_FFT_result.btr = 0;
+            Trace_Stop("analysis", trace_analysis, Global.blocks_processed - 1, Current.Channel, Current.FFT.length);
         }
+    }
+
+
+    if ((parameters.shaping.active) && (!parameters.shaping.fixed))
+    {
+        int64_t trace_filter = Trace_Start();
+
+        Perf_Start(PERF_STAGE_FILTER);
+
+        Make_Filter(Current.Channel);
+
+        Perf_Stop(PERF_STAGE_FILTER);
+
+        Trace_Stop("filter design", trace_filter, Global.blocks_processed - 1, Current.Channel);
+    }
+
+
+    if (process.Channel_Data[Current.Channel].min_FFT_result.btr < 0)
+    {
+        process.Channel_Data[Current.Channel].min_FFT_result.btr = 0;
+    }
+
+    return float_min_btr;
+}
+
+
+void Process_This_Codec_Block()
+{
+    int32_t this_channel;
+    int32_t codec_block_dependent_bits_to_remove;
+    int32_t local_channels;
+    double bits_removed_this_codec_block;
+    int32_t float_min_btr = 0;
+    int64_t skipped_filters = Stats.Skipped_Filters;
+    bool analysed;
 
+    process.limits.minstart = -(AudioData.Size.Prev+AudioData.Size.Last);
+    process.limits.maxend = (AudioData.Size.This+AudioData.Size.Next);
+
+    codec_block_dependent_bits_to_remove = Global.bits_per_sample;
+    bits_removed_this_codec_block = 0;
+
+    if (Replaying_Analysis())
+    {
+        Replay_Analysis();
+        analysed = false;
+    }
+    else
+        analysed = !Find_Cached_Analysis();
+
+    if (parameters.midside && (Global.Channels == 2) && analysed)
+        local_channels = 4;
+    else
+        local_channels = Global.Channels;
+
+    for (this_channel = 0; this_channel < local_channels; this_channel++)
+    {
+        Current.Channel = this_channel;
+
+        if (analysed)
+            float_min_btr = Analyse_This_Channel();
 
         process.Channel_Data[Current.Channel].calc_bits_to_remove = process.Channel_Data[Current.Channel].min_FFT_result.btr;
+
+        if ((analysed) && (parameters.fft.precision == ANALYSIS_PRECISION_COMPARE))
+        {
+            ++ process.Precision_Compare.Blocks;
+
+            if (std::max(0, float_min_btr) != process.Channel_Data[Current.Channel].calc_bits_to_remove)
+                ++ process.Precision_Compare.Blocks_Differ;
+        }
         process.Channel_Data[Current.Channel].bits_to_remove = process.Channel_Data[Current.Channel].calc_bits_to_remove;
 
         if (Current.Channel < Global.Channels)
         {
+            int64_t trace_remove_bits = Trace_Start();
+
+            Perf_Start(PERF_STAGE_REMOVE_BITS);
+
             Remove_Bits();
 
+            Perf_Stop(PERF_STAGE_REMOVE_BITS);
+
+            Trace_Stop("remove bits", trace_remove_bits, Global.blocks_processed - 1, Current.Channel);
+
             codec_block_dependent_bits_to_remove = std::min(codec_block_dependent_bits_to_remove, process.Channel_Data[Current.Channel].calc_bits_to_remove);
         }
     }
@@ -372,7 +529,16 @@ void Process_This_Codec_Block()
                 if (Current.Channel < Global.Channels)
                 {
                     process.Channel_Data[Current.Channel].bits_to_remove = codec_block_dependent_bits_to_remove;
+
+                    int64_t trace_remove_bits = Trace_Start();
+
+                    Perf_Start(PERF_STAGE_REMOVE_BITS);
+
                     Remove_Bits();
+
+                    Perf_Stop(PERF_STAGE_REMOVE_BITS);
+
+                    Trace_Stop("remove bits", trace_remove_bits, Global.blocks_processed - 1, Current.Channel);
                 }
             }
         }
@@ -397,17 +563,27 @@ void Process_This_Codec_Block()
 
         if (parameters.output.detail)
         {
-            bit_removal_history[(Global.blocks_processed - 1) * Global.Channels + Current.Channel] = process.Channel_Data[Current.Channel].bits_removed;
+            Add_Bit_Removal_Detail(process.Channel_Data[Current.Channel].bits_removed);
         }
 
         bits_removed_this_codec_block += OneOver[Global.Channels] * process.Channel_Data[Current.Channel].bits_removed;
     }
 
+    if (analysed && Caching_Analysis())
+        Cache_Analysis(Stats.Skipped_Filters - skipped_filters);
+
+    if (Saving_Analysis())
+        Save_Analysis(Stats.Skipped_Filters - skipped_filters);
+
     //==========================================================================
     // Post analyse bit removed / correction audio data using uint16_t FFT.
     //==========================================================================
     if (parameters.output.postanalyse)
     {
+        int64_t trace_postanalysis = Trace_Start();
+
+        Perf_Start(PERF_STAGE_POSTANALYSIS);
+
         for (int32_t this_analysis_number = 1; this_analysis_number <= PRECALC_ANALYSES; ++this_analysis_number)
         {
             Current.Analysis.number = this_analysis_number;
@@ -441,6 +617,10 @@ void Process_This_Codec_Block()
                 }
             }
         }
+
+        Perf_Stop(PERF_STAGE_POSTANALYSIS);
+
+        Trace_Stop("post-analysis", trace_postanalysis, Global.blocks_processed - 1);
     }
 
 
@@ -462,15 +642,15 @@ void Process_This_Codec_Block()
 
 void nProcess_Initialise_Results_Arrays(Results_Type* this_result, int32_t this_analysis)
 {
-    this_result->History = new double[sizeof(double) * Current.Analysis.length[this_analysis]];
-    this_result->Unity = new double[sizeof(double) * Current.Analysis.length[this_analysis]];
-    this_result->LastUnity = new double[sizeof(double) * Current.Analysis.length[this_analysis]];
-    this_result->SGNSUnity = new double[sizeof(double) * Current.Analysis.length[this_analysis]];
-    this_result->Root = new double[sizeof(double) * Current.Analysis.length[this_analysis]];
-    this_result->LastRoot = new double[sizeof(double) * Current.Analysis.length[this_analysis]];
-    this_result->SGNSRoot = new double[sizeof(double) * Current.Analysis.length[this_analysis]];
-    this_result->SGNSHybrid = new double[sizeof(double) * Current.Analysis.length[this_analysis]];
-    this_result->Skewed = new double[sizeof(double) * Current.Analysis.length[this_analysis]];
+    this_result->History = new double[Current.Analysis.length[this_analysis]];
+    this_result->Unity = new double[Current.Analysis.length[this_analysis]];
+    this_result->LastUnity = new double[Current.Analysis.length[this_analysis]];
+    this_result->SGNSUnity = new double[Current.Analysis.length[this_analysis]];
+    this_result->Root = new double[Current.Analysis.length[this_analysis]];
+    this_result->LastRoot = new double[Current.Analysis.length[this_analysis]];
+    this_result->SGNSRoot = new double[Current.Analysis.length[this_analysis]];
+    this_result->SGNSHybrid = new double[Current.Analysis.length[this_analysis]];
+    this_result->Skewed = new double[Current.Analysis.length[this_analysis]];
 
     for (int32_t sa_k = 0; sa_k < Current.Analysis.length[this_analysis]; sa_k++)
     {
@@ -487,18 +667,30 @@ void nProcess_Initialise_Results_Arrays(Results_Type* this_result, int32_t this_
     this_result->Analyses_Performed = 0;
 }
 
+//============================================================================
+// Results arrays are only made for active analyses: WAVE for each channel
+// analysed (4 with --midside on 2 channel audio), BTRD and CORR only for
+// the analyses --postanalyse displays. Spreading bin histories only with
+// --spread.
+//============================================================================
 void nProcess_Init()
 {
     int32_t total_overlap_length;
+    int32_t analysed_channels = ((parameters.midside) && (Global.Channels == 2)) ? 4 : Global.Channels;
 
     for (int32_t this_analysis = 1; this_analysis <= PRECALC_ANALYSES; ++this_analysis)
     {
-        for (int32_t sa_i = 0; sa_i < int(MAX_FFT_LENGTH_HALF); ++sa_i)
+        if ((settings.analysis[this_analysis].active) && (parameters.output.spread != -1))
         {
-            process.Old_Min_Used_History[this_analysis][sa_i] = 0;
-            process.New_Min_Used_History[this_analysis][sa_i] = 0;
+            process.Old_Min_Used_History[this_analysis] = new uint64_t[MAX_FFT_LENGTH_HALF]();
+            process.New_Min_Used_History[this_analysis] = new uint64_t[MAX_FFT_LENGTH_HALF]();
         }
 
+        process.Analyses_Reused[this_analysis] = 0;
+
+        for (int32_t sa_i = 0; sa_i < MAX_CHANNELS; ++sa_i)
+            process.FFT_spreading[this_analysis][sa_i].position = -1;
+
         process.Old_Min_Used[this_analysis] = 0;
         process.New_Min_Used[this_analysis] = 0;
         process.Alt_Ave_Used[this_analysis] = 0;
@@ -523,15 +715,35 @@ void nProcess_Init()
 
             Current.Analysis.upper_process_bin[this_analysis] = this_upper_bin;
 
-            for (int32_t sa_i = 0; sa_i < (MAX_CHANNELS); sa_i++)
+            if (settings.analysis[this_analysis].active)
             {
-                nProcess_Initialise_Results_Arrays(&results.WAVE[this_analysis][sa_i], this_analysis);
-                nProcess_Initialise_Results_Arrays(&results.BTRD[this_analysis][sa_i], this_analysis);
-                nProcess_Initialise_Results_Arrays(&results.CORR[this_analysis][sa_i], this_analysis);
+                for (int32_t sa_i = 0; sa_i < analysed_channels; sa_i++)
+                {
+                    nProcess_Initialise_Results_Arrays(&results.WAVE[this_analysis][sa_i], this_analysis);
+                }
+            }
+
+            if ((parameters.output.postanalyse) && (settings.analysis[this_analysis].active) && ((parameters.output.longdist) || (this_analysis == SHORT_ANALYSIS)))
+            {
+                for (int32_t sa_i = 0; sa_i < Global.Channels; sa_i++)
+                {
+                    nProcess_Initialise_Results_Arrays(&results.BTRD[this_analysis][sa_i], this_analysis);
+                    nProcess_Initialise_Results_Arrays(&results.CORR[this_analysis][sa_i], this_analysis);
+                }
             }
         }
     }
 
+    process.Precision_Compare.FFTs = 0;
+    process.Precision_Compare.FFTs_Differ = 0;
+    process.Precision_Compare.Blocks = 0;
+    process.Precision_Compare.Blocks_Differ = 0;
+
+    if (parameters.fft.precision != ANALYSIS_PRECISION_DOUBLE)
+    {
+        nFFT_Float_Init(MAX_FFT_BIT_LENGTH);
+    }
+
     Global.feedback.eclip = 0;
     Global.feedback.sclip = 0;
     Global.feedback.aclip = 0;
@@ -610,10 +822,18 @@ void nProcess_Cleanup_Results_Arrays(Results_Type* this_result)
 void nProcess_Cleanup()
 {
     for (int32_t sa_i = 1; sa_i < (PRECALC_ANALYSES + 1); ++sa_i)
+    {
         for (int32_t sa_j = 0; sa_j < MAX_CHANNELS; sa_j++)
         {
             nProcess_Cleanup_Results_Arrays(&results.WAVE[sa_i][sa_j]);
             nProcess_Cleanup_Results_Arrays(&results.BTRD[sa_i][sa_j]);
             nProcess_Cleanup_Results_Arrays(&results.CORR[sa_i][sa_j]);
         }
+
+        if (process.Old_Min_Used_History[sa_i] != nullptr)
+            delete[] process.Old_Min_Used_History[sa_i];
+
+        if (process.New_Min_Used_History[sa_i] != nullptr)
+            delete[] process.New_Min_Used_History[sa_i];
+    }
 }
@@ -575,6 +575,18 @@ double Filter_Error(int32_t this_channel)
 }
 
 
+int32_t Filter_Order()
+{
+    return SGNS.Filter_Order;
+}
+
+
+double* Filter_Coefficients(int32_t this_channel)
+{
+    return SGNS.Filters[this_channel].k;
+}
+
+
 double warped_frequency(double Lambda, double Freq)
 {
     tDComplex y = complex_exp(Freq);
@@ -84,5 +84,7 @@ void Warped_Lattice_Filter_Update(int, double);
 
 bool Filter_Valid(int);
 double Filter_Error(int);
+int32_t Filter_Order();
+double* Filter_Coefficients(int);     // Reflection coefficients k[] of the channel's lattice filter.
 
 #endif // nSGNS_h_
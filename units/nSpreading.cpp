@@ -27,12 +27,20 @@
 
 #include <cmath>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 #include "nMaths.h"
 #include "nSpreading.h"
 
 // Globals
 spreading_type spreading    __attribute__ ((aligned(16)));
 double Skewing_Gain[MAX_FFT_LENGTH_HALF + 2];
+float* Skewing_Gain_Float[MAX_FFT_BIT_LENGTH + 1];
+static float Skewed_Float[MAX_FFT_LENGTH_HALF + 2] __attribute__ ((aligned(16)));
 double Frequency_Limits[SPREAD_ZONES + 2] = { 20, 1378.125, 3445.3125, 5512.5, 8268.75, 10335.9375, 12403.125, 14470.3125, 16000 };
 
 const double _2x = -0.670485;
@@ -40,63 +48,301 @@ const double _3x =  0.780926; //-0.073165;
 const double _4x =  1.543765;
 double altspread_factor[PRECALC_ANALYSES+1] = {0,_4x,_3x,_2x,0,0,0,_2x};
 
+//============================================================================
+// Convert the linear spreading results of the current FFT into dB and apply
+// the relevant threshold shifts.
+//============================================================================
+static void Spreading_Results_to_dB(double alt_average)
+{
+    spreading.alt_average = (nlog2(alt_average * spreading.Bins.Recip[Current.FFT.bit_length]) + Current.FFT.threshold_shift) * log10_2x20 + settings.noise_threshold_shift_average;
+    spreading.old_minimum = (nlog2(spreading.old_minimum) + Current.FFT.threshold_shift) * log10_2x20 + settings.noise_threshold_shift_minimum;
+    spreading.new_minimum = (nlog2(spreading.new_minimum) + Current.FFT.threshold_shift) * log10_2x20 + settings.noise_threshold_shift_minimum;
+
+    if (parameters.altspread)
+    {
+        spreading.alt_average += altspread_factor[Current.Analysis.number] * log10_2x20;
+    }
+    else
+    {
+        if ((Current.FFT.length < PRECALC_ANALYSES_LENGTHS[SHORT_ANALYSIS]) && (parameters.fft.analyses > 3))
+        {
+            if (Current.FFT.length == PRECALC_ANALYSES_LENGTHS[IMPULSE_ANALYSIS])
+                spreading.alt_average += 0.3072 * log10_2x20;
+            else
+                spreading.alt_average += 0.73065 * log10_2x20;
+        }
+    }
+}
+
+
+//============================================================================
+// Running state of the spreading of one FFT.
+//============================================================================
+struct tSpreading_Sums
+{
+    double alt_average;
+};
+
+
+//============================================================================
+// Spread bin sc_i of Skewed into the running minima. Skewed must be known up
+// to sc_i + 1. The 'old' average is summed afresh for every bin: widths are
+// at most four bins, and a running sum carried along a zone lets a large
+// peak leaving the window cancel the small bins that remain.
+//============================================================================
+static inline void Spread_Bin(tSpreading_Sums& sums, const double* const Skewed, const uint16_t* const widths, const uint16_t* const fractints, const int32_t sc_i)
+{
+    sums.alt_average += Skewed[sc_i];
+
+    double new_value = ((Skewed[sc_i - 1] + Skewed[sc_i + 1]) * spreading.Widths[fractints[sc_i]] + Skewed[sc_i]) * spreading.divisors[fractints[sc_i]];
+
+    if (spreading.new_minimum > new_value)
+    {
+        spreading.new_minimum = new_value;
+        process.new_min_bin = sc_i;
+    }
+
+    if (!parameters.altspread)
+    {
+        double old_value = 0;
+
+        for (int32_t sc_j = 0; sc_j < widths[sc_i]; ++sc_j)
+        {
+            old_value += Skewed[sc_i - sc_j];
+        }
+
+        old_value *= OneOver[widths[sc_i]];
+
+        if (spreading.old_minimum > old_value)
+        {
+            spreading.old_minimum = old_value;
+            process.old_min_bin = sc_i;
+        }
+    }
+}
+
+
 void Spreading_Function(Results_Type* this_result)
 {
-    double alt_average = 0;
+    const int32_t sc_lower = spreading.Bins.Lower[Current.FFT.bit_length];
+    const int32_t sc_upper = spreading.Bins.Upper[Current.FFT.bit_length];
+
+    const double* const Skewed = this_result->Skewed;
+    const uint16_t* const widths = spreading.widths_ptr[Current.Analysis.number];
+    const uint16_t* const fractints = spreading.fractints_ptr[Current.Analysis.number];
+
+    tSpreading_Sums sums = {0};
 
     spreading.new_minimum = Max_dB;
     spreading.old_minimum = Max_dB;
 
-    for (int32_t sc_i = spreading.Bins.Lower[Current.FFT.bit_length]; sc_i <= spreading.Bins.Upper[Current.FFT.bit_length]; ++sc_i)
+    for (int32_t sc_i = sc_lower; sc_i <= sc_upper; ++sc_i)
     {
-        Spreading_rec sc_s = spreading.averages_ptr[Current.Analysis.number][sc_i];
+        Spread_Bin(sums, Skewed, widths, fractints, sc_i);
+    }
+
+    Spreading_Results_to_dB(sums.alt_average);
+}
+
+
+//============================================================================
+// Post-process the output of a forward FFT and spread the result in a single
+// pass. Bins are handled in tiles so that the magnitudes, skewed values and
+// the spreading reductions all use the spectrum while it is still in cache.
+// Each bin is spread by the same Spread_Bin, in the same order, as in
+// Spreading_Function, so the minima and averages are bit for bit the same.
+//============================================================================
+static const int32_t SPREADING_TILE_BINS = 64;
+
+void Spreading_Function_Fused(FFT_Proc_Rec* this_FFT_plan, Results_Type* this_result)
+{
+    const int32_t sc_last_bin = Current.Analysis.upper_process_bin[Current.Analysis.number];
+    const int32_t sc_lower = spreading.Bins.Lower[Current.FFT.bit_length];
+    const int32_t sc_upper = spreading.Bins.Upper[Current.FFT.bit_length];
+    const int32_t sc_shift = Current.FFT.bit_shift_from_max;
 
-        alt_average += this_result->Skewed[sc_i];
+    tDComplex* const DComplex = this_FFT_plan->DComplex;
+    double* const LastRoot = this_result->LastRoot;
+    double* const Root = this_result->Root;
+    double* const LastUnity = this_result->LastUnity;
+    double* const Unity = this_result->Unity;
+    double* const Skewed = this_result->Skewed;
 
-        if (!parameters.altspread)
+    const uint16_t* const widths = spreading.widths_ptr[Current.Analysis.number];
+    const uint16_t* const fractints = spreading.fractints_ptr[Current.Analysis.number];
+
+    tSpreading_Sums sums = {0};
+    int32_t sc_next = sc_lower;
+
+    spreading.new_minimum = Max_dB;
+    spreading.old_minimum = Max_dB;
+
+    for (int32_t sc_tile = 0; sc_tile <= sc_last_bin; sc_tile += SPREADING_TILE_BINS)
+    {
+        const int32_t sc_tile_end = std::min(sc_tile + SPREADING_TILE_BINS, sc_last_bin + 1);
+
+        int32_t sc_i = sc_tile;
+
+#if defined(__SSE2__)
+        for (; sc_i + 1 < sc_tile_end; sc_i += 2)
         {
-            double old_value = 0;
+            __m128d sc_c0 = _mm_loadu_pd(&DComplex[sc_i].Re);
+            __m128d sc_c1 = _mm_loadu_pd(&DComplex[sc_i + 1].Re);
+            __m128d sc_re = _mm_unpacklo_pd(sc_c0, sc_c1);
+            __m128d sc_im = _mm_unpackhi_pd(sc_c0, sc_c1);
 
-            for (int32_t sc_j = 0; sc_j < sc_s.width; ++sc_j)
-            {
-                old_value += this_result->Skewed[sc_i - sc_j];
-            }
-            old_value *= OneOver[sc_s.width];
+            __m128d sc_y = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(sc_re, sc_re), _mm_mul_pd(sc_im, sc_im)));
+
+            _mm_storeu_pd(&LastRoot[sc_i], sc_y);
+            _mm_storeu_pd(&Root[sc_i], _mm_add_pd(_mm_loadu_pd(&Root[sc_i]), sc_y));
+
+            __m128d sc_gain = _mm_set_pd(Skewing_Gain[(sc_i + 1) << sc_shift], Skewing_Gain[sc_i << sc_shift]);
+            _mm_storeu_pd(&Skewed[sc_i], _mm_mul_pd(sc_y, sc_gain));
+
+            sc_y = _mm_mul_pd(sc_y, sc_y);
+            _mm_storeu_pd(&LastUnity[sc_i], sc_y);
+            _mm_storeu_pd(&Unity[sc_i], _mm_add_pd(_mm_loadu_pd(&Unity[sc_i]), sc_y));
+        }
+#endif
+
+        for (; sc_i < sc_tile_end; ++sc_i)
+        {
+            double sc_y = DComplex[sc_i].magnitude();
+
+            LastRoot[sc_i] = sc_y;
+            Root[sc_i] += sc_y;
 
-            if (spreading.old_minimum > old_value)
+            Skewed[sc_i] = sc_y * Skewing_Gain[sc_i << sc_shift];
+
+            sc_y *= sc_y;
+            LastUnity[sc_i] = sc_y;
+            Unity[sc_i] += sc_y;
+        }
+
+        //============================================================================
+        // Spread every bin whose upper neighbour has now been calculated.
+        //============================================================================
+        for (; (sc_next <= sc_upper) && (sc_next + 1 < sc_tile_end); ++sc_next)
+        {
+            Spread_Bin(sums, Skewed, widths, fractints, sc_next);
+        }
+    }
+
+    Spreading_Results_to_dB(sums.alt_average);
+}
+
+
+//============================================================================
+// Single precision equivalent of Spreading_Function_Fused, used with
+// FFT_DIT_Real_Float. Magnitudes, skewing and the spreading minima are all
+// calculated in float; the bin average and the dB conversion stay in double.
+// Root / Unity results are only written when this_result is given, i.e. not
+// when the float analysis is only being compared with the double analysis.
+//============================================================================
+void Spreading_Function_Float(FFT_Proc_Rec* this_FFT_plan, Results_Type* this_result)
+{
+    const int32_t sc_last_bin = Current.Analysis.upper_process_bin[Current.Analysis.number];
+    const int32_t sc_lower = spreading.Bins.Lower[Current.FFT.bit_length];
+    const int32_t sc_upper = spreading.Bins.Upper[Current.FFT.bit_length];
+
+    const float* const FComplex = this_FFT_plan->FReal;
+    const float* const Gain = Skewing_Gain_Float[Current.FFT.bit_length];
+    float* const Skewed = Skewed_Float;
+
+    const uint16_t* const widths = spreading.widths_ptr[Current.Analysis.number];
+    const uint16_t* const fractints = spreading.fractints_ptr[Current.Analysis.number];
+
+    int32_t sc_i = 0;
+
+#if defined(__SSE__)
+    for (; sc_i + 3 <= sc_last_bin; sc_i += 4)
+    {
+        __m128 sc_c0 = _mm_loadu_ps(&FComplex[sc_i << 1]);
+        __m128 sc_c1 = _mm_loadu_ps(&FComplex[(sc_i + 2) << 1]);
+        __m128 sc_re = _mm_shuffle_ps(sc_c0, sc_c1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 sc_im = _mm_shuffle_ps(sc_c0, sc_c1, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128 sc_y = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(sc_re, sc_re), _mm_mul_ps(sc_im, sc_im)));
+
+        _mm_store_ps(&Skewed[sc_i], _mm_mul_ps(sc_y, _mm_loadu_ps(&Gain[sc_i])));
+
+        if (this_result != nullptr)
+        {
+            float sc_y_array[4] __attribute__ ((aligned(16)));
+            _mm_store_ps(sc_y_array, sc_y);
+
+            for (int32_t sc_j = 0; sc_j < 4; ++sc_j)
             {
-                spreading.old_minimum = old_value;
-                process.old_min_bin = sc_i;
+                double sc_d = sc_y_array[sc_j];
+                this_result->LastRoot[sc_i + sc_j] = sc_d;
+                this_result->Root[sc_i + sc_j] += sc_d;
+                sc_d *= sc_d;
+                this_result->LastUnity[sc_i + sc_j] = sc_d;
+                this_result->Unity[sc_i + sc_j] += sc_d;
             }
         }
+    }
+#endif
 
-        double new_value = ((this_result->Skewed[sc_i - 1] + this_result->Skewed[sc_i + 1]) * spreading.Widths[sc_s.fractint] + this_result->Skewed[sc_i]) * spreading.divisors[sc_s.fractint];
+    for (; sc_i <= sc_last_bin; ++sc_i)
+    {
+        float sc_y = std::sqrt(FComplex[sc_i << 1] * FComplex[sc_i << 1] + FComplex[(sc_i << 1) + 1] * FComplex[(sc_i << 1) + 1]);
+
+        Skewed[sc_i] = sc_y * Gain[sc_i];
 
-        if (spreading.new_minimum > new_value)
+        if (this_result != nullptr)
         {
-            spreading.new_minimum = new_value;
-            process.new_min_bin = sc_i;
+            double sc_d = sc_y;
+            this_result->LastRoot[sc_i] = sc_d;
+            this_result->Root[sc_i] += sc_d;
+            sc_d *= sc_d;
+            this_result->LastUnity[sc_i] = sc_d;
+            this_result->Unity[sc_i] += sc_d;
         }
     }
 
-    spreading.alt_average = (nlog2(alt_average * spreading.Bins.Recip[Current.FFT.bit_length]) + Current.FFT.threshold_shift) * log10_2x20 + settings.noise_threshold_shift_average;
-    spreading.old_minimum = (nlog2(spreading.old_minimum) + Current.FFT.threshold_shift) * log10_2x20 + settings.noise_threshold_shift_minimum;
-    spreading.new_minimum = (nlog2(spreading.new_minimum) + Current.FFT.threshold_shift) * log10_2x20 + settings.noise_threshold_shift_minimum;
+    double alt_average = 0;
+    float new_minimum = Max_dB;
+    float old_minimum = Max_dB;
 
-    if (parameters.altspread)
+    for (sc_i = sc_lower; sc_i <= sc_upper; ++sc_i)
     {
-        spreading.alt_average += altspread_factor[Current.Analysis.number] * log10_2x20;
+        alt_average += Skewed[sc_i];
+
+        float new_value = ((Skewed[sc_i - 1] + Skewed[sc_i + 1]) * spreading.Widths[fractints[sc_i]] + Skewed[sc_i]) * spreading.divisors[fractints[sc_i]];
+
+        if (new_minimum > new_value)
+        {
+            new_minimum = new_value;
+            process.new_min_bin = sc_i;
+        }
     }
-    else
+
+    if (!parameters.altspread)
     {
-        if ((Current.FFT.length < PRECALC_ANALYSES_LENGTHS[SHORT_ANALYSIS]) && (parameters.fft.analyses > 3))
+        for (sc_i = sc_lower; sc_i <= sc_upper; ++sc_i)
         {
-            if (Current.FFT.length == PRECALC_ANALYSES_LENGTHS[IMPULSE_ANALYSIS])
-                spreading.alt_average += 0.3072 * log10_2x20;
-            else
-                spreading.alt_average += 0.73065 * log10_2x20;
+            float old_value = 0;
+
+            for (int32_t sc_j = 0; sc_j < widths[sc_i]; ++sc_j)
+            {
+                old_value += Skewed[sc_i - sc_j];
+            }
+
+            old_value *= float(OneOver[widths[sc_i]]);
+
+            if (old_minimum > old_value)
+            {
+                old_minimum = old_value;
+                process.old_min_bin = sc_i;
+            }
         }
     }
+
+    spreading.new_minimum = (new_minimum < float(Max_dB)) ? double(new_minimum) : Max_dB;
+    spreading.old_minimum = (old_minimum < float(Max_dB)) ? double(old_minimum) : Max_dB;
+
+    Spreading_Results_to_dB(alt_average);
 }
 
 
@@ -104,7 +350,8 @@ void Spreading_Memory_Allocate()
 {
     for (int32_t sa_i = 1; sa_i <= PRECALC_ANALYSES; ++sa_i)
     {
-        spreading.averages_ptr[sa_i] = new Spreading_rec[Current.Analysis.length[sa_i] + 1];
+        spreading.widths_ptr[sa_i] = new uint16_t[Current.Analysis.length[sa_i] + 1];
+        spreading.fractints_ptr[sa_i] = new uint16_t[Current.Analysis.length[sa_i] + 1];
         spreading.Bark_Value[sa_i] = new double[(Current.Analysis.length[sa_i] >> 1) + 1];
     }
 }
@@ -183,6 +430,23 @@ void nSpreading_Init()
     Skewing_Curve_Init();
     Threshold_Index_Init();
 
+    //============================================================================
+    // Skewing gain per bin for each FFT length, in float, for the single
+    // precision analysis.
+    //============================================================================
+    if (parameters.fft.precision != ANALYSIS_PRECISION_DOUBLE)
+    {
+        for (int32_t sa_i = 1; sa_i <= MAX_FFT_BIT_LENGTH; ++sa_i)
+        {
+            Skewing_Gain_Float[sa_i] = new float[(1 << (sa_i - 1)) + 4];
+
+            for (int32_t sa_j = 0; sa_j <= (1 << (sa_i - 1)); ++sa_j)
+            {
+                Skewing_Gain_Float[sa_i][sa_j] = Skewing_Gain[sa_j << (MAX_FFT_BIT_LENGTH - sa_i)];
+            }
+        }
+    }
+
     for (int32_t sa_i = 1; sa_i <= MAX_FFT_BIT_LENGTH; ++sa_i)
     {
         spreading.Bins.Lower[sa_i] = std::max(1, nRoundEvenInt32(double(Global.lower_freq_limit) / Global.sample_rate * PowersOf.TwoX[TWO_OFFSET + sa_i]) - 1);
@@ -212,19 +476,33 @@ void nSpreading_Init()
 
         for (int32_t sa_j = SPREAD_ZONES; sa_j >= 0; --sa_j)
             for (int32_t sa_i = spreading.Frequency_Bins[Current.Analysis.number][sa_j]; sa_i <= spreading.Frequency_Bins[Current.Analysis.number][sa_j + 1]; sa_i ++)
-                spreading.averages_ptr[Current.Analysis.number][sa_i].width = std::min(uint16_t(sa_i), uint16_t(SPREADING_FUNCTION_ARRAY[Current.Analysis.number][sa_j]));
+                spreading.widths_ptr[Current.Analysis.number][sa_i] = std::min(uint16_t(sa_i), uint16_t(SPREADING_FUNCTION_ARRAY[Current.Analysis.number][sa_j]));
 
         for (int32_t sa_i = 0; sa_i <= spreading.Bins.Mid[Current.FFT.bit_length]; ++sa_i)
-            spreading.averages_ptr[Current.Analysis.number][sa_i].fractint = 0;
+            spreading.fractints_ptr[Current.Analysis.number][sa_i] = 0;
 
         for (int32_t sa_i = spreading.Bins.Mid[Current.FFT.bit_length]; sa_i <= Current.FFT.length_half_m1; ++sa_i)
-            spreading.averages_ptr[Current.Analysis.number][sa_i].fractint = uint16_t(SPREADING_STEPS * std::max(0.0, std::min(double(UPPER_FREQ_LIMIT - MID_FREQ_LIMIT), sa_i * double(Global.sample_rate) / Current.FFT.length - MID_FREQ_LIMIT)) / (UPPER_FREQ_LIMIT - MID_FREQ_LIMIT) * this_spreading_function_width);
+            spreading.fractints_ptr[Current.Analysis.number][sa_i] = uint16_t(SPREADING_STEPS * std::max(0.0, std::min(double(UPPER_FREQ_LIMIT - MID_FREQ_LIMIT), sa_i * double(Global.sample_rate) / Current.FFT.length - MID_FREQ_LIMIT)) / (UPPER_FREQ_LIMIT - MID_FREQ_LIMIT) * this_spreading_function_width);
     }
 }
 
 void nSpreading_Cleanup()
 {
     for (int32_t sa_i = 1; sa_i <= PRECALC_ANALYSES; ++sa_i)
-        if (spreading.averages_ptr[sa_i] != nullptr)
-            delete[] spreading.averages_ptr[sa_i];
+    {
+        if (spreading.widths_ptr[sa_i] != nullptr)
+            delete[] spreading.widths_ptr[sa_i];
+
+        if (spreading.fractints_ptr[sa_i] != nullptr)
+            delete[] spreading.fractints_ptr[sa_i];
+
+        if (spreading.Bark_Value[sa_i] != nullptr)
+            delete[] spreading.Bark_Value[sa_i];
+    }
+
+    for (int32_t sa_i = 1; sa_i <= MAX_FFT_BIT_LENGTH; ++sa_i)
+    {
+        if (Skewing_Gain_Float[sa_i] != nullptr)
+            delete[] Skewing_Gain_Float[sa_i];
+    }
 }
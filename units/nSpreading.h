@@ -68,17 +68,6 @@ static const double SPREADING_FUNCTION_WIDTHS[PRECALC_ANALYSES + 1] =
 };
 
 
-struct Spreading_rec
-{
-    uint16_t width;
-    uint16_t fractint;
-};
-
-
-typedef Spreading_rec sprec_array[1];
-typedef Spreading_rec* sprec_array_ptr;
-
-
 // Vars
 
 extern double Frequency_Limits[SPREAD_ZONES + 2]    __attribute__ ((aligned(16)));
@@ -92,7 +81,12 @@ extern struct spreading_type
     double old_minimum __attribute__ ((aligned(16)));
     double new_minimum __attribute__ ((aligned(16)));
 
-    sprec_array_ptr averages_ptr[PRECALC_ANALYSES + 1]  __attribute__ ((aligned(16))); // base 1.
+    //============================================================================
+    // Per bin spreading data for each analysis, held as separate arrays so that
+    // the spreading loops read contiguous values.
+    //============================================================================
+    uint16_t* widths_ptr[PRECALC_ANALYSES + 1]          __attribute__ ((aligned(16))); // base 1.
+    uint16_t* fractints_ptr[PRECALC_ANALYSES + 1]       __attribute__ ((aligned(16))); // base 1.
     double* Bark_Value[PRECALC_ANALYSES + 1]            __attribute__ ((aligned(16))); // base 1.
 //============================================================================
     // For each FFT bit length store bits_to_remove with respect to calculated minimum dB of FFT result.
@@ -126,6 +120,10 @@ void Spreading_Function_Alt(int);
 
 void Spreading_Function(Results_Type* this_result);
 
+void Spreading_Function_Fused(FFT_Proc_Rec* this_FFT_plan, Results_Type* this_result);
+
+void Spreading_Function_Float(FFT_Proc_Rec* this_FFT_plan, Results_Type* this_result);
+
 void nSpreading_Init();
 
 void nSpreading_Cleanup();
@@ -0,0 +1,409 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#include <cerrno>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#include "nStatsJSON.h"
+#include "nCore.h"
+#include "nParameter.h"
+#include "nPerfCounters.h"
+#include "nSupport.h"
+
+namespace {
+
+//============================================================================
+// Records, each on one line:
+//   {"record":"progress", ...}  every Global.output_blocks codec blocks to
+//                               the --stats-json file, and every
+//                               PROGRESS_FD_INTERVAL seconds to --progress-fd.
+//   {"record":"finished", ...}  to --progress-fd at the end of the file.
+//   {"record":"results", ...}   once per file to the --stats-json file,
+//                               carrying the same information as the text
+//                               summary and --bitdist.
+//============================================================================
+static const double PROGRESS_FD_INTERVAL = 1.0;
+static const int     PROGRESS_FD_TIMEOUT_MS = 1000;     // to finish a record that went out in part.
+
+std::ofstream JSONOutput;
+
+struct
+{
+    int32_t fd = -1;
+    double  Next = 0;
+} ProgressFd;
+
+
+std::string JSON_String(const std::string& text)
+{
+    std::ostringstream result;
+
+    result << '"';
+
+    for (size_t thischar = 0; thischar < text.length(); ++thischar)
+    {
+        unsigned char c = text[thischar];
+
+        switch (c)
+        {
+        case '"':
+            result << "\\\"";
+            break;
+        case '\\':
+            result << "\\\\";
+            break;
+        case '\n':
+            result << "\\n";
+            break;
+        case '\r':
+            result << "\\r";
+            break;
+        case '\t':
+            result << "\\t";
+            break;
+        default:
+            if (c < 0x20)
+                result << "\\u00" << std::hex << std::setw(2) << std::setfill('0') << int32_t(c) << std::dec << std::setfill(' ');
+            else
+                result << c;
+        }
+    }
+
+    result << '"';
+
+    return result.str();
+}
+
+
+double Average_Bits(int64_t total_bits)
+{
+    return OneOver[Global.Channels] * total_bits * Global.blocks_processed_recip;
+}
+
+
+void Write_Common(std::ostream& ToOutput, const char* record)
+{
+    ToOutput << "{\"record\":\"" << record << "\""
+             << ",\"filename\":" << JSON_String(WAVFilePrintName())
+             << ",\"samples_processed\":" << Global.samples_processed;
+
+    if (Global.WAVE_size == MAX_WAVE_SIZE)
+        ToOutput << ",\"total_samples\":null";
+    else
+        ToOutput << ",\"total_samples\":" << Global.Total_Samples;
+
+    ToOutput << ",\"codec_blocks\":" << Global.blocks_processed
+             << ",\"bits_removed\":" << std::fixed << std::setprecision(4) << Average_Bits(Stats.total_bits_removed)
+             << ",\"bits_lost\":" << std::fixed << std::setprecision(4) << Average_Bits(Stats.total_bits_lost)
+             << ",\"rate\":" << std::fixed << std::setprecision(2) << Global.processing_rate
+             << ",\"elapsed\":" << std::fixed << std::setprecision(3) << timer.Elapsed;
+}
+
+
+void Write_ETA(std::ostream& ToOutput)
+{
+    if ((Global.WAVE_size == MAX_WAVE_SIZE) || (Global.samples_processed == 0))
+        ToOutput << ",\"eta\":null";
+    else
+        ToOutput << ",\"eta\":" << std::fixed << std::setprecision(1)
+                 << (double(Global.Total_Samples - Global.samples_processed) / Global.samples_processed * timer.Elapsed);
+}
+
+
+void Close_Progress_Fd()
+{
+#ifdef _WIN32
+    _close(ProgressFd.fd);
+#else
+    close(ProgressFd.fd);
+#endif
+    ProgressFd.fd = -1;
+}
+
+
+//============================================================================
+// Whole records only; a descriptor that stops accepting them is dropped with
+// a warning rather than stopping the processing. SIGPIPE is held back while
+// writing, so a reader going away only ends the progress records. A record
+// is skipped if the descriptor cannot take it straight away; the rest of
+// one that went out in part is given PROGRESS_FD_TIMEOUT_MS, after which the
+// reader is taken to have stalled and the descriptor is dropped.
+//============================================================================
+void Write_Progress_Fd(const char* record)
+{
+    std::ostringstream thisrecord;
+
+    Write_Common(thisrecord, record);
+    Write_ETA(thisrecord);
+    thisrecord << '}' << '\n';
+
+    const std::string text = thisrecord.str();
+    size_t written = 0;
+    bool failed = false;
+
+#ifndef _WIN32
+    sigset_t sigpipe_set, old_set, pending_set;
+    int32_t sigpipe_signal;
+
+    sigemptyset(&sigpipe_set);
+    sigaddset(&sigpipe_set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe_set, &old_set);
+#endif
+
+    while ((written < text.length()) && (!failed))
+    {
+#ifdef _WIN32
+        int byteswritten = _write(ProgressFd.fd, text.data() + written, text.length() - written);
+#else
+        struct pollfd thispoll = {ProgressFd.fd, POLLOUT, 0};
+        int ready = poll(&thispoll, 1, (written == 0) ? 0 : PROGRESS_FD_TIMEOUT_MS);
+
+        if ((ready < 0) && (errno == EINTR))
+            continue;
+
+        if ((ready == 0) && (written == 0))
+            break;
+
+        if ((ready <= 0) || (!(thispoll.revents & POLLOUT)))
+        {
+            failed = true;
+            continue;
+        }
+
+        ssize_t byteswritten = write(ProgressFd.fd, text.data() + written, text.length() - written);
+#endif
+
+        if (byteswritten >= 0)
+            written += byteswritten;
+        else
+            failed = (errno != EINTR);
+    }
+
+#ifndef _WIN32
+    if ((!sigismember(&old_set, SIGPIPE)) && (sigpending(&pending_set) == 0) && (sigismember(&pending_set, SIGPIPE)))
+    {
+        sigwait(&sigpipe_set, &sigpipe_signal);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+#endif
+
+    if (failed)
+    {
+        lossyWAVWarning("Writing to progress file descriptor " + NumToStr(parameters.output.progressfd) + " failed, progress records stopped.");
+        Close_Progress_Fd();
+    }
+}
+
+
+void Write_Distribution(std::ostream& ToOutput, const int64_t* counts)
+{
+    ToOutput << '[';
+
+    for (int32_t this_bit = 0; this_bit <= Global.bits_per_sample; ++this_bit)
+    {
+        if (this_bit > 0)
+            ToOutput << ',';
+
+        ToOutput << counts[this_bit];
+    }
+
+    ToOutput << ']';
+}
+
+} // namespace
+
+
+void nStatsJSON_Init()
+{
+    if (parameters.output.progressdup != -1)
+    {
+        ProgressFd.fd = parameters.output.progressdup;
+        ProgressFd.Next = 0;
+    }
+
+    if (parameters.output.jsonfilename != "")
+    {
+        JSONOutput.open(parameters.output.jsonfilename.c_str(), std::ios::out | std::ios::app);
+
+        if (!JSONOutput.good())
+        {
+            lossyWAVError("Cannot gain write access to " + parameters.output.jsonfilename, 0x31);
+        }
+    }
+}
+
+
+void nStatsJSON_Progress()
+{
+    if (ProgressFd.fd != -1)
+    {
+        gettimer();
+
+        if (timer.Elapsed >= ProgressFd.Next)
+        {
+            Write_Progress_Fd("progress");
+            ProgressFd.Next = timer.Elapsed + PROGRESS_FD_INTERVAL;
+        }
+    }
+
+    if ((JSONOutput.is_open()) && (Global.blocks_processed % Global.output_blocks == 0))
+    {
+        gettimer();
+
+        Write_Common(JSONOutput, "progress");
+
+        JSONOutput << '}' << std::endl;
+    }
+}
+
+
+void nStatsJSON_Results()
+{
+    if (ProgressFd.fd != -1)
+    {
+        Write_Progress_Fd("finished");
+
+        if (ProgressFd.fd != -1)
+        {
+            Close_Progress_Fd();
+        }
+    }
+
+    if (!JSONOutput.is_open())
+    {
+        return;
+    }
+
+    Write_Common(JSONOutput, "results");
+
+    JSONOutput << ",\"version\":" << JSON_String(strings.version_short)
+               << ",\"processed\":" << JSON_String(strings.datestamp)
+               << ",\"settings\":" << JSON_String(strings.parameter)
+               << ",\"sample_rate\":" << Global.sample_rate
+               << ",\"channels\":" << Global.Channels
+               << ",\"bits_per_sample\":" << Global.bits_per_sample
+               << ",\"codec_block_size\":" << Global.Codec_Block.Size;
+
+    //==========================================================================
+    // Per channel distribution of bits removed / lost over the codec blocks.
+    //==========================================================================
+    JSONOutput << ",\"per_channel\":[";
+
+    for (int32_t this_channel = 0; this_channel < Global.Channels; ++this_channel)
+    {
+        int64_t channel_bits_removed = 0;
+        int64_t channel_bits_lost = 0;
+
+        for (int32_t this_bit = 0; this_bit <= Global.bits_per_sample; ++this_bit)
+        {
+            channel_bits_removed += this_bit * Stats.bits_removed[this_channel][this_bit];
+            channel_bits_lost += this_bit * Stats.bits_lost[this_channel][this_bit];
+        }
+
+        if (this_channel > 0)
+            JSONOutput << ',';
+
+        JSONOutput << "{\"bits_removed\":" << std::fixed << std::setprecision(4) << (channel_bits_removed * Global.blocks_processed_recip)
+                   << ",\"bits_lost\":" << std::fixed << std::setprecision(4) << (channel_bits_lost * Global.blocks_processed_recip)
+                   << ",\"bits_removed_dist\":";
+        Write_Distribution(JSONOutput, Stats.bits_removed[this_channel]);
+        JSONOutput << ",\"bits_lost_dist\":";
+        Write_Distribution(JSONOutput, Stats.bits_lost[this_channel]);
+        JSONOutput << '}';
+    }
+
+    JSONOutput << ']';
+
+    JSONOutput << ",\"clips\":{\"incidence\":{\"extant\":" << Stats.Incidence.eclip
+               << ",\"scaling\":" << Stats.Incidence.sclip
+               << ",\"rounding\":" << Stats.Incidence.rclip
+               << ",\"shaping\":" << Stats.Incidence.aclip
+               << ",\"reactive\":" << Stats.Incidence.xclip
+               << "},\"count\":{\"extant\":" << Stats.Count.eclips
+               << ",\"scaling\":" << Stats.Count.sclips
+               << ",\"rounding\":" << Stats.Count.rclips
+               << ",\"shaping\":" << Stats.Count.aclips
+               << ",\"reactive\":" << Stats.Count.xclips
+               << "}}"
+               << ",\"exceedences\":{\"rounding\":" << Stats.Incidence.round
+               << ",\"shaping\":" << Stats.Incidence.noise
+               << "},\"skipped_filters\":" << Stats.Skipped_Filters;
+
+    //==========================================================================
+    // FFT analyses completed and reused at each active length.
+    //==========================================================================
+    JSONOutput << ",\"analyses\":[";
+
+    bool first_analysis = true;
+
+    for (int32_t this_analysis_number = 1; this_analysis_number <= PRECALC_ANALYSES; ++this_analysis_number)
+    {
+        if (!settings.analysis[this_analysis_number].active)
+            continue;
+
+        if (!first_analysis)
+            JSONOutput << ',';
+
+        first_analysis = false;
+
+        JSONOutput << "{\"length\":" << settings.analysis[this_analysis_number].FFT.length
+                   << ",\"completed\":" << process.Analyses_Completed[this_analysis_number]
+                   << ",\"reused\":" << process.Analyses_Reused[this_analysis_number] << '}';
+    }
+
+    JSONOutput << ']';
+
+    if (parameters.fft.precision == ANALYSIS_PRECISION_COMPARE)
+    {
+        JSONOutput << ",\"precision_compare\":{\"ffts\":" << process.Precision_Compare.FFTs
+                   << ",\"ffts_differ\":" << process.Precision_Compare.FFTs_Differ
+                   << ",\"blocks\":" << process.Precision_Compare.Blocks
+                   << ",\"blocks_differ\":" << process.Precision_Compare.Blocks_Differ << '}';
+    }
+
+    if ((Stats.Cache.hits + Stats.Cache.misses) > 0)
+    {
+        JSONOutput << ",\"cache\":{\"hits\":" << Stats.Cache.hits << ",\"misses\":" << Stats.Cache.misses << '}';
+    }
+
+    Write_PerfCounters_JSON(JSONOutput);
+
+    JSONOutput << '}' << std::endl;
+
+    JSONOutput.close();
+}
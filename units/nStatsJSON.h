@@ -0,0 +1,43 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#ifndef nStatsJSON_h_
+#define nStatsJSON_h_
+
+//============================================================================
+// --stats-json: the results summary, and progress while processing, as one
+// JSON object per line appended to a file. --progress-fd: progress alone,
+// in the same form, written to an inherited file descriptor about once a
+// second.
+//============================================================================
+
+void nStatsJSON_Init();             // after nInitial_Setup, once the settings string is complete.
+
+void nStatsJSON_Progress();         // once per codec block.
+void nStatsJSON_Results();          // at the end of processing, after gettimer().
+
+#endif // nStatsJSON_h_
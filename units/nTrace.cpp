@@ -0,0 +1,210 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+#ifdef HAVE_STD_THREAD
+#include <mutex>
+#endif
+
+#include "nTrace.h"
+#include "nCore.h"
+#include "nSupport.h"
+
+bool Tracing = false;
+
+namespace {
+
+//============================================================================
+// Complete ("ph":"X") events in microseconds from nTrace_Init; block,
+// channel and length are only written when given (block >= 0, channel >= 0,
+// length > 0). Buffers are deques so that recording never moves earlier
+// events; they are only read once the other threads have stopped.
+//============================================================================
+struct tTrace_Event
+{
+    const char* name;
+    int64_t     start;
+    int64_t     duration;
+    int64_t     block;
+    int32_t     channel;
+    int32_t     length;
+};
+
+struct tTrace_Buffer
+{
+    int32_t                  tid;
+    std::string              name;
+    std::deque<tTrace_Event> events;
+};
+
+std::ofstream TraceOutput;
+std::chrono::steady_clock::time_point Trace_Origin;
+std::vector<tTrace_Buffer*> Trace_Buffers;
+
+#ifdef HAVE_STD_THREAD
+std::mutex Trace_Buffers_Lock;
+#endif
+
+thread_local tTrace_Buffer* This_Thread_Buffer = nullptr;
+
+
+tTrace_Buffer* Thread_Buffer()
+{
+    if (This_Thread_Buffer == nullptr)
+    {
+#ifdef HAVE_STD_THREAD
+        std::lock_guard<std::mutex> guard(Trace_Buffers_Lock);
+#endif
+        This_Thread_Buffer = new tTrace_Buffer;
+        This_Thread_Buffer->tid = int32_t(Trace_Buffers.size()) + 1;
+        This_Thread_Buffer->name = "thread " + NumToStr(This_Thread_Buffer->tid);
+        Trace_Buffers.push_back(This_Thread_Buffer);
+    }
+
+    return This_Thread_Buffer;
+}
+
+
+void Write_Microseconds(std::ostream& ToOutput, int64_t nanoseconds)
+{
+    ToOutput << (nanoseconds / 1000) << '.' << std::setw(3) << std::setfill('0') << (nanoseconds % 1000) << std::setfill(' ');
+}
+
+} // namespace
+
+
+int64_t Trace_Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Trace_Origin).count();
+}
+
+
+void Trace_Record(const char* name, int64_t start, int64_t block, int32_t channel, int32_t length)
+{
+    Thread_Buffer()->events.push_back({name, start, Trace_Now() - start, block, channel, length});
+}
+
+
+void Trace_Thread_Name(const char* name)
+{
+    if (Tracing)
+    {
+        tTrace_Buffer* this_buffer = Thread_Buffer();
+        this_buffer->name = std::string(name) + " (" + NumToStr(this_buffer->tid) + ")";
+    }
+}
+
+
+void nTrace_Init()
+{
+    if (parameters.output.tracefilename == "")
+        return;
+
+    TraceOutput.open(parameters.output.tracefilename.c_str(), std::ios::out | std::ios::trunc);
+
+    if (!TraceOutput.good())
+    {
+        lossyWAVError("Cannot gain write access to " + parameters.output.tracefilename, 0x31);
+    }
+
+    Trace_Origin = std::chrono::steady_clock::now();
+    Tracing = true;
+
+    Trace_Thread_Name("processing");
+}
+
+
+void nTrace_Close()
+{
+    if (!Tracing)
+        return;
+
+    Tracing = false;
+
+    TraceOutput << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl
+                << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"lossyWAV " << strings.version_short << "\"}}";
+
+    for (tTrace_Buffer* this_buffer : Trace_Buffers)
+    {
+        TraceOutput << ',' << std::endl
+                    << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << this_buffer->tid
+                    << ",\"args\":{\"name\":\"" << this_buffer->name << "\"}}";
+
+        for (const tTrace_Event& this_event : this_buffer->events)
+        {
+            TraceOutput << ',' << std::endl
+                        << "{\"name\":\"" << this_event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << this_buffer->tid << ",\"ts\":";
+            Write_Microseconds(TraceOutput, this_event.start);
+            TraceOutput << ",\"dur\":";
+            Write_Microseconds(TraceOutput, this_event.duration);
+
+            if ((this_event.block >= 0) || (this_event.channel >= 0) || (this_event.length > 0))
+            {
+                const char* separator = "";
+
+                TraceOutput << ",\"args\":{";
+
+                if (this_event.block >= 0)
+                {
+                    TraceOutput << "\"block\":" << this_event.block;
+                    separator = ",";
+                }
+
+                if (this_event.channel >= 0)
+                {
+                    TraceOutput << separator << "\"channel\":" << this_event.channel;
+                    separator = ",";
+                }
+
+                if (this_event.length > 0)
+                    TraceOutput << separator << "\"length\":" << this_event.length;
+
+                TraceOutput << '}';
+            }
+
+            TraceOutput << '}';
+        }
+
+        delete this_buffer;
+    }
+
+    Trace_Buffers.clear();
+    This_Thread_Buffer = nullptr;
+
+    TraceOutput << std::endl << "]}" << std::endl;
+    TraceOutput.close();
+
+    if (TraceOutput.fail())
+    {
+        lossyWAVWarning("Writing trace file " + parameters.output.tracefilename + " failed.");
+    }
+}
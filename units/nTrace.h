@@ -0,0 +1,60 @@
+/**===========================================================================
+
+    lossyWAV: Added noise WAV bit reduction method by David Robinson;
+              Noise shaping coefficients by Sebastian Gesemann;
+
+    Copyright (C) 2007-2016 Nick Currie, Copyleft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Contact: lossywav <at> hotmail <dot> co <dot> uk
+
+==============================================================================
+    Initial translation to C++ from Delphi
+    Copyright (C) Tyge Lvset (tycho), Aug. 2012
+===========================================================================**/
+
+#ifndef nTrace_h_
+#define nTrace_h_
+
+#include <cstdint>
+
+//============================================================================
+// --trace: a timeline of each codec block's stages, and of the read-ahead
+// and write-behind threads and the waits for them, written at the end of
+// processing as Chrome trace events (JSON), for chrome://tracing or
+// Perfetto. Each thread records into its own buffer without locking.
+//============================================================================
+
+extern bool Tracing;
+
+int64_t Trace_Now();
+void Trace_Record(const char* name, int64_t start, int64_t block, int32_t channel, int32_t length);
+void Trace_Thread_Name(const char* name);
+
+inline int64_t Trace_Start()
+{
+    return Tracing ? Trace_Now() : 0;
+}
+
+inline void Trace_Stop(const char* name, int64_t start, int64_t block = -1, int32_t channel = -1, int32_t length = 0)
+{
+    if (Tracing)
+        Trace_Record(name, start, block, channel, length);
+}
+
+void nTrace_Init();                 // before openWavIO starts the read-ahead / write-behind threads.
+void nTrace_Close();                // after closeWavIO has stopped them; writes the trace file.
+
+#endif // nTrace_h_
@@ -35,30 +35,19 @@
 #include <ctime>
 
 #include "nWav.h"
+#include "nIO.h"
 #include "nCore.h"
 #include "nParameter.h" // filemode
 #include "nMaths.h"
 #include "nOutput.h"
 
-#ifndef _WIN32
-
-#define GetLastError() errno
-#define ERROR_BROKEN_PIPE EPIPE
-
-#ifdef HAVE_NANOSLEEP
-#include <ctime>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-int Sleep(double interval)
-{
-    struct timespec tm;
-    interval /= 1000.0;
-    tm.tv_sec = (time_t)interval;
-    tm.tv_nsec = (interval - tm.tv_sec)*1000*1000*1000;
-    return nanosleep(&tm, NULL);
-}
-#else
-#error Neither Windows API nor nanosleep() seems to be available.
-#endif // ifdef HAVE_NANOSLEEP
+#ifndef _WIN32
 
 struct GUID
 {
@@ -418,6 +407,8 @@ struct tRIFF_Rec
 
     uint64_t BytesInBuffer;
 
+    uint8_t* pSamples;                        // start of the sample data most recently read.
+
     void (* ReadTransfer)(unsigned char* pB, unsigned char* pEndB);
     void (* WriteTransfer)(MultiChannelCodecBlock& outputcodecblock, unsigned char* pB);
 
@@ -427,8 +418,10 @@ struct tRIFF_Rec
     uint64_t samplesLeftToRead;
 
     int32_t  wBytesPerSample;
+    bool     IEEE_Float;                      // input only; converted to Global.bits_per_sample PCM.
 
-    std::fstream RIFF_File;
+    tIO_Backend* IO;                          // transport chosen when the file was opened.
+    bool Owns_IO;                             // IO is deleted when the file is closed.
 
     int32_t ID = -1;
 
@@ -436,10 +429,6 @@ struct tRIFF_Rec
     {
         std::string Name;
 
-        uint64_t     (*Read)(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestoread);
-
-        bool         (*Write)(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestowrite);
-
         struct
         {
             bool Open;
@@ -468,8 +457,6 @@ struct tRIFF_Rec
             uint64_t CURRENT;
         } Pos;
 
-        uint32_t Retries;
-
         struct
         {
             bool Read;
@@ -491,8 +478,18 @@ struct RIFF
     tRIFF_Rec CORR;
     uint32_t  EndOfChunkMap = 0;
     uint8_t*  ChunkDATA;
+
+    void (* WriteTransfer_Pair)(MultiChannelCodecBlock& btrdcodecblock, unsigned char* pBTRD, MultiChannelCodecBlock& corrcodecblock, unsigned char* pCORR);
+    bool      CORR_Transferred;               // CORR block already packed along with this BTRD block.
 } RIFF;
 
+struct
+{
+    tIO_Backend* Input;
+    tIO_Backend* Lossy;
+    tIO_Backend* Correction;
+} Supplied_IO;
+
 std::string DateTimeString;
 
 uint64_t BUFFER_SIZEread;                    // number of byte that make up for inbuff
@@ -511,65 +508,71 @@ uint64_t nrOfBlockInBuffNotYetFetched;        // the next number of the block in
 
 } // namespace
 
-uint64_t readfrom_stdin(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestoread)
+uint64_t RIFF_Read(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestoread)
 {
-    uint64_t bytesthisread, bytesread, byteslefttoread;
-    uint64_t lastwinerror;
-
-    bytesread = 0;
-    thisRIFF.File.Retries = 0;
+    uint64_t bytesread = 0;
 
-    while ((bytesread < bytestoread) && (!thisRIFF.File.Cant.Read))
+    if ((thisRIFF.IO != nullptr) && (!thisRIFF.File.Cant.Read))
     {
-        byteslefttoread = bytestoread - bytesread;
+        bytesread = thisRIFF.IO->Read(buffpointer, bytestoread);
+    }
 
-        std::cin.read(static_cast<char *>(buffpointer) + bytesread, byteslefttoread);
+    if (bytesread < bytestoread)
+    {
+        thisRIFF.File.Cant.Read = true;
+    }
 
-        bytesthisread = std::cin.gcount();
+    thisRIFF.File.Last.Read=bytesread;
 
-        if (std::cin.good())
-        {
-            lastwinerror = 0;
-        }
-        else
-        {
-            lastwinerror = GetLastError();
-        }
+    thisRIFF.File.Total_Bytes.Read+=bytesread;
 
-        if (bytesthisread == 0)
-        {
-            ++ thisRIFF.File.Retries;
-            Sleep(PowersOf.TwoX[TWO_OFFSET + std::min(7u, thisRIFF.File.Retries) -11]*1000);
-        }
-        else
-        {
-            thisRIFF.File.Retries = 0;
-        }
+    return bytesread;
+}
 
-        if ((lastwinerror == ERROR_BROKEN_PIPE) || (thisRIFF.File.Retries == 32))
-        {
-            thisRIFF.File.Cant.Read = true;
-        }
 
-        bytesread += bytesthisread;
+bool RIFF_Write(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestowrite)
+{
+    if ((thisRIFF.IO == nullptr) || (thisRIFF.File.Cant.Write) || (!thisRIFF.IO->Write(buffpointer, bytestowrite)))
+    {
+        thisRIFF.File.Cant.Write = true;
+        thisRIFF.File.Last.Write = 0;
+        return false;
     }
 
-    thisRIFF.File.Last.Read=bytesread;
-
-    thisRIFF.File.Total_Bytes.Read+=bytesread;
+    thisRIFF.File.Total_Bytes.Written+=bytestowrite;
+    thisRIFF.File.Last.Write=bytestowrite;
 
-    return bytesread;
+    return true;
 }
 
 
-uint64_t readfrom_file(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestoread)
+//============================================================================
+// Returns a pointer to the next bytestoread bytes of sample data: in place
+// where the backend allows it, otherwise read into Buffer.
+//============================================================================
+uint8_t* ReadSampleBytes(tRIFF_Rec &thisRIFF, uint64_t bytestoread)
 {
     uint64_t bytesread = 0;
-    thisRIFF.File.Retries = 0;
-    thisRIFF.RIFF_File.read((char *) buffpointer, bytestoread);
-    bytesread = thisRIFF.RIFF_File.gcount();
+    uint8_t* window = nullptr;
+
+    if ((thisRIFF.IO != nullptr) && (!thisRIFF.File.Cant.Read))
+    {
+        window = thisRIFF.IO->Window(bytestoread, bytesread);
+    }
+
+    if (window == nullptr)
+    {
+        if (bytestoread > sizeof(thisRIFF.Buffer))
+        {
+            lossyWAVError("Read larger than the WAV buffer.", 0x12);
+        }
+
+        RIFF_Read(thisRIFF, &thisRIFF.Buffer, bytestoread);
+
+        return thisRIFF.Buffer.Bytes;
+    }
 
-    if ((thisRIFF.RIFF_File.bad()) || (bytesread < bytestoread))
+    if (bytesread < bytestoread)
     {
         thisRIFF.File.Cant.Read = true;
     }
@@ -578,64 +581,68 @@ uint64_t readfrom_file(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestor
 
     thisRIFF.File.Total_Bytes.Read+=bytesread;
 
-    return bytesread;
+    return window;
 }
 
 
-uint64_t readfrom_nullptr(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestoread)
+bool nCloseFile(tRIFF_Rec &thisRIFF)
 {
-    thisRIFF.File.Retries = 99;
-    thisRIFF.File.Cant.Read = true;
-    thisRIFF.File.Last.Read = 0;
-    thisRIFF.File.Total_Bytes.Read = 0;
-    buffpointer = buffpointer;
-    bytestoread = bytestoread;
+    bool closed_ok = true;
 
-    return 0;
-}
+    if (thisRIFF.IO != nullptr)
+    {
+        closed_ok = thisRIFF.IO->Close();
 
+        if (thisRIFF.Owns_IO)
+        {
+            delete thisRIFF.IO;
+        }
 
-bool writeto_stdout(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestowrite)
-{
-    std::cout.write(static_cast<char *>(buffpointer), bytestowrite);
-    if (std::cout.bad())
-    {
-        thisRIFF.File.Cant.Write = true;
-        return false;
+        thisRIFF.IO = nullptr;
     }
-    thisRIFF.File.Total_Bytes.Written+=bytestowrite;
-    thisRIFF.File.Last.Write=bytestowrite;
 
-    return true;
+    thisRIFF.File.Is.Open = false;
+    thisRIFF.File.Is.File = false;
+
+    return closed_ok;
+}
+
+
+void nAttachIO(tRIFF_Rec &thisRIFF, tIO_Backend* thisIO, bool owned, bool forwriting)
+{
+    thisRIFF.IO = thisIO;
+    thisRIFF.Owns_IO = owned;
+    thisRIFF.File.Is.Open = (thisIO != nullptr);
+    thisRIFF.File.Is.File = (thisIO != nullptr) && (thisIO->Is_File());
+    thisRIFF.File.Is.Pipe = (thisIO != nullptr) && (!thisIO->Is_File());
+    thisRIFF.File.Cant.Read = forwriting;
+    thisRIFF.File.Cant.Write = !forwriting;
 }
 
 
-bool writeto_file(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestowrite)
+// Hand writes to an output file we opened to a helper thread (--write-buffer
+// 0 writes synchronously instead). Backends supplied by the caller are left
+// as they are, as is stdout: the reader paces a pipe anyway, and its blocks
+// already go out by writev() without being copied.
+void nWriteBehind(tRIFF_Rec &thisRIFF)
 {
-    thisRIFF.RIFF_File.write((char *) buffpointer, bytestowrite);
+    uint64_t writebufferbytes = 1 << 20;
+    tIO_Backend* writebehind;
 
-    if (thisRIFF.RIFF_File.bad())
+    if ((!thisRIFF.Owns_IO) || (!thisRIFF.File.Is.File) || (parameters.write_buffer == 0))
     {
-        thisRIFF.File.Cant.Write = false;
-        return false;
+        return;
     }
 
-    thisRIFF.File.Total_Bytes.Written+=bytestowrite;
-    thisRIFF.File.Last.Write=bytestowrite;
-
-    return true;
-}
+    if (parameters.write_buffer > 0)
+        writebufferbytes = uint64_t(parameters.write_buffer) << 10;
 
+    writebehind = nIO_Write_Behind(thisRIFF.IO, true, writebufferbytes);
 
-bool writeto_nullptr(tRIFF_Rec &thisRIFF, void* buffpointer, uint64_t bytestowrite)
-{
-    thisRIFF.File.Last.Write = 0;
-    thisRIFF.File.Total_Bytes.Written = 0;
-    thisRIFF.File.Cant.Write = true;
-    thisRIFF.File.Retries = 99;
-    buffpointer = buffpointer;
-    bytestowrite = bytestowrite;
-    return false;
+    if (writebehind != nullptr)
+    {
+        thisRIFF.IO = writebehind;
+    }
 }
 
 
@@ -664,7 +671,7 @@ bool WritePaddingToFile(tRIFF_Rec &thisRIFF)
         paddingbytes = QWordAlign(thisRIFF.File.Total_Bytes.Written) - thisRIFF.File.Total_Bytes.Written;
     }
 
-    return ((paddingbytes == 0) || ((paddingbytes != 0) && (thisRIFF.File.Write(thisRIFF, (char*) &GuidData[GUID_VOID], paddingbytes))));
+    return ((paddingbytes == 0) || ((paddingbytes != 0) && (RIFF_Write(thisRIFF, (char*) &GuidData[GUID_VOID], paddingbytes))));
 }
 
 
@@ -689,7 +696,7 @@ bool ReadPaddingFromFile(tRIFF_Rec &thisRIFF)
     }
     else
     {
-        return (thisRIFF.File.Read(thisRIFF, (char*) &paddingtempdata, paddingbytes) == paddingbytes);
+        return (RIFF_Read(thisRIFF, (char*) &paddingtempdata, paddingbytes) == paddingbytes);
     }
 }
 
@@ -724,62 +731,144 @@ void wavIOExitProc(std::string wavIOString, int32_t wavIOCode)
 }
 
 
-void CombineLossyBuffers(int32_t bytes_in_buffer)
+//============================================================================
+// Recombine lossy and correction sample data: each output sample is the
+// lossy sample scaled back by 1 / --scale (rounded half to even) plus the
+// correction sample. bytes must be a whole number of samples.
+//============================================================================
+#if defined(__SSE2__)
+inline __m128i Scale_Int32x4(__m128i v, __m128d inv)
+{
+    __m128i lo = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(v), inv));
+    __m128i hi = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(v, v)), inv));
+
+    return _mm_unpacklo_epi64(lo, hi);
+}
+
+
+// Returns the number of bytes combined; the caller finishes off the rest.
+uint64_t CombineLossy_Vector(const uint8_t* pBTRD, const uint8_t* pCORR, uint8_t* pWAVE, uint64_t bytes)
+{
+    uint64_t done = 0;
+    __m128i btrd, corr;
+
+    if (settings.scaling_factor_inv == 1.0)
+    {
+        const __m128i bias = _mm_set1_epi8(-128);
+
+        for (; done + 16 <= bytes; done += 16)
+        {
+            btrd = _mm_loadu_si128((const __m128i*) (pBTRD + done));
+            corr = _mm_loadu_si128((const __m128i*) (pCORR + done));
+
+            switch (Global.bytes_per_sample)
+            {
+                case 1:
+                    btrd = _mm_add_epi8(_mm_xor_si128(btrd, bias), corr);
+                    break;
+
+                case 2:
+                    btrd = _mm_add_epi16(btrd, corr);
+                    break;
+
+                case 4:
+                    btrd = _mm_add_epi32(btrd, corr);
+                    break;
+
+                default:
+                    return 0;
+            }
+
+            _mm_storeu_si128((__m128i*) (pWAVE + done), btrd);
+        }
+    }
+    else if (Global.bytes_per_sample == 2)
+    {
+        const __m128d inv = _mm_set1_pd(settings.scaling_factor_inv);
+        __m128i lo, hi;
+
+        for (; done + 16 <= bytes; done += 16)
+        {
+            btrd = _mm_loadu_si128((const __m128i*) (pBTRD + done));
+            corr = _mm_loadu_si128((const __m128i*) (pCORR + done));
+
+            lo = Scale_Int32x4(_mm_srai_epi32(_mm_unpacklo_epi16(btrd, btrd), 16), inv);
+            hi = Scale_Int32x4(_mm_srai_epi32(_mm_unpackhi_epi16(btrd, btrd), 16), inv);
+
+            // Keep the low 16 bits of each lane, as the scalar cast does.
+            lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+            hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+
+            _mm_storeu_si128((__m128i*) (pWAVE + done), _mm_add_epi16(_mm_packs_epi32(lo, hi), corr));
+        }
+    }
+
+    return done;
+}
+#endif // __SSE2__
+
+
+void CombineLossySamples(const uint8_t* pBTRD, const uint8_t* pCORR, uint8_t* pWAVE, uint64_t bytes)
 {
-    int32_t cb_i, cb_j;
-    cb_i = bytes_in_buffer / ((int32_t) Global.bytes_per_sample);
+    uint64_t cb_x = 0;
     int32_t btrd_sample, corr_sample;
     DATA32 this_sample;
 
+#if defined(__SSE2__)
+    cb_x = CombineLossy_Vector(pBTRD, pCORR, pWAVE, bytes);
+#endif
+
     switch (Global.bytes_per_sample)
     {
         case 1:
-            for (cb_j = 0; cb_j < cb_i; ++cb_j)
+            for (; cb_x < bytes; ++cb_x)
             {
-                RIFF.WAVE.Buffer.Bytes[cb_j] = (int32_t)(nRoundEvenInt64((RIFF.BTRD.Buffer.Bytes[cb_j] - 128) * settings.scaling_factor_inv) + RIFF.CORR.Buffer.Bytes[cb_j]);
+                pWAVE[cb_x] = (int32_t)(nRoundEvenInt64((pBTRD[cb_x] - 128) * settings.scaling_factor_inv) + pCORR[cb_x]);
             }
 
             break;
 
 
         case 2:
-            for (cb_j = 0; cb_j < cb_i; ++cb_j)
+            for (; cb_x < bytes; cb_x += 2)
             {
-                RIFF.WAVE.Buffer.ShortInts[cb_j] = (int32_t)(nRoundEvenInt64(RIFF.BTRD.Buffer.ShortInts[cb_j] * settings.scaling_factor_inv) + RIFF.CORR.Buffer.ShortInts[cb_j]);
+                int16_t wave_sample = (int32_t)(nRoundEvenInt64(int16_t(pBTRD[cb_x] | (pBTRD[cb_x+1] << 8)) * settings.scaling_factor_inv) + int16_t(pCORR[cb_x] | (pCORR[cb_x+1] << 8)));
+
+                std::memcpy(pWAVE + cb_x, &wave_sample, 2);
             }
 
             break;
 
 
         case 3:
-            for (int32_t cb_x = 0; cb_x < bytes_in_buffer; cb_x+=3)
+            for (; cb_x < bytes; cb_x += 3)
             {
-                btrd_sample = RIFF.BTRD.Buffer.Bytes[cb_x] | (RIFF.BTRD.Buffer.Bytes[cb_x+1] << 8) | (RIFF.BTRD.Buffer.SmallInts[cb_x+2] << 16);
+                btrd_sample = pBTRD[cb_x] | (pBTRD[cb_x+1] << 8) | (int8_t(pBTRD[cb_x+2]) << 16);
 
-                corr_sample = RIFF.CORR.Buffer.Bytes[cb_x] | (RIFF.CORR.Buffer.Bytes[cb_x+1] << 8) | (RIFF.CORR.Buffer.SmallInts[cb_x+2] << 16);
+                corr_sample = pCORR[cb_x] | (pCORR[cb_x+1] << 8) | (int8_t(pCORR[cb_x+2]) << 16);
 
                 this_sample.Integer = nRoundEvenInt32(btrd_sample * settings.scaling_factor_inv) + corr_sample;
 
-                RIFF.WAVE.Buffer.Bytes[cb_x]   = this_sample.Bytes[0];
-                RIFF.WAVE.Buffer.Bytes[cb_x+1] = this_sample.Bytes[1];
-                RIFF.WAVE.Buffer.Bytes[cb_x+2] = this_sample.Bytes[2];
+                pWAVE[cb_x]   = this_sample.Bytes[0];
+                pWAVE[cb_x+1] = this_sample.Bytes[1];
+                pWAVE[cb_x+2] = this_sample.Bytes[2];
             }
 
             break;
 
 
         case 4:
-            for (cb_j = 0; cb_j < cb_i; ++cb_j)
+            for (; cb_x < bytes; cb_x += 4)
             {
-                RIFF.WAVE.Buffer.Integers[cb_j] = (int32_t)(nRoundEvenInt64(RIFF.BTRD.Buffer.Integers[cb_j] * settings.scaling_factor_inv) + RIFF.CORR.Buffer.Integers[cb_j]);
-            }
+                int32_t btrd_int, corr_int;
 
-            break;
+                std::memcpy(&btrd_int, pBTRD + cb_x, 4);
+                std::memcpy(&corr_int, pCORR + cb_x, 4);
 
+                this_sample.Integer = (int32_t)(nRoundEvenInt64(btrd_int * settings.scaling_factor_inv) + corr_int);
 
-        case 8:
-            for (cb_j = 0; cb_j < cb_i; ++cb_j)
-                RIFF.WAVE.Buffer.Int64s[cb_j] = (int64_t)(nRoundEvenInt64(RIFF.BTRD.Buffer.Int64s[cb_j] * settings.scaling_factor_inv) + RIFF.CORR.Buffer.Int64s[cb_j]);
+                std::memcpy(pWAVE + cb_x, &this_sample.Integer, 4);
+            }
 
             break;
 
@@ -789,6 +878,54 @@ void CombineLossyBuffers(int32_t bytes_in_buffer)
 }
 
 
+//============================================================================
+// CombineLossySamples over the whole range, split into sample-aligned slices
+// of at least MERGE_SLICE bytes across up to merge_threads threads. Slices
+// beyond the first run on helper threads; if one cannot be started its
+// slice is done here instead.
+//============================================================================
+static const uint64_t MERGE_SLICE = 1 << 18;
+
+uint32_t merge_threads = 1;
+
+void CombineLossyData(const uint8_t* pBTRD, const uint8_t* pCORR, uint8_t* pWAVE, uint64_t bytes)
+{
+    uint64_t slices = std::max(uint64_t(1), std::min(uint64_t(merge_threads), bytes / MERGE_SLICE));
+    uint64_t slicebytes = (bytes / slices) - ((bytes / slices) % Global.bytes_per_sample);
+
+#ifdef HAVE_STD_THREAD
+    std::vector<std::thread> workers;
+    uint64_t start;
+
+    for (uint64_t thisslice = 1; thisslice < slices; ++thisslice)
+    {
+        start = thisslice * slicebytes;
+
+        uint64_t thisbytes = (thisslice + 1 == slices) ? (bytes - start) : slicebytes;
+
+        try
+        {
+            workers.emplace_back(CombineLossySamples, pBTRD + start, pCORR + start, pWAVE + start, thisbytes);
+        }
+        catch (const std::system_error&)
+        {
+            CombineLossySamples(pBTRD + start, pCORR + start, pWAVE + start, thisbytes);
+        }
+    }
+
+    CombineLossySamples(pBTRD, pCORR, pWAVE, (slices == 1) ? bytes : slicebytes);
+
+    for (auto& thisworker : workers)
+    {
+        thisworker.join();
+    }
+#else
+    slicebytes = slicebytes;
+    CombineLossySamples(pBTRD, pCORR, pWAVE, bytes);
+#endif
+}
+
+
 bool nOpenFile(tRIFF_Rec &thisRIFF, std::string thisname, uint32_t thisfilemode)
 {
     switch (thisfilemode)
@@ -796,36 +933,21 @@ bool nOpenFile(tRIFF_Rec &thisRIFF, std::string thisname, uint32_t thisfilemode)
         case 0:
             //Reset(thisfile, 1);
             thisRIFF.File.Name = thisname.c_str();
-            thisRIFF.RIFF_File.open(thisname.c_str(), std::ios::in | std::ios::binary);
-            thisRIFF.File.Is.File = true;
-            thisRIFF.File.Is.Pipe = false;
-            thisRIFF.File.Read = readfrom_file;
-            thisRIFF.File.Write = writeto_nullptr;
-            thisRIFF.File.Cant.Read = false;
-            thisRIFF.File.Cant.Write = true;
-            thisRIFF.File.Type.RIFF64 = false;
-            thisRIFF.File.Type.WAVE64 = false;
+            nAttachIO(thisRIFF, nIO_Open_Input(thisname), true, false);
             break;
 
         case 2:
             //Rewrite(thisfile, 1);
             thisRIFF.File.Name = "STDIN";
-            thisRIFF.RIFF_File.open(thisname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
-            thisRIFF.File.Is.File = true;
-            thisRIFF.File.Is.Pipe = false;
-            thisRIFF.File.Read = readfrom_nullptr;
-            thisRIFF.File.Write = writeto_file;
-            thisRIFF.File.Cant.Read = true;
-            thisRIFF.File.Cant.Write = false;
-            thisRIFF.File.Type.RIFF64 = false;
-            thisRIFF.File.Type.WAVE64 = false;
+            nAttachIO(thisRIFF, nIO_Open_Output(thisname), true, true);
             break;
 
         default:
             wavIOExitProc("Error: Invalid FileMode!", 0x12);
     }
 
-    thisRIFF.File.Is.Open = thisRIFF.RIFF_File.good();
+    thisRIFF.File.Type.RIFF64 = false;
+    thisRIFF.File.Type.WAVE64 = false;
 
     return thisRIFF.File.Is.Open;
 }
@@ -840,7 +962,7 @@ bool WriteChunkHeader(tRIFF_Rec &thisRIFF)
         tempChunk32.CNum = thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Write].Header.CNum;
         tempChunk32.Size = thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Write].Header.Size;
 
-        if (!thisRIFF.File.Write(thisRIFF, (char*) &tempChunk32, thisRIFF.Chunks.Size.Header))
+        if (!RIFF_Write(thisRIFF, (char*) &tempChunk32, thisRIFF.Chunks.Size.Header))
         {
             if (!thisRIFF.File.Type.RIFF64)
             {
@@ -854,7 +976,7 @@ bool WriteChunkHeader(tRIFF_Rec &thisRIFF)
     }
     else
     {
-        if (!thisRIFF.File.Write(thisRIFF, (char*) &thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Write], thisRIFF.Chunks.Size.Header))
+        if (!RIFF_Write(thisRIFF, (char*) &thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Write], thisRIFF.Chunks.Size.Header))
         {
             wavIOExitProc("Error writing 'riff' chunk.", 0x12);
         }
@@ -873,7 +995,7 @@ void WriteRIFFHeader(tRIFF_Rec &thisRIFF)
         thisChunk32.Size = thisRIFF.Chunks.WAV.Header.Size;
         thisChunk32.RNum = thisRIFF.Chunks.WAV.RNum;
 
-        if (!thisRIFF.File.Write(thisRIFF, (char*) &thisChunk32, thisRIFF.Chunks.Size.RIFF))
+        if (!RIFF_Write(thisRIFF, (char*) &thisChunk32, thisRIFF.Chunks.Size.RIFF))
         {
             if (!thisRIFF.File.Type.RIFF64)
             {
@@ -887,7 +1009,7 @@ void WriteRIFFHeader(tRIFF_Rec &thisRIFF)
     }
     else
     {
-        if (!thisRIFF.File.Write(thisRIFF, (char*) &thisRIFF.Chunks.WAV, thisRIFF.Chunks.Size.RIFF))
+        if (!RIFF_Write(thisRIFF, (char*) &thisRIFF.Chunks.WAV, thisRIFF.Chunks.Size.RIFF))
             wavIOExitProc("Error writing 'riff' chunk.", 0x12);
     }
 }
@@ -905,7 +1027,7 @@ bool WriteChunkHeaderAndPayload(tRIFF_Rec &thisRIFF, void* thispayload)
         return false;
     }
 
-    if (!thisRIFF.File.Write(thisRIFF, thispayload, thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Write].Header.Size - thisRIFF.Chunks.Size.Reduction))
+    if (!RIFF_Write(thisRIFF, thispayload, thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Write].Header.Size - thisRIFF.Chunks.Size.Reduction))
     {
         return false;
     }
@@ -1001,6 +1123,24 @@ bool WriteChunksAfterData(tRIFF_Rec &thisRIFF)
 }
 
 
+// Input sample bytes as written to the output files (fewer for float input).
+uint64_t OutputSampleBytes(uint64_t inputbytes)
+{
+    return inputbytes / RIFF.WAVE.wBytesPerSample * Global.bytes_per_sample;
+}
+
+
+// Pre-allocate the sample data of an output file when the input size is
+// known, so the file system can lay it out in one piece. Best effort only.
+void nReserveSampleBytes(tRIFF_Rec &thisRIFF)
+{
+    if ((thisRIFF.File.Is.File) && (RIFF.WAVE.sampleByteLeftToRead != MAX_uint64_t))
+    {
+        thisRIFF.IO->Reserve(Global.Total_Samples * Global.Channels * Global.bytes_per_sample);
+    }
+}
+
+
 void RewriteDataChunk(tRIFF_Rec &thisRIFF)
 {
     tChunk32Header thisChunk32;
@@ -1011,65 +1151,65 @@ void RewriteDataChunk(tRIFF_Rec &thisRIFF)
     {
         if (!thisRIFF.File.Type.RIFF64)
         {
-            thisRIFF.RIFF_File.seekp(0);
+            thisRIFF.IO->Seek(0);
 
             thisRIFF.Chunks.WAV.Header.Size = uint32_t(thisRIFF.File.Pos.CURRENT - 8);
             thisChunk32.CNum = thisRIFF.Chunks.WAV.Header.CNum;
             thisChunk32.Size = (uint32_t) thisRIFF.Chunks.WAV.Header.Size;
 
-            thisRIFF.RIFF_File.write((const char*) &thisChunk32, 0x08);
+            thisRIFF.IO->Write(&thisChunk32, 0x08);
 
-            thisRIFF.RIFF_File.seekp(thisRIFF.File.Pos.DATA);
-            thisRIFF.Chunks.DATA.Header.Size = RIFF.WAVE.samplebytesread;
+            thisRIFF.IO->Seek(thisRIFF.File.Pos.DATA);
+            thisRIFF.Chunks.DATA.Header.Size = OutputSampleBytes(RIFF.WAVE.samplebytesread);
 
             thisChunk32.CNum = thisRIFF.Chunks.DATA.Header.CNum;
             thisChunk32.Size = (uint32_t) thisRIFF.Chunks.DATA.Header.Size;
 
-            thisRIFF.RIFF_File.write((const char*) &thisChunk32, 0x08);
+            thisRIFF.IO->Write(&thisChunk32, 0x08);
         }
         else
         {
-            thisRIFF.RIFF_File.seekp(0);
+            thisRIFF.IO->Seek(0);
 
             thisRIFF.Chunks.WAV.Header.Size = MAX_uint32_t; //uint32_t(thisRIFF.File.Pos.CURRENT - 8);
             thisChunk32.CNum = thisRIFF.Chunks.WAV.Header.CNum;
             thisChunk32.Size = (uint32_t) thisRIFF.Chunks.WAV.Header.Size;
 
-            thisRIFF.RIFF_File.write((const char*) &thisChunk32, 0x08);
+            thisRIFF.IO->Write(&thisChunk32, 0x08);
 
-            thisRIFF.RIFF_File.seekp(thisRIFF.File.Pos.DS64);
+            thisRIFF.IO->Seek(thisRIFF.File.Pos.DS64);
 
             thisChunk32.CNum = thisRIFF.Chunks.DS64.Header.CNum;
             thisChunk32.Size = (uint32_t) thisRIFF.Chunks.DS64.Header.Size;
 
-            thisRIFF.RIFF_File.write((const char*) &thisChunk32, 0x08);
-            thisRIFF.Chunks.DS64.DATASize = RIFF.WAVE.samplebytesread;
+            thisRIFF.IO->Write(&thisChunk32, 0x08);
+            thisRIFF.Chunks.DS64.DATASize = OutputSampleBytes(RIFF.WAVE.samplebytesread);
             thisRIFF.Chunks.DS64.RIFFSize = thisRIFF.File.Pos.CURRENT;
-            thisRIFF.Chunks.DS64.SampleCount = RIFF.WAVE.samplebytesread / Global.Channels / thisRIFF.wBytesPerSample;
-            thisRIFF.RIFF_File.write((const char*) &thisRIFF.Chunks.DS64.RIFFSize,thisChunk32.Size);
+            thisRIFF.Chunks.DS64.SampleCount = thisRIFF.Chunks.DS64.DATASize / Global.Channels / thisRIFF.wBytesPerSample;
+            thisRIFF.IO->Write(&thisRIFF.Chunks.DS64.RIFFSize,thisChunk32.Size);
 
-            thisRIFF.RIFF_File.seekp(thisRIFF.File.Pos.DATA);
+            thisRIFF.IO->Seek(thisRIFF.File.Pos.DATA);
 
             thisChunk32.CNum = thisRIFF.Chunks.DATA.Header.CNum;
             thisChunk32.Size = MAX_uint32_t;
 
-            thisRIFF.RIFF_File.write((const char*) &thisChunk32, 0x08);
+            thisRIFF.IO->Write(&thisChunk32, 0x08);
         }
     }
     else
     {
-        thisRIFF.RIFF_File.seekp(0);
+        thisRIFF.IO->Seek(0);
 
-        thisRIFF.RIFF_File.write((const char*) &thisRIFF.Chunks.WAV, 0x18);
+        thisRIFF.IO->Write(&thisRIFF.Chunks.WAV, 0x18);
 
-        thisRIFF.RIFF_File.seekp(thisRIFF.File.Pos.DATA);
+        thisRIFF.IO->Seek(thisRIFF.File.Pos.DATA);
 
-        thisRIFF.Chunks.DATA.Header.Size = RIFF.WAVE.samplebytesread;
+        thisRIFF.Chunks.DATA.Header.Size = OutputSampleBytes(RIFF.WAVE.samplebytesread);
 
-        thisRIFF.RIFF_File.write((const char*) &thisRIFF.Chunks.DATA, 0x18);
+        thisRIFF.IO->Write(&thisRIFF.Chunks.DATA, 0x18);
     }
 
-    thisRIFF.RIFF_File.seekp(thisRIFF.File.Pos.CURRENT);
+    thisRIFF.IO->Seek(thisRIFF.File.Pos.CURRENT);
 }
 
 
@@ -1099,7 +1239,7 @@ void DetermineFileType(tRIFF_Rec &thisRIFF)
 
     std::memset((void*) &thisRIFF.Chunks, 0, sizeof(tWAVEChunks));
 
-    if (thisRIFF.File.Read(thisRIFF, (void*) &thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Free].Header, 4) != 4)
+    if (RIFF_Read(thisRIFF, (void*) &thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Free].Header, 4) != 4)
     {
         wavIOExitProc("Error Reading WAV file Information.", 0x11);
     }
@@ -1136,7 +1276,7 @@ void DetermineFileType(tRIFF_Rec &thisRIFF)
     {
         thisRIFF.Chunks.WAV.Header.CNum = thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Free].Header.CNum;
 
-        if (thisRIFF.File.Read(thisRIFF, (void*) &thisChunk32.Size, 0x08) != 0x08)
+        if (RIFF_Read(thisRIFF, (void*) &thisChunk32.Size, 0x08) != 0x08)
         {
             wavIOExitProc("Error Reading WAV file Information.", 0x11);
         }
@@ -1153,7 +1293,7 @@ void DetermineFileType(tRIFF_Rec &thisRIFF)
         {
             thisRIFF.Chunks.WAV.Header.CNum = thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Free].Header.CNum;
 
-            if (thisRIFF.File.Read(thisRIFF, (void*) &thisRIFF.Chunks.WAV.Header.Guid.Data2,0x24) != 0x24)
+            if (RIFF_Read(thisRIFF, (void*) &thisRIFF.Chunks.WAV.Header.Guid.Data2,0x24) != 0x24)
             {
                 wavIOExitProc("Error Reading WAV64 file Information.", 0x11);
             }
@@ -1188,7 +1328,7 @@ bool ReadChunkHeader(tRIFF_Rec &thisRIFF)
     {
         tChunk32Header thisChunk32;
 
-        if (thisRIFF.File.Read(thisRIFF, (char*) &thisChunk32, 0x08) != 0x08)
+        if (RIFF_Read(thisRIFF, (char*) &thisChunk32, 0x08) != 0x08)
         {
             thisRIFF.File.Cant.Read = true;
             return false;
@@ -1199,7 +1339,7 @@ bool ReadChunkHeader(tRIFF_Rec &thisRIFF)
     }
     else
     {
-        if (thisRIFF.File.Read(thisRIFF, (char*) &thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Free].Header.Guid, 0x18) != 0x18)
+        if (RIFF_Read(thisRIFF, (char*) &thisRIFF.Chunks.Map[thisRIFF.Chunks.Current.Free].Header.Guid, 0x18) != 0x18)
         {
             thisRIFF.File.Cant.Read = true;
             return false;
@@ -1227,7 +1367,7 @@ bool ReadChunkData(tRIFF_Rec& thisRIFF)
             wavIOExitProc("FMT Chunk incorrect size.", 0x12);
         }
 
-        if (thisRIFF.File.Read(thisRIFF, (char*) &thisRIFF.Chunks.FMT.wFormatTag, thisChunkSize) != thisChunkSize)
+        if (RIFF_Read(thisRIFF, (char*) &thisRIFF.Chunks.FMT.wFormatTag, thisChunkSize) != thisChunkSize)
         {
             wavIOExitProc("Error reading 'fmt ' chunk.", 0x12);
         }
@@ -1264,7 +1404,7 @@ bool ReadChunkData(tRIFF_Rec& thisRIFF)
             lossyWAVWarning("File type is RF64 and 'RIFF' size <> 0xFFFFFFFF.");
         }
 
-        if (thisRIFF.File.Read(thisRIFF, (char*) &thisRIFF.Chunks.DS64.RIFFSize, thisRIFF.Chunks.DS64.Header.Size) != thisRIFF.Chunks.DS64.Header.Size)
+        if (RIFF_Read(thisRIFF, (char*) &thisRIFF.Chunks.DS64.RIFFSize, thisRIFF.Chunks.DS64.Header.Size) != thisRIFF.Chunks.DS64.Header.Size)
         {
             wavIOExitProc("Error reading 'ds64' chunk.", 0x12);
         }
@@ -1317,7 +1457,7 @@ bool ReadChunkData(tRIFF_Rec& thisRIFF)
 
         thisRIFF.Chunks.FACT.Header = thisMapRecord->Header;
 
-        if (!(thisRIFF.File.Read(thisRIFF, (char*) thisMapRecord->DATA, thisChunkSize) == thisChunkSize))
+        if (!(RIFF_Read(thisRIFF, (char*) thisMapRecord->DATA, thisChunkSize) == thisChunkSize))
         {
             wavIOExitProc("Error reading 'fact' chunk", 0x12);
         }
@@ -1332,7 +1472,6 @@ bool ReadChunkData(tRIFF_Rec& thisRIFF)
 
         if (std::string(thisRIFF.Chunks.FACT.DATA, 8) != "lossyWAV")
         {
-            std::cerr << "!!!" << std::endl;
             thisRIFF.Chunks.FACT.Header.Size = 0;
         }
         else
@@ -1352,7 +1491,7 @@ bool ReadChunkData(tRIFF_Rec& thisRIFF)
     }
     else
     {
-        if (!(thisRIFF.File.Read(thisRIFF, (char*) thisMapRecord->DATA, thisChunkSize) == thisChunkSize))
+        if (!(RIFF_Read(thisRIFF, (char*) thisMapRecord->DATA, thisChunkSize) == thisChunkSize))
         {
             wavIOExitProc("Error reading '"+std::string(thisMapRecord->Header.ID,4)+"' chunk.", 0x12);
         }
@@ -1367,6 +1506,18 @@ bool ReadChunkData(tRIFF_Rec& thisRIFF)
 }
 
 
+bool FMT_Is_PCM(const tFMTChunk &thisFMT)
+{
+    return (thisFMT.wFormatTag == 1) || ((thisFMT.wFormatTag == 0xFFFE) && (thisFMT.SubFormat_Word[0] == 1));
+}
+
+
+bool FMT_Is_IEEE_Float(const tFMTChunk &thisFMT)
+{
+    return (thisFMT.wFormatTag == 3) || ((thisFMT.wFormatTag == 0xFFFE) && (thisFMT.SubFormat_Word[0] == 3));
+}
+
+
 void ReadChunksUpToDATA(tRIFF_Rec &thisRIFF)
 {
     DetermineFileType(thisRIFF);
@@ -1388,7 +1539,7 @@ void ReadChunksUpToDATA(tRIFF_Rec &thisRIFF)
         }
     }
 
-    if ((thisRIFF.Chunks.FMT.wFormatTag != 1) && ((thisRIFF.Chunks.FMT.wFormatTag == 0xFFFE) && (thisRIFF.Chunks.FMT.SubFormat_Word[0] != 1)))
+    if ((!FMT_Is_PCM(thisRIFF.Chunks.FMT)) && ((parameters.merging) || (!FMT_Is_IEEE_Float(thisRIFF.Chunks.FMT))))
     {
         wavIOExitProc("WAV Data is not uncompressed PCM.", 0x12);
     }
@@ -1454,15 +1605,26 @@ void WCH(tChunkHeader thisHeader, bool isWAVE64)
 }
 
 
+//============================================================================
+// Merge a lossy and correction file pair back into the original. When both
+// inputs are mapped the sample data is combined straight out of the mappings
+// in MERGE_CHUNK pieces, split across threads; otherwise it is read into the
+// RIFF buffers BUFFER_SIZE at a time. The output is written behind as for
+// processing.
+//============================================================================
+static const uint64_t MERGE_CHUNK = 1 << 23;
+
 void MergeFiles()
 {
-    uint32_t thisread;
-    uint64_t numreads;
-    uint32_t lastread;
-    uint64_t readcount;
-    uint64_t readbyteCount = 0;
+    uint64_t thisread;
+    uint64_t chunksize;
+    uint64_t bytesleft;
     uint64_t DATASize;
     uint64_t RIFFSize;
+    uint8_t* pBTRD;
+    uint8_t* pCORR;
+    uint8_t* pWAVE;
+    std::vector<uint8_t> mergebuffer;
 
     std::string temp_str;
 
@@ -1600,11 +1762,24 @@ void MergeFiles()
 
     BUFFER_SIZEtouse = BUFFER_SIZE - (BUFFER_SIZE % (Global.bytes_per_sample * RIFF.BTRD.Chunks.FMT.wChannels));
 
-    lastread = DATASize % BUFFER_SIZEtouse;
-    numreads = (DATASize / BUFFER_SIZEtouse + ((uint32_t) lastread > 0)) - 1;
+    chunksize = BUFFER_SIZEtouse;
+    pWAVE = RIFF.WAVE.Buffer.Bytes;
+
+    if ((RIFF.BTRD.IO->Is_Mapped()) && (RIFF.CORR.IO->Is_Mapped()))
+    {
+        chunksize = MERGE_CHUNK - (MERGE_CHUNK % (Global.bytes_per_sample * RIFF.BTRD.Chunks.FMT.wChannels));
+        mergebuffer.resize(std::min(chunksize, DATASize));
+        pWAVE = mergebuffer.data();
+
+#ifdef HAVE_STD_THREAD
+        merge_threads = std::max(1u, std::min(8u, std::thread::hardware_concurrency()));
+#endif
+    }
 
     nOpenFile(RIFF.WAVE, parameters.WavOutDir + parameters.wavName, 2);
 
+    nWriteBehind(RIFF.WAVE);
+
     RIFF.WAVE.Chunks = RIFF.BTRD.Chunks;
 
     RIFF.WAVE.File.Type = RIFF.BTRD.File.Type; // Copy file type information AFTER opening file.
@@ -1614,6 +1789,8 @@ void MergeFiles()
         lossyWAVError("Writing to output file.", 0x12);
     }
 
+    RIFF.WAVE.IO->Reserve(DATASize);
+
     std::string source(&RIFF.WAVE.Chunks.FACT.DATA[0]), key("--scale ");
     size_t pos = source.find(key);
 
@@ -1633,42 +1810,32 @@ void MergeFiles()
 
     settings.scaling_factor_inv = 1.0 / settings.scaling_factor;
 
-    for (readcount = 0; readcount <= numreads; ++readcount)
+    for (bytesleft = DATASize; bytesleft > 0; bytesleft -= thisread)
     {
-        if (readcount == numreads)
-        {
-            thisread = lastread;
-        }
-        else
-        {
-            thisread = BUFFER_SIZEtouse;
-        }
+        thisread = std::min(bytesleft, chunksize);
 
-        RIFF.BTRD.File.Read(RIFF.BTRD, (char*) &RIFF.BTRD.Buffer, thisread);
-        if (!RIFF.BTRD.RIFF_File.gcount())
+        pBTRD = ReadSampleBytes(RIFF.BTRD, thisread);
+
+        if (RIFF.BTRD.File.Last.Read != thisread)
         {
             lossyWAVError("Reading lossy audio data.",0x12);
         }
 
-        RIFF.CORR.File.Read(RIFF.CORR, (char*) &RIFF.CORR.Buffer, thisread);
+        pCORR = ReadSampleBytes(RIFF.CORR, thisread);
 
-        if (!RIFF.CORR.RIFF_File.gcount())
+        if (RIFF.CORR.File.Last.Read != thisread)
         {
             lossyWAVError("Reading lwcdf audio data.",0x12);
         }
 
-        readbyteCount = readbyteCount + thisread;
-
-        CombineLossyBuffers(thisread);
+        CombineLossyData(pBTRD, pCORR, pWAVE, thisread);
 
-        RIFF.WAVE.File.Write(RIFF.WAVE, (char*) &RIFF.WAVE.Buffer, thisread);
+        RIFF_Write(RIFF.WAVE, pWAVE, thisread);
 
         std::cerr << "\rProgress: " << (double(RIFF.WAVE.File.Total_Bytes.Written) / RIFFSize * 100)/*: 0: 2*/ << "%     ";
     }
 
-    RIFF.CORR.RIFF_File.close();
-
-    if (RIFF.CORR.RIFF_File.bad())
+    if (!nCloseFile(RIFF.CORR))
         lossyWAVError("Closing correction file.", 0x12);
 
     if (!ReadPaddingFromFile(RIFF.BTRD))
@@ -1677,9 +1844,7 @@ void MergeFiles()
     if (!ReadChunksAfterDATA(RIFF.BTRD))
         lossyWAVError("Reading chunks after data chunk from lossy file.", 0x12);
 
-    RIFF.BTRD.RIFF_File.close();
-
-    if (RIFF.BTRD.RIFF_File.bad())
+    if (!nCloseFile(RIFF.BTRD))
         lossyWAVError("Closing lossy file.", 0x12);
 
     RIFF.WAVE.Chunks = RIFF.BTRD.Chunks;
@@ -1693,241 +1858,1090 @@ void MergeFiles()
     if (!WritePaddingToFile(RIFF.WAVE))
         lossyWAVError("Writing chunk padding to merged file.", 0x12);
 
-    RIFF.WAVE.RIFF_File.close();
-
-    if (RIFF.WAVE.RIFF_File.bad())
+    if (!nCloseFile(RIFF.WAVE))
         lossyWAVError("Closing merged file.", 0x12);
 
     std::cerr << "\rProgress: " << (double(RIFF.WAVE.File.Total_Bytes.Written) / RIFFSize * 100)/*: 0: 2*/ << "%     ";
 }
 
 
-void ReadTransfer_One(unsigned char* pB, unsigned char* pEndB)
-{
-    int32_t iSample = 0;
+//============================================================================
+// Deinterleave from the interleaved PCM in the read buffer (or mapping) into
+// the planar DATA64 codec block. ReadTransfer_T is instantiated for the
+// common channel counts so that the per-frame channel loop is unrolled;
+// CHANNELS == 0 is the generic fallback. Where an SSE kernel exists,
+// ReadTransfer_Vector transfers the leading whole vectors of the block and
+// returns the number of frames it has done; the scalar loop finishes off.
+//============================================================================
+typedef void (* tReadTransfer)(unsigned char* pB, unsigned char* pEndB);
 
-    while (pB < pEndB)
-    {
-        for (int32_t iChannel = 0; iChannel < Global.Channels; ++iChannel)
-        {
-            AudioData.WAVEPTR[NEXT_CODEC_BLOCK][iChannel][iSample].Int64 = int64_t(*pB) - 128;
-            pB++;
-        }
 
-        ++ iSample;
-    }
+template <int32_t BYTES> inline int64_t ReadSample(const unsigned char* pB);
+
+template <> inline int64_t ReadSample<1>(const unsigned char* pB)
+{
+    return int64_t(*pB) - 128;
 }
 
+template <> inline int64_t ReadSample<2>(const unsigned char* pB)
+{
+    return int64_t(*(const int16_t*) pB);
+}
 
-void ReadTransfer_Two(unsigned char* pB, unsigned char* pEndB)
+template <> inline int64_t ReadSample<3>(const unsigned char* pB)
 {
-    int32_t iSample = 0;
+    return int64_t(int32_t((uint32_t(pB[0]) << 8) | (uint32_t(pB[1]) << 16) | (uint32_t(pB[2]) << 24)) >> 8);
+}
 
-    while (pB < pEndB)
-    {
-        for (int32_t iChannel = 0; iChannel < Global.Channels; ++iChannel)
-        {
-            AudioData.WAVEPTR[NEXT_CODEC_BLOCK][iChannel][iSample].Int64 = int64_t(*(short*) pB);
-            pB += 2;
-        }
+template <> inline int64_t ReadSample<4>(const unsigned char* pB)
+{
+    return int64_t(*(const int32_t*) pB);
+}
 
-        ++ iSample;
-    }
+
+template <int32_t BYTES, int32_t CHANNELS>
+inline int32_t ReadTransfer_Vector(unsigned char* & /*pB*/, unsigned char* /*pEndB*/)
+{
+    return 0;
 }
 
 
-void ReadTransfer_Three(unsigned char* pB, unsigned char* pEndB)
+#if defined(__SSE2__)
+inline void Store_Int32x4_As_Int64(DATA64* dest, __m128i v)
 {
-    int32_t iSample = 0;
-    DATA32 this32;
+    __m128i sign = _mm_srai_epi32(v, 31);
 
-    while (pB < pEndB)
-    {
-        for (int32_t iChannel = 0; iChannel < Global.Channels; ++iChannel)
-        {
-            this32.Words[0] = (*(uint16_t*) pB);
-            pB += 2;
-            this32.ShortInts[1] = (*(int8_t*) pB);
-            pB++;
+    _mm_storeu_si128((__m128i*) dest, _mm_unpacklo_epi32(v, sign));
+    _mm_storeu_si128((__m128i*) (dest + 2), _mm_unpackhi_epi32(v, sign));
+}
 
-            AudioData.WAVEPTR[NEXT_CODEC_BLOCK][iChannel][iSample].Int64 = (int64_t) this32.Integer;
-        }
 
-        ++ iSample;
-    }
+// Lower two lanes to dest_a, upper two lanes to dest_b.
+inline void Store_Int32x2x2_As_Int64(DATA64* dest_a, DATA64* dest_b, __m128i v)
+{
+    __m128i sign = _mm_srai_epi32(v, 31);
+
+    _mm_storeu_si128((__m128i*) dest_a, _mm_unpacklo_epi32(v, sign));
+    _mm_storeu_si128((__m128i*) dest_b, _mm_unpackhi_epi32(v, sign));
 }
 
 
-void ReadTransfer_Four(unsigned char* pB, unsigned char* pEndB)
+//============================================================================
+// One frame of up to eight channels as two vectors of int32: channels 0..3
+// and channels 4..7. Reads up to 16 bytes beyond the first vector's data,
+// which ReadTransfer_Vector_Wide allows for.
+//============================================================================
+template <int32_t BYTES> inline void Load_Frame(const unsigned char* pB, __m128i &lo, __m128i &hi);
+
+template <> inline void Load_Frame<2>(const unsigned char* pB, __m128i &lo, __m128i &hi)
 {
-    int32_t iSample = 0;
+    __m128i v = _mm_loadu_si128((const __m128i*) pB);
 
-    while (pB < pEndB)
-    {
-        for (int32_t iChannel = 0; iChannel < Global.Channels; ++iChannel)
-        {
-            AudioData.WAVEPTR[NEXT_CODEC_BLOCK][iChannel][iSample].Int64 = (int64_t)(*(int32_t*) pB);
-            pB += 4;
-        }
+    lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+}
 
-        ++ iSample;
-    }
+template <> inline void Load_Frame<4>(const unsigned char* pB, __m128i &lo, __m128i &hi)
+{
+    lo = _mm_loadu_si128((const __m128i*) pB);
+    hi = _mm_loadu_si128((const __m128i*) (pB + 16));
 }
 
+#if defined(__SSSE3__)
+// 3 byte samples into the top of each 32 bit lane, then shifted down to sign extend.
+inline __m128i Load_Int24x4(const unsigned char* pB, __m128i mask)
+{
+    return _mm_srai_epi32(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) pB), mask), 8);
+}
 
-bool readNextNextCodecBlock()
+template <> inline void Load_Frame<3>(const unsigned char* pB, __m128i &lo, __m128i &hi)
 {
-    unsigned char* pB;
-    unsigned char* pStartB;
-    uint64_t thisblockreadlength;
+    const __m128i mask = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
 
-    AudioData.Size.Next = 0;
+    lo = Load_Int24x4(pB, mask);
+    hi = Load_Int24x4(pB + 12, mask);
+}
+#endif // __SSSE3__
 
-    if (RIFF.WAVE.File.Cant.Read)
+
+template <int32_t BYTES>
+struct tFrame_Loader
+{
+    inline void operator()(const unsigned char* pB, __m128i &lo, __m128i &hi) const
     {
-        return false;
+        Load_Frame<BYTES>(pB, lo, hi);
     }
+};
 
-    if (nrOfBlockInBuffNotYetFetched == 0)  // samples to be fetched aren't in inbuff
+
+//============================================================================
+// Six or eight channels: four frames at a time, transposed so that each
+// channel is written as four consecutive samples. LOADER fetches one frame
+// as int32 (tFrame_Loader for integer PCM, tFloat_Frame_Loader for float).
+//============================================================================
+template <int32_t BYTES, int32_t CHANNELS, typename LOADER = tFrame_Loader<BYTES> >
+inline int32_t ReadTransfer_Vector_Wide(unsigned char* &pB, unsigned char* pEndB, const LOADER& load = LOADER())
+{
+    static const int32_t FRAME = BYTES * CHANNELS;
+
+    MultiChannelCodecBlockPtr dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK];
+    int32_t iSample = 0;
+    __m128i r[8];
+    __m128i t[4];
+    __m128i c[8];
+
+    while ((pEndB - pB) >= 4 * FRAME + 16)
     {
-        if ((nrOfFullBlocksReadIntoInBuff < nrOfBlocksInReadBuff) || (RIFF.WAVE.sampleByteLeftToRead == 0))  // EOF encountered with last call to readNextSampleBlock
+        load(pB,             r[0], r[4]);
+        load(pB + FRAME,     r[1], r[5]);
+        load(pB + FRAME * 2, r[2], r[6]);
+        load(pB + FRAME * 3, r[3], r[7]);
+
+        for (int32_t half = 0; half < 8; half += 4)
         {
-            return false; // no more data
-        }
+            t[0] = _mm_unpacklo_epi32(r[half + 0], r[half + 1]);
+            t[1] = _mm_unpacklo_epi32(r[half + 2], r[half + 3]);
+            t[2] = _mm_unpackhi_epi32(r[half + 0], r[half + 1]);
+            t[3] = _mm_unpackhi_epi32(r[half + 2], r[half + 3]);
 
-        thisblockreadlength = std::min(BUFFER_SIZEread, RIFF.WAVE.sampleByteLeftToRead);
-        RIFF.WAVE.File.Read(RIFF.WAVE, &RIFF.WAVE.Buffer, thisblockreadlength);
+            c[half + 0] = _mm_unpacklo_epi64(t[0], t[1]);
+            c[half + 1] = _mm_unpackhi_epi64(t[0], t[1]);
+            c[half + 2] = _mm_unpacklo_epi64(t[2], t[3]);
+            c[half + 3] = _mm_unpackhi_epi64(t[2], t[3]);
+        }
 
-        if (!parameters.ignorechunksizes)
+        for (int32_t iChannel = 0; iChannel < CHANNELS; ++iChannel)
+        {
+            Store_Int32x4_As_Int64(&dest[iChannel][iSample], c[iChannel]);
+        }
+
+        pB += 4 * FRAME;
+        iSample += 4;
+    }
+
+    return iSample;
+}
+
+
+template <>
+inline int32_t ReadTransfer_Vector<2, 1>(unsigned char* &pB, unsigned char* pEndB)
+{
+    DATA64* dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK][0];
+    int32_t iSample = 0;
+    __m128i lo, hi;
+
+    while ((pEndB - pB) >= 16)
+    {
+        Load_Frame<2>(pB, lo, hi);
+        Store_Int32x4_As_Int64(&dest[iSample], lo);
+        Store_Int32x4_As_Int64(&dest[iSample + 4], hi);
+        pB += 16;
+        iSample += 8;
+    }
+
+    return iSample;
+}
+
+
+// Each 32 bit lane holds one frame: left in the low half, right in the high half.
+template <>
+inline int32_t ReadTransfer_Vector<2, 2>(unsigned char* &pB, unsigned char* pEndB)
+{
+    MultiChannelCodecBlockPtr dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK];
+    int32_t iSample = 0;
+    __m128i v;
+
+    while ((pEndB - pB) >= 16)
+    {
+        v = _mm_loadu_si128((const __m128i*) pB);
+        Store_Int32x4_As_Int64(&dest[0][iSample], _mm_srai_epi32(_mm_slli_epi32(v, 16), 16));
+        Store_Int32x4_As_Int64(&dest[1][iSample], _mm_srai_epi32(v, 16));
+        pB += 16;
+        iSample += 4;
+    }
+
+    return iSample;
+}
+
+
+template <>
+inline int32_t ReadTransfer_Vector<2, 6>(unsigned char* &pB, unsigned char* pEndB)
+{
+    return ReadTransfer_Vector_Wide<2, 6>(pB, pEndB);
+}
+
+
+template <>
+inline int32_t ReadTransfer_Vector<2, 8>(unsigned char* &pB, unsigned char* pEndB)
+{
+    return ReadTransfer_Vector_Wide<2, 8>(pB, pEndB);
+}
+
+
+#if defined(__SSSE3__)
+template <>
+inline int32_t ReadTransfer_Vector<3, 1>(unsigned char* &pB, unsigned char* pEndB)
+{
+    const __m128i mask = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+
+    DATA64* dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK][0];
+    int32_t iSample = 0;
+
+    while ((pEndB - pB) >= 16)
+    {
+        Store_Int32x4_As_Int64(&dest[iSample], Load_Int24x4(pB, mask));
+        pB += 12;
+        iSample += 4;
+    }
+
+    return iSample;
+}
+
+
+// Two frames per vector, shuffled to L0 L1 R0 R1.
+template <>
+inline int32_t ReadTransfer_Vector<3, 2>(unsigned char* &pB, unsigned char* pEndB)
+{
+    const __m128i mask = _mm_setr_epi8(-1, 0, 1, 2, -1, 6, 7, 8, -1, 3, 4, 5, -1, 9, 10, 11);
+
+    MultiChannelCodecBlockPtr dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK];
+    int32_t iSample = 0;
+
+    while ((pEndB - pB) >= 16)
+    {
+        Store_Int32x2x2_As_Int64(&dest[0][iSample], &dest[1][iSample], Load_Int24x4(pB, mask));
+        pB += 12;
+        iSample += 2;
+    }
+
+    return iSample;
+}
+
+
+template <>
+inline int32_t ReadTransfer_Vector<3, 6>(unsigned char* &pB, unsigned char* pEndB)
+{
+    return ReadTransfer_Vector_Wide<3, 6>(pB, pEndB);
+}
+
+
+template <>
+inline int32_t ReadTransfer_Vector<3, 8>(unsigned char* &pB, unsigned char* pEndB)
+{
+    return ReadTransfer_Vector_Wide<3, 8>(pB, pEndB);
+}
+#endif // __SSSE3__
+
+
+template <>
+inline int32_t ReadTransfer_Vector<4, 1>(unsigned char* &pB, unsigned char* pEndB)
+{
+    DATA64* dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK][0];
+    int32_t iSample = 0;
+
+    while ((pEndB - pB) >= 16)
+    {
+        Store_Int32x4_As_Int64(&dest[iSample], _mm_loadu_si128((const __m128i*) pB));
+        pB += 16;
+        iSample += 4;
+    }
+
+    return iSample;
+}
+
+
+template <>
+inline int32_t ReadTransfer_Vector<4, 2>(unsigned char* &pB, unsigned char* pEndB)
+{
+    MultiChannelCodecBlockPtr dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK];
+    int32_t iSample = 0;
+    __m128i v;
+
+    while ((pEndB - pB) >= 16)
+    {
+        v = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*) pB), _MM_SHUFFLE(3, 1, 2, 0));
+        Store_Int32x2x2_As_Int64(&dest[0][iSample], &dest[1][iSample], v);
+        pB += 16;
+        iSample += 2;
+    }
+
+    return iSample;
+}
+
+
+template <>
+inline int32_t ReadTransfer_Vector<4, 6>(unsigned char* &pB, unsigned char* pEndB)
+{
+    return ReadTransfer_Vector_Wide<4, 6>(pB, pEndB);
+}
+
+
+template <>
+inline int32_t ReadTransfer_Vector<4, 8>(unsigned char* &pB, unsigned char* pEndB)
+{
+    return ReadTransfer_Vector_Wide<4, 8>(pB, pEndB);
+}
+#endif // __SSE2__
+
+
+//============================================================================
+// 32-bit IEEE float input is scaled to Global.bits_per_sample integers as it
+// is deinterleaved: multiplied by 2^(bits - 1) in double precision, clamped
+// to the integer range and rounded to nearest, ties to even. NaN clamps to
+// the negative limit. The scalar and SSE2 paths give identical results.
+//============================================================================
+struct tFloat_Range
+{
+    double scale;
+    double lo;
+    double hi;
+
+    tFloat_Range()
+    {
+        scale = PowersOf.TwoX[TWO_OFFSET + Global.bits_per_sample - 1];
+        lo = -scale;
+        hi = scale - 1;
+    }
+};
+
+
+inline int64_t ReadSample_Float(const unsigned char* pB, const tFloat_Range& range)
+{
+    float thissample;
+    std::memcpy(&thissample, pB, sizeof(float));
+
+    double v = thissample * range.scale;
+    v = (v > range.lo) ? v : range.lo;
+    v = (v < range.hi) ? v : range.hi;
+
+    return nRoundEvenInt64(v);
+}
+
+
+template <int32_t CHANNELS>
+inline int32_t ReadTransfer_Float_Vector(unsigned char* & /*pB*/, unsigned char* /*pEndB*/, const tFloat_Range& /*range*/)
+{
+    return 0;
+}
+
+
+#if defined(__SSE2__)
+// MAXPD / MINPD return the second operand when either is NaN, as the scalar
+// comparisons in ReadSample_Float do.
+struct tFloat_Frame_Loader
+{
+    __m128d scale;
+    __m128d lo;
+    __m128d hi;
+
+    explicit tFloat_Frame_Loader(const tFloat_Range& range)
+    {
+        scale = _mm_set1_pd(range.scale);
+        lo = _mm_set1_pd(range.lo);
+        hi = _mm_set1_pd(range.hi);
+    }
+
+    inline __m128i Convert(const unsigned char* pB) const
+    {
+        __m128 f = _mm_loadu_ps((const float*) pB);
+        __m128d a = _mm_mul_pd(_mm_cvtps_pd(f), scale);
+        __m128d b = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(f, f)), scale);
+
+        a = _mm_min_pd(_mm_max_pd(a, lo), hi);
+        b = _mm_min_pd(_mm_max_pd(b, lo), hi);
+
+        return _mm_unpacklo_epi64(_mm_cvtpd_epi32(a), _mm_cvtpd_epi32(b));
+    }
+
+    inline void operator()(const unsigned char* pB, __m128i &lo_frame, __m128i &hi_frame) const
+    {
+        lo_frame = Convert(pB);
+        hi_frame = Convert(pB + 16);
+    }
+};
+
+
+template <>
+inline int32_t ReadTransfer_Float_Vector<1>(unsigned char* &pB, unsigned char* pEndB, const tFloat_Range& range)
+{
+    DATA64* dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK][0];
+    const tFloat_Frame_Loader load(range);
+    int32_t iSample = 0;
+
+    while ((pEndB - pB) >= 16)
+    {
+        Store_Int32x4_As_Int64(&dest[iSample], load.Convert(pB));
+        pB += 16;
+        iSample += 4;
+    }
+
+    return iSample;
+}
+
+
+template <>
+inline int32_t ReadTransfer_Float_Vector<2>(unsigned char* &pB, unsigned char* pEndB, const tFloat_Range& range)
+{
+    MultiChannelCodecBlockPtr dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK];
+    const tFloat_Frame_Loader load(range);
+    int32_t iSample = 0;
+    __m128i v;
+
+    while ((pEndB - pB) >= 16)
+    {
+        v = _mm_shuffle_epi32(load.Convert(pB), _MM_SHUFFLE(3, 1, 2, 0));
+        Store_Int32x2x2_As_Int64(&dest[0][iSample], &dest[1][iSample], v);
+        pB += 16;
+        iSample += 2;
+    }
+
+    return iSample;
+}
+
+
+template <>
+inline int32_t ReadTransfer_Float_Vector<6>(unsigned char* &pB, unsigned char* pEndB, const tFloat_Range& range)
+{
+    return ReadTransfer_Vector_Wide<4, 6>(pB, pEndB, tFloat_Frame_Loader(range));
+}
+
+
+template <>
+inline int32_t ReadTransfer_Float_Vector<8>(unsigned char* &pB, unsigned char* pEndB, const tFloat_Range& range)
+{
+    return ReadTransfer_Vector_Wide<4, 8>(pB, pEndB, tFloat_Frame_Loader(range));
+}
+#endif // __SSE2__
+
+
+template <int32_t BYTES, int32_t CHANNELS>
+void ReadTransfer_T(unsigned char* pB, unsigned char* pEndB)
+{
+    const int32_t channels = (CHANNELS > 0) ? CHANNELS : Global.Channels;
+
+    MultiChannelCodecBlockPtr dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK];
+    int32_t iSample = ReadTransfer_Vector<BYTES, CHANNELS>(pB, pEndB);
+
+    while (pB < pEndB)
+    {
+        for (int32_t iChannel = 0; iChannel < channels; ++iChannel)
+        {
+            dest[iChannel][iSample].Int64 = ReadSample<BYTES>(pB);
+            pB += BYTES;
+        }
+
+        ++ iSample;
+    }
+}
+
+
+template <int32_t BYTES>
+tReadTransfer ReadTransfer_For_Channels(int32_t channels)
+{
+    switch (channels)
+    {
+        case 1:
+            return ReadTransfer_T<BYTES, 1>;
+        case 2:
+            return ReadTransfer_T<BYTES, 2>;
+        case 6:
+            return ReadTransfer_T<BYTES, 6>;
+        case 8:
+            return ReadTransfer_T<BYTES, 8>;
+        default:
+            return ReadTransfer_T<BYTES, 0>;
+    }
+}
+
+
+template <int32_t CHANNELS>
+void ReadTransfer_Float_T(unsigned char* pB, unsigned char* pEndB)
+{
+    const int32_t channels = (CHANNELS > 0) ? CHANNELS : Global.Channels;
+    const tFloat_Range range;
+
+    MultiChannelCodecBlockPtr dest = AudioData.WAVEPTR[NEXT_CODEC_BLOCK];
+    int32_t iSample = ReadTransfer_Float_Vector<CHANNELS>(pB, pEndB, range);
+
+    while (pB < pEndB)
+    {
+        for (int32_t iChannel = 0; iChannel < channels; ++iChannel)
+        {
+            dest[iChannel][iSample].Int64 = ReadSample_Float(pB, range);
+            pB += sizeof(float);
+        }
+
+        ++ iSample;
+    }
+}
+
+
+tReadTransfer ReadTransfer_Float_For_Channels(int32_t channels)
+{
+    switch (channels)
+    {
+        case 1:
+            return ReadTransfer_Float_T<1>;
+        case 2:
+            return ReadTransfer_Float_T<2>;
+        case 6:
+            return ReadTransfer_Float_T<6>;
+        case 8:
+            return ReadTransfer_Float_T<8>;
+        default:
+            return ReadTransfer_Float_T<0>;
+    }
+}
+
+
+bool readNextNextCodecBlock()
+{
+    unsigned char* pB;
+    unsigned char* pStartB;
+    uint64_t thisblockreadlength;
+
+    AudioData.Size.Next = 0;
+
+    if (nrOfBlockInBuffNotYetFetched == 0)  // samples to be fetched aren't in inbuff
+    {
+        if ((RIFF.WAVE.File.Cant.Read) || (nrOfFullBlocksReadIntoInBuff < nrOfBlocksInReadBuff) || (RIFF.WAVE.sampleByteLeftToRead == 0))  // EOF encountered with last call to readNextSampleBlock
+        {
+            return false; // no more data
+        }
+
+        thisblockreadlength = std::min(BUFFER_SIZEread, RIFF.WAVE.sampleByteLeftToRead);
+        RIFF.WAVE.pSamples = ReadSampleBytes(RIFF.WAVE, thisblockreadlength);
+
+        if (!parameters.ignorechunksizes)
         {
             RIFF.WAVE.sampleByteLeftToRead -= RIFF.WAVE.File.Last.Read;
         }
 
-        RIFF.WAVE.samplebytesread = RIFF.WAVE.samplebytesread + RIFF.WAVE.File.Last.Read;
-        nrOfFullBlocksReadIntoInBuff = RIFF.WAVE.File.Last.Read / nrOfByteInOneBlockInBuff;
-        nrOfByteOfTheLastIncompleteBlock = int32_t(RIFF.WAVE.File.Last.Read % nrOfByteInOneBlockInBuff);
-        nrOfBlockInBuffNotYetFetched = 1;
+        RIFF.WAVE.samplebytesread = RIFF.WAVE.samplebytesread + RIFF.WAVE.File.Last.Read;
+        nrOfFullBlocksReadIntoInBuff = RIFF.WAVE.File.Last.Read / nrOfByteInOneBlockInBuff;
+        nrOfByteOfTheLastIncompleteBlock = int32_t(RIFF.WAVE.File.Last.Read % nrOfByteInOneBlockInBuff);
+        nrOfBlockInBuffNotYetFetched = 1;
+    }
+
+    pB = RIFF.WAVE.pSamples;
+    pB += (nrOfBlockInBuffNotYetFetched - 1) * nrOfByteInOneBlockInBuff;
+
+    pStartB = pB; // points to first sample in Block
+
+    if (nrOfBlockInBuffNotYetFetched <= nrOfFullBlocksReadIntoInBuff)
+    {
+        pB += nrOfByteInOneBlockInBuff; // pB points to the spot after last sample in Block
+        AudioData.Size.Next = uint32_t(nrOfByteInOneBlockInBuff / (((uint32_t) RIFF.WAVE.wBytesPerSample * Global.Channels)));
+        nrOfBlockInBuffNotYetFetched = nrOfBlockInBuffNotYetFetched + 1;
+
+        if (nrOfBlockInBuffNotYetFetched > nrOfBlocksInReadBuff)
+        {
+            nrOfBlockInBuffNotYetFetched = 0;
+        }
+    }
+    else
+    {
+        if (nrOfByteOfTheLastIncompleteBlock == 0)
+        {
+            return false;
+        }
+
+        pB += nrOfByteOfTheLastIncompleteBlock;  // pB points to the spot after last sample in Block
+        AudioData.Size.Next = uint32_t(nrOfByteOfTheLastIncompleteBlock / (((uint32_t) RIFF.WAVE.wBytesPerSample * Global.Channels)));
+        nrOfBlockInBuffNotYetFetched = 0; // force a try for a new Blockread with next call which will lead to a return False
+    }
+
+    RIFF.WAVE.ReadTransfer(pStartB, pB);
+
+    return true;
+}
+
+
+//============================================================================
+// Interleave the planar DATA64 output blocks into PCM in the RIFF buffer.
+// tWrite_Packer<BYTES, CHANNELS>::Pack writes GROUP whole frames at a time
+// with SSE where a kernel exists (GROUP == 0 otherwise); WriteSample
+// finishes off. WriteTransfer_Pair_T packs the BTRD and CORR blocks in the
+// same pass over the frames.
+//============================================================================
+typedef void (* tWriteTransfer)(MultiChannelCodecBlock& outputcodecblock, unsigned char* pB);
+typedef void (* tWriteTransferPair)(MultiChannelCodecBlock& btrdcodecblock, unsigned char* pBTRD, MultiChannelCodecBlock& corrcodecblock, unsigned char* pCORR);
+
+
+template <int32_t BYTES> inline void WriteSample(unsigned char* pB, const DATA64& thissample);
+
+template <> inline void WriteSample<1>(unsigned char* pB, const DATA64& thissample)
+{
+    (*pB) = thissample.Bytes[0] + 128;
+}
+
+template <> inline void WriteSample<2>(unsigned char* pB, const DATA64& thissample)
+{
+    (*(short*) pB) = thissample.Words[0];
+}
+
+template <> inline void WriteSample<3>(unsigned char* pB, const DATA64& thissample)
+{
+    (*(short*) pB) = thissample.Words[0];
+    pB[2] = thissample.Bytes[2];
+}
+
+template <> inline void WriteSample<4>(unsigned char* pB, const DATA64& thissample)
+{
+    (*(int32_t*) pB) = thissample.Integers[0];
+}
+
+
+template <int32_t BYTES, int32_t CHANNELS>
+struct tWrite_Packer
+{
+    static const int32_t GROUP = 0;
+
+    static inline void Pack(MultiChannelCodecBlock& /*outputcodecblock*/, int32_t /*iSample*/, unsigned char* /*pB*/) {}
+};
+
+
+#if defined(__SSE2__)
+// Low 32 bits of four consecutive DATA64 samples.
+inline __m128i Load_Int64x4_Low32(const DATA64* src)
+{
+    __m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*) src));
+    __m128 b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*) (src + 2)));
+
+    return _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+
+// Truncates (rather than saturates) each int32 to int16, as the scalar path does.
+inline __m128i Pack_Int32x8_To_Int16(__m128i lo, __m128i hi)
+{
+    return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16), _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+}
+
+
+inline void Store_Bytes_12(unsigned char* pB, __m128i v)
+{
+    _mm_storel_epi64((__m128i*) pB, v);
+    (*(int32_t*) (pB + 8)) = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+}
+
+
+inline void Store_Bytes_6(unsigned char* pB, __m128i v)
+{
+    (*(int32_t*) pB) = _mm_cvtsi128_si32(v);
+    (*(short*) (pB + 4)) = short(_mm_extract_epi16(v, 2));
+}
+
+
+//============================================================================
+// Six or eight channels: four samples of each channel, transposed to four
+// frames of channels 0..3 (lo) and 4..7 (hi).
+//============================================================================
+template <int32_t CHANNELS>
+inline void Transpose_To_Frames(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, __m128i (&lo)[4], __m128i (&hi)[4])
+{
+    __m128i c[8];
+    __m128i t[4];
+
+    for (int32_t iChannel = 0; iChannel < 8; ++iChannel)
+    {
+        c[iChannel] = (iChannel < CHANNELS) ? Load_Int64x4_Low32(&outputcodecblock[iChannel][iSample]) : _mm_setzero_si128();
+    }
+
+    for (int32_t half = 0; half < 8; half += 4)
+    {
+        __m128i (&r)[4] = (half == 0) ? lo : hi;
+
+        t[0] = _mm_unpacklo_epi32(c[half + 0], c[half + 1]);
+        t[1] = _mm_unpacklo_epi32(c[half + 2], c[half + 3]);
+        t[2] = _mm_unpackhi_epi32(c[half + 0], c[half + 1]);
+        t[3] = _mm_unpackhi_epi32(c[half + 2], c[half + 3]);
+
+        r[0] = _mm_unpacklo_epi64(t[0], t[1]);
+        r[1] = _mm_unpackhi_epi64(t[0], t[1]);
+        r[2] = _mm_unpacklo_epi64(t[2], t[3]);
+        r[3] = _mm_unpackhi_epi64(t[2], t[3]);
+    }
+}
+
+
+template <>
+struct tWrite_Packer<2, 1>
+{
+    static const int32_t GROUP = 8;
+
+    static inline void Pack(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, unsigned char* pB)
+    {
+        _mm_storeu_si128((__m128i*) pB, Pack_Int32x8_To_Int16(Load_Int64x4_Low32(&outputcodecblock[0][iSample]), Load_Int64x4_Low32(&outputcodecblock[0][iSample + 4])));
+    }
+};
+
+
+// Each 32 bit lane becomes one frame: left in the low half, right in the high half.
+template <>
+struct tWrite_Packer<2, 2>
+{
+    static const int32_t GROUP = 4;
+
+    static inline void Pack(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, unsigned char* pB)
+    {
+        __m128i left  = Load_Int64x4_Low32(&outputcodecblock[0][iSample]);
+        __m128i right = Load_Int64x4_Low32(&outputcodecblock[1][iSample]);
+
+        _mm_storeu_si128((__m128i*) pB, _mm_or_si128(_mm_and_si128(left, _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(right, 16)));
+    }
+};
+
+
+template <int32_t CHANNELS>
+struct tWrite_Packer_Wide_16
+{
+    static const int32_t GROUP = 4;
+
+    static inline void Pack(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, unsigned char* pB)
+    {
+        __m128i lo[4], hi[4];
+
+        Transpose_To_Frames<CHANNELS>(outputcodecblock, iSample, lo, hi);
+
+        for (int32_t iFrame = 0; iFrame < 4; ++iFrame)
+        {
+            __m128i v = Pack_Int32x8_To_Int16(lo[iFrame], hi[iFrame]);
+
+            if (CHANNELS == 8)
+            {
+                _mm_storeu_si128((__m128i*) pB, v);
+            }
+            else
+            {
+                Store_Bytes_12(pB, v);
+            }
+
+            pB += CHANNELS * 2;
+        }
+    }
+};
+
+template <> struct tWrite_Packer<2, 6> : tWrite_Packer_Wide_16<6> {};
+template <> struct tWrite_Packer<2, 8> : tWrite_Packer_Wide_16<8> {};
+
+
+template <>
+struct tWrite_Packer<4, 1>
+{
+    static const int32_t GROUP = 4;
+
+    static inline void Pack(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, unsigned char* pB)
+    {
+        _mm_storeu_si128((__m128i*) pB, Load_Int64x4_Low32(&outputcodecblock[0][iSample]));
     }
+};
 
-    pB = (unsigned char*)(&RIFF.WAVE.Buffer);
-    pB += (nrOfBlockInBuffNotYetFetched - 1) * nrOfByteInOneBlockInBuff;
 
-    pStartB = pB; // points to first sample in Block
+template <>
+struct tWrite_Packer<4, 2>
+{
+    static const int32_t GROUP = 4;
 
-    if (nrOfBlockInBuffNotYetFetched <= nrOfFullBlocksReadIntoInBuff)
+    static inline void Pack(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, unsigned char* pB)
     {
-        pB += nrOfByteInOneBlockInBuff; // pB points to the spot after last sample in Block
-        AudioData.Size.Next = uint32_t(nrOfByteInOneBlockInBuff / (((uint32_t) Global.bytes_per_sample * Global.Channels)));
-        nrOfBlockInBuffNotYetFetched = nrOfBlockInBuffNotYetFetched + 1;
+        __m128i left  = Load_Int64x4_Low32(&outputcodecblock[0][iSample]);
+        __m128i right = Load_Int64x4_Low32(&outputcodecblock[1][iSample]);
 
-        if (nrOfBlockInBuffNotYetFetched > nrOfBlocksInReadBuff)
-        {
-            nrOfBlockInBuffNotYetFetched = 0;
-        }
+        _mm_storeu_si128((__m128i*) pB, _mm_unpacklo_epi32(left, right));
+        _mm_storeu_si128((__m128i*) (pB + 16), _mm_unpackhi_epi32(left, right));
     }
-    else
+};
+
+
+template <int32_t CHANNELS>
+struct tWrite_Packer_Wide_32
+{
+    static const int32_t GROUP = 4;
+
+    static inline void Pack(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, unsigned char* pB)
     {
-        if (nrOfByteOfTheLastIncompleteBlock == 0)
+        __m128i lo[4], hi[4];
+
+        Transpose_To_Frames<CHANNELS>(outputcodecblock, iSample, lo, hi);
+
+        for (int32_t iFrame = 0; iFrame < 4; ++iFrame)
         {
-            return false;
-        }
+            _mm_storeu_si128((__m128i*) pB, lo[iFrame]);
 
-        pB += nrOfByteOfTheLastIncompleteBlock;  // pB points to the spot after last sample in Block
-        AudioData.Size.Next = uint32_t(nrOfByteOfTheLastIncompleteBlock / (((uint32_t) Global.bytes_per_sample * Global.Channels)));
-        nrOfBlockInBuffNotYetFetched = 0; // force a try for a new Blockread with next call which will lead to a return False
+            if (CHANNELS == 8)
+            {
+                _mm_storeu_si128((__m128i*) (pB + 16), hi[iFrame]);
+            }
+            else
+            {
+                _mm_storel_epi64((__m128i*) (pB + 16), hi[iFrame]);
+            }
+
+            pB += CHANNELS * 4;
+        }
     }
+};
 
-    RIFF.WAVE.ReadTransfer(pStartB, pB);
+template <> struct tWrite_Packer<4, 6> : tWrite_Packer_Wide_32<6> {};
+template <> struct tWrite_Packer<4, 8> : tWrite_Packer_Wide_32<8> {};
 
-    return true;
+
+#if defined(__SSSE3__)
+// Low three bytes of each 32 bit lane, packed into the first 12 bytes.
+inline __m128i Pack_Int32x4_To_Int24(__m128i v)
+{
+    return _mm_shuffle_epi8(v, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
 }
 
 
-void WriteTransfer_One(MultiChannelCodecBlock& outputcodecblock, unsigned char* pB)
+template <>
+struct tWrite_Packer<3, 1>
+{
+    static const int32_t GROUP = 4;
+
+    static inline void Pack(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, unsigned char* pB)
+    {
+        Store_Bytes_12(pB, Pack_Int32x4_To_Int24(Load_Int64x4_Low32(&outputcodecblock[0][iSample])));
+    }
+};
+
+
+template <>
+struct tWrite_Packer<3, 2>
+{
+    static const int32_t GROUP = 4;
+
+    static inline void Pack(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, unsigned char* pB)
+    {
+        __m128i left  = Load_Int64x4_Low32(&outputcodecblock[0][iSample]);
+        __m128i right = Load_Int64x4_Low32(&outputcodecblock[1][iSample]);
+
+        Store_Bytes_12(pB, Pack_Int32x4_To_Int24(_mm_unpacklo_epi32(left, right)));
+        Store_Bytes_12(pB + 12, Pack_Int32x4_To_Int24(_mm_unpackhi_epi32(left, right)));
+    }
+};
+
+
+template <int32_t CHANNELS>
+struct tWrite_Packer_Wide_24
 {
-    for (int32_t wt_i = 0; wt_i < AudioData.Size.This; ++wt_i)
-        for (int32_t wt_j = 0; wt_j < Global.Channels; ++wt_j)
+    static const int32_t GROUP = 4;
+
+    static inline void Pack(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, unsigned char* pB)
+    {
+        __m128i lo[4], hi[4];
+
+        Transpose_To_Frames<CHANNELS>(outputcodecblock, iSample, lo, hi);
+
+        for (int32_t iFrame = 0; iFrame < 4; ++iFrame)
         {
-            (*pB) = outputcodecblock[wt_j][wt_i].Bytes[0] + 128;
-            pB++;
+            Store_Bytes_12(pB, Pack_Int32x4_To_Int24(lo[iFrame]));
+
+            if (CHANNELS == 8)
+            {
+                Store_Bytes_12(pB + 12, Pack_Int32x4_To_Int24(hi[iFrame]));
+            }
+            else
+            {
+                Store_Bytes_6(pB + 12, Pack_Int32x4_To_Int24(hi[iFrame]));
+            }
+
+            pB += CHANNELS * 3;
         }
+    }
+};
+
+template <> struct tWrite_Packer<3, 6> : tWrite_Packer_Wide_24<6> {};
+template <> struct tWrite_Packer<3, 8> : tWrite_Packer_Wide_24<8> {};
+#endif // __SSSE3__
+#endif // __SSE2__
+
+
+template <int32_t BYTES, int32_t CHANNELS>
+inline unsigned char* WriteTransfer_Frame(MultiChannelCodecBlock& outputcodecblock, int32_t iSample, unsigned char* pB)
+{
+    const int32_t channels = (CHANNELS > 0) ? CHANNELS : Global.Channels;
+
+    for (int32_t iChannel = 0; iChannel < channels; ++iChannel)
+    {
+        WriteSample<BYTES>(pB, outputcodecblock[iChannel][iSample]);
+        pB += BYTES;
+    }
+
+    return pB;
 }
 
 
-void WriteTransfer_Two(MultiChannelCodecBlock& outputcodecblock, unsigned char* pB)
+template <int32_t BYTES, int32_t CHANNELS>
+void WriteTransfer_T(MultiChannelCodecBlock& outputcodecblock, unsigned char* pB)
 {
-    for (int32_t wt_i = 0; wt_i < AudioData.Size.This; ++wt_i)
-        for (int32_t wt_j = 0; wt_j < Global.Channels; ++wt_j)
+    typedef tWrite_Packer<BYTES, CHANNELS> Packer;
+
+    int32_t iSample = 0;
+
+    if (Packer::GROUP > 0)
+    {
+        for (; iSample + Packer::GROUP <= AudioData.Size.This; iSample += Packer::GROUP)
         {
-            (*(short*) pB) = outputcodecblock[wt_j][wt_i].Words[0];
-            pB+=2;
+            Packer::Pack(outputcodecblock, iSample, pB);
+            pB += Packer::GROUP * BYTES * CHANNELS;
         }
+    }
+
+    for (; iSample < AudioData.Size.This; ++iSample)
+    {
+        pB = WriteTransfer_Frame<BYTES, CHANNELS>(outputcodecblock, iSample, pB);
+    }
 }
 
 
-void WriteTransfer_Three(MultiChannelCodecBlock& outputcodecblock, unsigned char* pB)
+template <int32_t BYTES, int32_t CHANNELS>
+void WriteTransfer_Pair_T(MultiChannelCodecBlock& btrdcodecblock, unsigned char* pBTRD, MultiChannelCodecBlock& corrcodecblock, unsigned char* pCORR)
 {
-    DATA32 this32;
+    typedef tWrite_Packer<BYTES, CHANNELS> Packer;
 
-    for (int32_t wt_i = 0; wt_i < AudioData.Size.This; ++wt_i)
-        for (int32_t wt_j = 0; wt_j < Global.Channels; ++wt_j)
-        {
-            this32.Integer = outputcodecblock[wt_j][wt_i].Integers[0];
+    int32_t iSample = 0;
 
-            (*(short*) pB) = this32.Words[0];
-            pB+=2;
-            (*pB) = this32.Bytes[2];
-            pB++;
+    if (Packer::GROUP > 0)
+    {
+        for (; iSample + Packer::GROUP <= AudioData.Size.This; iSample += Packer::GROUP)
+        {
+            Packer::Pack(btrdcodecblock, iSample, pBTRD);
+            Packer::Pack(corrcodecblock, iSample, pCORR);
+            pBTRD += Packer::GROUP * BYTES * CHANNELS;
+            pCORR += Packer::GROUP * BYTES * CHANNELS;
         }
+    }
+
+    for (; iSample < AudioData.Size.This; ++iSample)
+    {
+        pBTRD = WriteTransfer_Frame<BYTES, CHANNELS>(btrdcodecblock, iSample, pBTRD);
+        pCORR = WriteTransfer_Frame<BYTES, CHANNELS>(corrcodecblock, iSample, pCORR);
+    }
 }
 
 
-void WriteTransfer_Four(MultiChannelCodecBlock& outputcodecblock, unsigned char* pB)
+template <int32_t BYTES>
+tWriteTransfer WriteTransfer_For_Channels(int32_t channels)
 {
-    for (int32_t wt_i = 0; wt_i < AudioData.Size.This; ++wt_i)
-        for (int32_t wt_j = 0; wt_j < Global.Channels; ++wt_j)
-        {
-            (*(int32_t*) pB) = outputcodecblock[wt_j][wt_i].Integers[0];
-            pB+=4;
-        }
+    switch (channels)
+    {
+        case 1:
+            return WriteTransfer_T<BYTES, 1>;
+        case 2:
+            return WriteTransfer_T<BYTES, 2>;
+        case 6:
+            return WriteTransfer_T<BYTES, 6>;
+        case 8:
+            return WriteTransfer_T<BYTES, 8>;
+        default:
+            return WriteTransfer_T<BYTES, 0>;
+    }
+}
+
+
+template <int32_t BYTES>
+tWriteTransferPair WriteTransfer_Pair_For_Channels(int32_t channels)
+{
+    switch (channels)
+    {
+        case 1:
+            return WriteTransfer_Pair_T<BYTES, 1>;
+        case 2:
+            return WriteTransfer_Pair_T<BYTES, 2>;
+        case 6:
+            return WriteTransfer_Pair_T<BYTES, 6>;
+        case 8:
+            return WriteTransfer_Pair_T<BYTES, 8>;
+        default:
+            return WriteTransfer_Pair_T<BYTES, 0>;
+    }
 }
 
 
-static void (* WriteTransferProcs[5])(MultiChannelCodecBlock & outputcodecblock, unsigned char* pB) = {nullptr, WriteTransfer_One, WriteTransfer_Two, WriteTransfer_Three, WriteTransfer_Four};
-static void (* ReadTransferprocs [5])(unsigned char* pB, unsigned char* pEndB)                               = {nullptr, ReadTransfer_One,  ReadTransfer_Two,  ReadTransfer_Three,  ReadTransfer_Four };
+static tWriteTransfer (* WriteTransferProcs[5])(int32_t channels)                                              = {nullptr, WriteTransfer_For_Channels<1>, WriteTransfer_For_Channels<2>, WriteTransfer_For_Channels<3>, WriteTransfer_For_Channels<4>};
+static tWriteTransferPair (* WriteTransferPairProcs[5])(int32_t channels)                                      = {nullptr, WriteTransfer_Pair_For_Channels<1>, WriteTransfer_Pair_For_Channels<2>, WriteTransfer_Pair_For_Channels<3>, WriteTransfer_Pair_For_Channels<4>};
+static tReadTransfer (* ReadTransferprocs [5])(int32_t channels)                                               = {nullptr, ReadTransfer_For_Channels<1>, ReadTransfer_For_Channels<2>, ReadTransfer_For_Channels<3>, ReadTransfer_For_Channels<4>};
 
 
-bool writeNextCodecBlock(tRIFF_Rec &thisRIFF, MultiChannelCodecBlock& outputcodecblock)
+uint32_t CodecBlockBytes(tRIFF_Rec &thisRIFF)
 {
-    uint32_t nrOfByteForOutBuff = ((int32_t) Global.bytes_per_sample) * thisRIFF.Chunks.FMT.wChannels * AudioData.Size.This;
-    unsigned char* pB;
+    return ((int32_t) Global.bytes_per_sample) * thisRIFF.Chunks.FMT.wChannels * AudioData.Size.This;
+}
 
+
+bool MakeRoomInRIFFBuffer(tRIFF_Rec &thisRIFF, uint32_t nrOfByteForOutBuff)
+{
     if ((thisRIFF.BytesInBuffer + nrOfByteForOutBuff) > BUFFER_SIZEwrite)
     {
-        if (!thisRIFF.File.Write(thisRIFF, (char*)&thisRIFF.Buffer, thisRIFF.BytesInBuffer))
+        if (!RIFF_Write(thisRIFF, (char*)&thisRIFF.Buffer, thisRIFF.BytesInBuffer))
             return false;
 
         thisRIFF.BytesInBuffer = 0;
     }
 
-    pB = (unsigned char*) &thisRIFF.Buffer; // Check this // TY
-    pB += thisRIFF.BytesInBuffer;
+    return true;
+}
+
+
+bool writeNextCodecBlock(tRIFF_Rec &thisRIFF, MultiChannelCodecBlock& outputcodecblock)
+{
+    uint32_t nrOfByteForOutBuff = CodecBlockBytes(thisRIFF);
+
+    if (!MakeRoomInRIFFBuffer(thisRIFF, nrOfByteForOutBuff))
+        return false;
 
-    thisRIFF.WriteTransfer(outputcodecblock, pB);
+    thisRIFF.WriteTransfer(outputcodecblock, thisRIFF.Buffer.Bytes + thisRIFF.BytesInBuffer);
     thisRIFF.BytesInBuffer += nrOfByteForOutBuff;
 
     return true;
 }
 
 
+//============================================================================
+// When the correction file is being written and its buffer has room, the
+// CORR block is packed in the same pass as the BTRD block and
+// writeNextCORRcodecblock only has to note that it is done. Otherwise CORR
+// is packed (after flushing its buffer) by writeNextCORRcodecblock, so that
+// a write error is still reported against the right file.
+//============================================================================
 bool writeNextBTRDcodecblock()
 {
-    return writeNextCodecBlock(RIFF.BTRD, AudioData.BTRDDATA[AudioData.Rev_LUT[THIS_CODEC_BLOCK]]);
+    uint32_t nrOfByteForOutBuff = CodecBlockBytes(RIFF.BTRD);
+
+    MultiChannelCodecBlock& btrdcodecblock = AudioData.BTRDDATA[AudioData.Rev_LUT[THIS_CODEC_BLOCK]];
+    MultiChannelCodecBlock& corrcodecblock = AudioData.CORRDATA[AudioData.Rev_LUT[THIS_CODEC_BLOCK]];
+
+    if (!MakeRoomInRIFFBuffer(RIFF.BTRD, nrOfByteForOutBuff))
+        return false;
+
+    RIFF.CORR_Transferred = (parameters.correction) && (RIFF.CORR.File.Is.Open) && (RIFF.CORR.BytesInBuffer + nrOfByteForOutBuff <= BUFFER_SIZEwrite);
+
+    if (RIFF.CORR_Transferred)
+    {
+        RIFF.WriteTransfer_Pair(btrdcodecblock, RIFF.BTRD.Buffer.Bytes + RIFF.BTRD.BytesInBuffer, corrcodecblock, RIFF.CORR.Buffer.Bytes + RIFF.CORR.BytesInBuffer);
+        RIFF.CORR.BytesInBuffer += nrOfByteForOutBuff;
+    }
+    else
+    {
+        RIFF.BTRD.WriteTransfer(btrdcodecblock, RIFF.BTRD.Buffer.Bytes + RIFF.BTRD.BytesInBuffer);
+    }
+
+    RIFF.BTRD.BytesInBuffer += nrOfByteForOutBuff;
+
+    return true;
 }
 
 
 bool writeNextCORRcodecblock()
 {
+    if (RIFF.CORR_Transferred)
+    {
+        RIFF.CORR_Transferred = false;
+        return true;
+    }
+
     return writeNextCodecBlock(RIFF.CORR, AudioData.CORRDATA[AudioData.Rev_LUT[THIS_CODEC_BLOCK]]);
 }
 
@@ -1936,7 +2950,7 @@ bool FlushRIFFBuffer(tRIFF_Rec &thisRIFF)
 {
     if (thisRIFF.BytesInBuffer > 0)
     {
-        if (!thisRIFF.File.Write(thisRIFF, (char*) &thisRIFF.Buffer, thisRIFF.BytesInBuffer))
+        if (!RIFF_Write(thisRIFF, (char*) &thisRIFF.Buffer, thisRIFF.BytesInBuffer))
         {
             return false;
         }
@@ -1978,13 +2992,13 @@ bool FlushWriteChunksAndClose(tRIFF_Rec &thisRIFF)
 
         if (thisRIFF.File.Is.File)
         {
-            thisRIFF.RIFF_File.close();
-            thisRIFF.File.Is.Open = false;
-            thisRIFF.File.Is.File = false;
-
-            if (thisRIFF.RIFF_File.bad())
+            if (!nCloseFile(thisRIFF))
                 return false;
         }
+        else if (!thisRIFF.IO->Flush())
+        {
+            return false;
+        }
     }
 
     return true;
@@ -2001,11 +3015,7 @@ bool closeWavIO()
     {
         if (RIFF.WAVE.File.Is.File)
         {
-            RIFF.WAVE.RIFF_File.close();
-            RIFF.WAVE.File.Is.Open = false;
-            RIFF.WAVE.File.Is.File = false;
-
-            if (RIFF.WAVE.RIFF_File.bad())
+            if (!nCloseFile(RIFF.WAVE))
                 return false;
         }
     }
@@ -2029,6 +3039,99 @@ bool closeWavIO()
 }
 
 
+//============================================================================
+// For IEEE float input, rewrite the chunk set copied to the output files so
+// that it describes Global.bits_per_sample integer PCM: the 'fmt ' fields,
+// and the 'data' size with the 'RIFF' / 'ds64' sizes that include it. The
+// input's own 'fact' chunk (sample length, required for non-PCM formats) is
+// dropped, leaving the lossyWAV 'fact' chunk as the only one written.
+//============================================================================
+void Convert_Chunks_To_Integer_PCM(tWAVEChunks &thisChunks)
+{
+    uint64_t oldDATASize, newDATASize;
+    uint32_t cc_i, cc_j;
+
+    for (cc_i = 0; cc_i < thisChunks.Pos.DATA; cc_i++)
+    {
+        if ((thisChunks.Map[cc_i].Header.CNum != 0x74636166) || (cc_i == thisChunks.Pos.fact)) // 'fact'
+        {
+            continue;
+        }
+
+        if (RIFF.WAVE.File.Type.RIFF64)
+        {
+            thisChunks.DS64.RIFFSize -= WordAlign(thisChunks.Map[cc_i].Header.Size + 0x08);
+        }
+        else if (RIFF.WAVE.File.Type.WAVE64)
+        {
+            thisChunks.WAV.Header.Size -= QWordAlign(thisChunks.Map[cc_i].Header.Size);
+        }
+        else if ((thisChunks.WAV.Header.Size != 0) && (thisChunks.WAV.Header.Size < MAX_WAVE_SIZE))
+        {
+            thisChunks.WAV.Header.Size -= WordAlign(thisChunks.Map[cc_i].Header.Size + 0x08);
+        }
+
+        for (cc_j = cc_i + 1; cc_j < thisChunks.Current.Free; cc_j++)
+        {
+            thisChunks.Map[cc_j - 1] = thisChunks.Map[cc_j];
+        }
+
+        thisChunks.Current.Free--;
+
+        if (thisChunks.Pos.fact > cc_i) thisChunks.Pos.fact--;
+        if (thisChunks.Pos.DATA > cc_i) thisChunks.Pos.DATA--;
+        if (thisChunks.Pos.LAST > cc_i) thisChunks.Pos.LAST--;
+
+        cc_i--;
+    }
+
+    if (thisChunks.FMT.wFormatTag == 0xFFFE)
+    {
+        thisChunks.FMT.Guid = GuidData[GUID_PCM];
+        thisChunks.FMT.Samples.wValidBitsPerSample = Global.bits_per_sample;
+    }
+    else
+    {
+        thisChunks.FMT.wFormatTag = 1;
+    }
+
+    thisChunks.FMT.wBitsPerSample = Global.bits_per_sample;
+    thisChunks.FMT.nBlockAlign = thisChunks.FMT.wChannels * Global.bytes_per_sample;
+    thisChunks.FMT.nAvgBytesPerSec = thisChunks.FMT.nSamplesPerSec * thisChunks.FMT.nBlockAlign;
+
+    if (RIFF.WAVE.File.Type.RIFF64)
+    {
+        oldDATASize = thisChunks.DS64.DATASize;
+        newDATASize = OutputSampleBytes(oldDATASize);
+
+        thisChunks.DS64.DATASize = newDATASize;
+        thisChunks.DS64.RIFFSize -= (oldDATASize + (oldDATASize & 1)) - (newDATASize + (newDATASize & 1));
+    }
+    else if (RIFF.WAVE.File.Type.WAVE64)
+    {
+        oldDATASize = thisChunks.DATA.Header.Size;
+        newDATASize = OutputSampleBytes(oldDATASize - 0x18) + 0x18;
+
+        thisChunks.DATA.Header.Size = newDATASize;
+        thisChunks.Map[thisChunks.Pos.DATA].Header.Size = newDATASize;
+        thisChunks.WAV.Header.Size -= QWordAlign(oldDATASize) - QWordAlign(newDATASize);
+    }
+    else if ((thisChunks.DATA.Header.Size != 0) && (thisChunks.DATA.Header.Size != MAX_uint32_t))
+    {
+        oldDATASize = thisChunks.DATA.Header.Size;
+        newDATASize = OutputSampleBytes(oldDATASize);
+
+        thisChunks.DATA.Header.Size = newDATASize;
+        thisChunks.Map[thisChunks.Pos.DATA].Header.Size = newDATASize;
+
+        if ((thisChunks.WAV.Header.Size != 0) && (thisChunks.WAV.Header.Size < MAX_WAVE_SIZE))
+        {
+            thisChunks.WAV.Header.Size -= WordAlign(oldDATASize) - WordAlign(newDATASize);
+        }
+    }
+}
+
+
 void Create_FACT_Chunk(tRIFF_Rec &thisRIFF)
 {
     date_time_string_make(strings.datestamp,timer.StartTime);
@@ -2055,18 +3158,21 @@ void Create_FACT_Chunk(tRIFF_Rec &thisRIFF)
 
 bool openWavIO()
 {
+    uint64_t readbufferbytes;
+
     Global.Codec_Block.Size = 0;
 
-    if (parameters.STDINPUT)
+    if (Supplied_IO.Input != nullptr)
+    {
+        nAttachIO(RIFF.WAVE, Supplied_IO.Input, false, false);
+    }
+    else if (parameters.STDINPUT)
     {
         #ifdef _WIN32
         _setmode(STDIN_FILENO, _O_BINARY);
         #endif
 
-        RIFF.WAVE.File.Read = readfrom_stdin;
-        RIFF.WAVE.File.Is.Open = true;
-        RIFF.WAVE.File.Is.Pipe = true;
-        RIFF.WAVE.File.Is.File = false;
+        nAttachIO(RIFF.WAVE, nIO_Open_Stdin(), true, false);
     }
     else
     {
@@ -2083,19 +3189,48 @@ bool openWavIO()
         wavIOExitProc("Zero sample WAV file!?!", 0x12);
     }
 
-    Global.bits_per_sample = RIFF.WAVE.Chunks.FMT.wBitsPerSample;
-
     RIFF.WAVE.wBytesPerSample = (RIFF.WAVE.Chunks.FMT.wBitsPerSample + 7) >> 3;
 
-    Global.bytes_per_sample = RIFF.WAVE.wBytesPerSample;
+    RIFF.WAVE.IEEE_Float = FMT_Is_IEEE_Float(RIFF.WAVE.Chunks.FMT);
+
+    if (RIFF.WAVE.IEEE_Float)
+    {
+        if (RIFF.WAVE.Chunks.FMT.wBitsPerSample != 32)
+        {
+            lossyWAVError(std::string("Invalid IEEE float bitdepth: ") + NumToStr(RIFF.WAVE.Chunks.FMT.wBitsPerSample), 0x12);
+        }
+
+        if (parameters.output_bits == 0)
+        {
+            parameters.output_bits = 24;
+        }
+
+        Global.bits_per_sample = parameters.output_bits;
+    }
+    else
+    {
+        if (parameters.output_bits != 0)
+        {
+            lossyWAVWarning("--output-bits ignored, input is not IEEE float.");
+            parameters.output_bits = 0;
+        }
+
+        Global.bits_per_sample = RIFF.WAVE.Chunks.FMT.wBitsPerSample;
+    }
+
+    Global.bytes_per_sample = (Global.bits_per_sample + 7) >> 3;
 
     if ((Global.bytes_per_sample < 1) || (Global.bytes_per_sample > 4))
     {
         lossyWAVError(std::string("Invalid bitdepth: ") + NumToStr(RIFF.BTRD.Chunks.FMT.wBitsPerSample), 0x12);
     }
 
-    RIFF.WAVE.ReadTransfer = ReadTransferprocs[Global.bytes_per_sample];
-    RIFF.WAVE.WriteTransfer = WriteTransferProcs[Global.bytes_per_sample];
+    if (RIFF.WAVE.IEEE_Float)
+        RIFF.WAVE.ReadTransfer = ReadTransfer_Float_For_Channels(RIFF.WAVE.Chunks.FMT.wChannels);
+    else
+        RIFF.WAVE.ReadTransfer = ReadTransferprocs[RIFF.WAVE.wBytesPerSample](RIFF.WAVE.Chunks.FMT.wChannels);
+
+    RIFF.WAVE.WriteTransfer = WriteTransferProcs[Global.bytes_per_sample](RIFF.WAVE.Chunks.FMT.wChannels);
 
     Global.Channels = RIFF.WAVE.Chunks.FMT.wChannels;
     Global.sample_rate = RIFF.WAVE.Chunks.FMT.nSamplesPerSec;
@@ -2103,7 +3238,7 @@ bool openWavIO()
 
     if (!RIFF.WAVE.File.Type.RIFF64)
     {
-        Global.Total_Samples = uint64_t((1.0 * RIFF.WAVE.Chunks.DATA.Header.Size) / Global.Channels / Global.bytes_per_sample);
+        Global.Total_Samples = uint64_t((1.0 * RIFF.WAVE.Chunks.DATA.Header.Size) / Global.Channels / RIFF.WAVE.wBytesPerSample);
 
         Global.WAVE_size = RIFF.WAVE.Chunks.WAV.Header.Size;
 
@@ -2188,12 +3323,12 @@ bool openWavIO()
             if (RIFF.WAVE.File.Type.WAVE64)
             {
                 RIFF.WAVE.sampleByteLeftToRead = RIFF.WAVE.Chunks.DATA.Header.Size - 0x18;
-                RIFF.WAVE.samplesLeftToRead = RIFF.WAVE.sampleByteLeftToRead / (Global.Channels * Global.bytes_per_sample);
+                RIFF.WAVE.samplesLeftToRead = RIFF.WAVE.sampleByteLeftToRead / (Global.Channels * RIFF.WAVE.wBytesPerSample);
             }
             else
             {
                 RIFF.WAVE.sampleByteLeftToRead = RIFF.WAVE.Chunks.DATA.Header.Size;
-                RIFF.WAVE.samplesLeftToRead = RIFF.WAVE.sampleByteLeftToRead / (Global.Channels * Global.bytes_per_sample);
+                RIFF.WAVE.samplesLeftToRead = RIFF.WAVE.sampleByteLeftToRead / (Global.Channels * RIFF.WAVE.wBytesPerSample);
 
                 if ((RIFF.WAVE.sampleByteLeftToRead == MAX_uint32_t) || (RIFF.WAVE.Chunks.WAV.Header.Size == MAX_uint32_t))
                 {
@@ -2210,45 +3345,54 @@ bool openWavIO()
         }
     }
 
-    if (parameters.output.detail)
-    {
-        if (Global.Codec_Block.Total <= 0x10000000)
-        {
-            bit_removal_history = new (std::nothrow) uint8_t [(Global.Codec_Block.Total + 0x0F) & 0xFFFFFFF0];
-
-            if (bit_removal_history == nullptr)
-            {
-                parameters.output.detail = false;
-                lossyWAVWarning("Not enough memory to retain bit-removal history.");
-            }
-        }
-        else
-        {
-            lossyWAVWarning("File too large to retain bit-removal history.");
-            parameters.output.detail = false;
-        }
-    }
-
-    nrOfByteInOneBlockInBuff = Global.bytes_per_sample * Global.Channels * Global.Codec_Block.Size;
+    nrOfByteInOneBlockInBuff = RIFF.WAVE.wBytesPerSample * Global.Channels * Global.Codec_Block.Size;
 
 
     //========================================================================
-    // Define how many codec-blocks of data to buffer.
+    // Define how many codec-blocks of data to buffer. Unless the input is
+    // mapped, it is read ahead on a helper thread in blocks of BUFFER_SIZEread
+    // (--read-buffer 0 reads synchronously instead). Reads larger than
+    // BUFFER_SIZE are only possible when they are never copied into Buffer.
     //========================================================================
-    if (parameters.STDINPUT)
-        nrOfBlocksInReadBuff = 1;
+    if (parameters.read_buffer > 0)
+        readbufferbytes = uint64_t(parameters.read_buffer) << 10;
+    else if (parameters.STDINPUT)
+        readbufferbytes = nrOfByteInOneBlockInBuff;
     else
-        nrOfBlocksInReadBuff = (BUFFER_SIZE / nrOfByteInOneBlockInBuff);
+        readbufferbytes = BUFFER_SIZE;
 
     if (parameters.STDOUTPUT)
         nrOfBlocksInWriteBuff = 1;
     else
         nrOfBlocksInWriteBuff = (BUFFER_SIZE / nrOfByteInOneBlockInBuff);
-    //========================================================================
+
+    nrOfBlocksInReadBuff = std::max(uint64_t(1), readbufferbytes / nrOfByteInOneBlockInBuff);
 
     BUFFER_SIZEread = nrOfByteInOneBlockInBuff * nrOfBlocksInReadBuff;
     BUFFER_SIZEwrite = nrOfByteInOneBlockInBuff * nrOfBlocksInWriteBuff;
 
+    if (!RIFF.WAVE.IO->Is_Mapped())
+    {
+        tIO_Backend* readahead = nullptr;
+
+        if (parameters.read_buffer != 0)
+        {
+            readahead = nIO_Read_Ahead(RIFF.WAVE.IO, RIFF.WAVE.Owns_IO, BUFFER_SIZEread);
+        }
+
+        if (readahead != nullptr)
+        {
+            RIFF.WAVE.IO = readahead;
+            RIFF.WAVE.Owns_IO = true;
+        }
+        else if (BUFFER_SIZEread > BUFFER_SIZE)
+        {
+            nrOfBlocksInReadBuff = std::max(uint64_t(1), BUFFER_SIZE / nrOfByteInOneBlockInBuff);
+            BUFFER_SIZEread = nrOfByteInOneBlockInBuff * nrOfBlocksInReadBuff;
+        }
+    }
+    //========================================================================
+
     //========================================================================
     // If checking then output relevant message and exit, else error if FACT.
     //========================================================================
@@ -2306,9 +3450,18 @@ bool openWavIO()
     }
     //========================================================================
 
+    if (RIFF.WAVE.IEEE_Float)
+    {
+        Convert_Chunks_To_Integer_PCM(RIFF.WAVE.Chunks);
+    }
+
     RIFF.WAVE.firstsamplesread = std::min(RIFF.WAVE.sampleByteLeftToRead, BUFFER_SIZEread);
 
-    if (RIFF.WAVE.File.Read(RIFF.WAVE, &RIFF.WAVE.Buffer, RIFF.WAVE.firstsamplesread) < RIFF.WAVE.firstsamplesread)
+    RIFF.WAVE.pSamples = ReadSampleBytes(RIFF.WAVE, RIFF.WAVE.firstsamplesread);
+
+    // Only an error if the 'data' size said there was more; a stream of
+    // unknown length may well be shorter than the read buffer.
+    if ((RIFF.WAVE.File.Last.Read < RIFF.WAVE.firstsamplesread) && (RIFF.WAVE.sampleByteLeftToRead != MAX_uint64_t))
     {
         return false;
     }
@@ -2326,45 +3479,58 @@ bool openWavIO()
 
     RIFF.BTRD.Chunks = RIFF.WAVE.Chunks;
     RIFF.BTRD.wBytesPerSample = (RIFF.BTRD.Chunks.FMT.wBitsPerSample + 7) >> 3;
-    RIFF.BTRD.ReadTransfer  = ReadTransferprocs[RIFF.BTRD.wBytesPerSample];
-    RIFF.BTRD.WriteTransfer = WriteTransferProcs[RIFF.BTRD.wBytesPerSample];
+    RIFF.BTRD.ReadTransfer  = ReadTransferprocs[RIFF.BTRD.wBytesPerSample](RIFF.BTRD.Chunks.FMT.wChannels);
+    RIFF.BTRD.WriteTransfer = WriteTransferProcs[RIFF.BTRD.wBytesPerSample](RIFF.BTRD.Chunks.FMT.wChannels);
     RIFF.BTRD.BytesInBuffer = 0;
 
     RIFF.CORR.Chunks = RIFF.WAVE.Chunks;
     RIFF.CORR.wBytesPerSample = (RIFF.CORR.Chunks.FMT.wBitsPerSample + 7) >> 3;
-    RIFF.CORR.ReadTransfer  = ReadTransferprocs[RIFF.CORR.wBytesPerSample];
-    RIFF.CORR.WriteTransfer = WriteTransferProcs[RIFF.CORR.wBytesPerSample];
+    RIFF.CORR.ReadTransfer  = ReadTransferprocs[RIFF.CORR.wBytesPerSample](RIFF.CORR.Chunks.FMT.wChannels);
+    RIFF.CORR.WriteTransfer = WriteTransferProcs[RIFF.CORR.wBytesPerSample](RIFF.CORR.Chunks.FMT.wChannels);
+    RIFF.WriteTransfer_Pair = WriteTransferPairProcs[RIFF.CORR.wBytesPerSample](RIFF.CORR.Chunks.FMT.wChannels);
+    RIFF.CORR_Transferred   = false;
     RIFF.CORR.BytesInBuffer = 0;
 
-    if (parameters.STDOUTPUT)
+    if (Supplied_IO.Lossy != nullptr)
+    {
+        nAttachIO(RIFF.BTRD, Supplied_IO.Lossy, false, true);
+    }
+    else if (parameters.STDOUTPUT)
     {
         #ifdef _WIN32
         _setmode(STDOUT_FILENO, _O_BINARY);
         #endif
 
-        RIFF.BTRD.File.Write = writeto_stdout;
-        RIFF.BTRD.File.Is.Pipe = true;
-        RIFF.BTRD.File.Is.File = false;
-        RIFF.BTRD.File.Is.Open = true;
+        nAttachIO(RIFF.BTRD, nIO_Open_Stdout(), true, true);
     }
     else
         if (!nOpenFile(RIFF.BTRD, parameters.WavOutDir + parameters.lossyName, 2))
             return false;
 
+    nWriteBehind(RIFF.BTRD);
+
     RIFF.BTRD.File.Type = RIFF.WAVE.File.Type;
     if (!WriteChunksUpToData(RIFF.BTRD))
         lossyWAVError("Writing to output file.", 0x12);
 
+    nReserveSampleBytes(RIFF.BTRD);
 
-    if ((!parameters.STDOUTPUT) && (parameters.correction))
+
+    if ((parameters.correction) && ((Supplied_IO.Correction != nullptr) || (!parameters.STDOUTPUT)))
     {
-        if (!nOpenFile(RIFF.CORR, parameters.WavOutDir + parameters.lwcdfName, 2))
+        if (Supplied_IO.Correction != nullptr)
+            nAttachIO(RIFF.CORR, Supplied_IO.Correction, false, true);
+        else if (!nOpenFile(RIFF.CORR, parameters.WavOutDir + parameters.lwcdfName, 2))
             return false;
 
+        nWriteBehind(RIFF.CORR);
+
         RIFF.CORR.File.Type = RIFF.WAVE.File.Type;
 
         if (!WriteChunksUpToData(RIFF.CORR))
             lossyWAVError("Writing to output file.", 0x12);
+
+        nReserveSampleBytes(RIFF.CORR);
     }
 
     RIFF.WAVE.ID = 0;
@@ -2375,6 +3541,14 @@ bool openWavIO()
 }
 
 
+void nWAV_Set_IO(tIO_Backend* input, tIO_Backend* lossy, tIO_Backend* correction)
+{
+    Supplied_IO.Input = input;
+    Supplied_IO.Lossy = lossy;
+    Supplied_IO.Correction = correction;
+}
+
+
 void nWAV_Init()
 {
     RIFF.ChunkDATA = new (std::nothrow) uint8_t[ChunkDATA_array_size];
@@ -2388,6 +3562,10 @@ void nWAV_Init()
 
 void nWAV_Cleanup()
 {
+    nCloseFile(RIFF.WAVE);
+    nCloseFile(RIFF.BTRD);
+    nCloseFile(RIFF.CORR);
+
     if (RIFF.ChunkDATA != nullptr)
     {
         delete[] RIFF.ChunkDATA;
@@ -28,8 +28,15 @@
 #ifndef nWav_H_
 #define nWav_H_
 
+class tIO_Backend;
+
 void nWAV_Init();
 
+void nWAV_Set_IO(tIO_Backend* input, tIO_Backend* lossy, tIO_Backend* correction);
+                                   // Use these backends instead of opening files / stdin / stdout
+                                   // with the next openWavIO. nullptr keeps the default for that
+                                   // file. Ownership stays with the caller.
+
 void nWAV_Cleanup();
 
 void MergeFiles();                 // Merge lossy.wav and lwcdf.wav files.